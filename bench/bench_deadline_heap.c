@@ -0,0 +1,218 @@
+/*
+* File name: bench_deadline_heap.c
+* Description: Push/pop throughput of the deadline heap, which stores
+*              {deadline, task} slots inline, against the generic heap_pq
+*              of task pointers with a compare callback. Both keep the
+*              task's queue index up to date, as the scheduler needs.
+*              Measures pushing every task then popping every task, and
+*              the scheduler's tick pattern: pop the earliest, push it back
+*              a random interval later. The deadline heap's arity is a build
+*              setting: build with -DDEADLINE_HEAP_ARITY=4 or 8 to compare.
+*              Usage: bench_deadline_heap.out [num_of_tasks] [num_of_rounds]
+*/
+
+#include <stdio.h>          /* printf */
+#include <stdlib.h>         /* malloc, free, rand, strtoul */
+
+#include "deadline_heap.h"
+#include "heap.h"           /* HEAP_BINARY */
+#include "heap_p_queue.h"
+#include "mono_clock.h"
+#include "task.h"
+
+#define NUM_OF_TASKS (1000000)
+#define NUM_OF_ROUNDS (1000000)
+#define DEADLINE_RANGE (60 * MONO_USEC_PER_SEC)
+#define NSEC_PER_USEC (1000)
+
+typedef struct result
+{
+    double fill_ns;             /* per push, pushing every task */
+    double drain_ns;            /* per pop, popping every task */
+    double tick_ns;             /* per pop + push */
+} result_t;
+
+static int CompareDeadlines(const void* data, const void* param);
+static void SetIndex(void* data, size_t index);
+static mono_time_t RandomDeadline(void);
+static void SetDeadlines(task_t** tasks, size_t num_of_tasks);
+static result_t RunGeneric(task_t** tasks, size_t num_of_tasks,
+                            size_t num_of_rounds);
+static result_t RunDeadline(task_t** tasks, size_t num_of_tasks,
+                            size_t num_of_rounds);
+static void PrintResult(const char* name, result_t result);
+static int Noop(void* params);
+
+int main(int argc, char* argv[])
+{
+    size_t i = 0;
+    size_t num_of_tasks = (argc > 1) ? strtoul(argv[1], NULL, 10) :
+                                        NUM_OF_TASKS;
+    size_t num_of_rounds = (argc > 2) ? strtoul(argv[2], NULL, 10) :
+                                        NUM_OF_ROUNDS;
+    task_t** tasks = (task_t**)malloc(num_of_tasks * sizeof(task_t*));
+
+    if ((NULL == tasks) || (0 == num_of_tasks))
+    {
+        free(tasks);
+        return 1;
+    }
+
+    for (i = 0; i < num_of_tasks; ++i)
+    {
+        tasks[i] = TaskCreate(Noop, NULL, 1);
+
+        if (NULL == tasks[i])
+        {
+            printf("allocation failed\n");
+            return 1;
+        }
+    }
+
+    printf("%lu tasks, %lu rounds\n", (unsigned long)num_of_tasks,
+            (unsigned long)num_of_rounds);
+    PrintResult("heap_pq", RunGeneric(tasks, num_of_tasks, num_of_rounds));
+    PrintResult("deadline_heap", RunDeadline(tasks, num_of_tasks,
+                                                num_of_rounds));
+
+    for (i = 0; i < num_of_tasks; ++i)
+    {
+        TaskDestroy(tasks[i]);
+    }
+
+    free(tasks);
+
+    return 0;
+}
+
+/* the order the scheduler used with heap_pq: earliest deadline first */
+static int CompareDeadlines(const void* data, const void* param)
+{
+    mono_time_t lhs = TaskGetScheduledTime((const task_t*)data);
+    mono_time_t rhs = TaskGetScheduledTime((const task_t*)param);
+
+    return (lhs > rhs) - (lhs < rhs);
+}
+
+static void SetIndex(void* data, size_t index)
+{
+    TaskSetQueueIndex((task_t*)data, index);
+}
+
+static mono_time_t RandomDeadline(void)
+{
+    return ((mono_time_t)rand() * RAND_MAX + (mono_time_t)rand()) %
+            DEADLINE_RANGE;
+}
+
+/* the same deadlines for both heaps */
+static void SetDeadlines(task_t** tasks, size_t num_of_tasks)
+{
+    size_t i = 0;
+
+    srand(1);
+
+    for (i = 0; i < num_of_tasks; ++i)
+    {
+        TaskSetScheduledTime(tasks[i], RandomDeadline());
+    }
+}
+
+static result_t RunGeneric(task_t** tasks, size_t num_of_tasks,
+                            size_t num_of_rounds)
+{
+    size_t i = 0;
+    result_t result;
+    mono_time_t start = 0;
+    heap_pq_t* pq = HeapPQCreate(CompareDeadlines, SetIndex, HEAP_BINARY);
+
+    SetDeadlines(tasks, num_of_tasks);
+
+    start = MonoClockNow();
+    for (i = 0; i < num_of_tasks; ++i)
+    {
+        HeapPQEnqueue(pq, tasks[i]);
+    }
+    result.fill_ns = (double)(MonoClockNow() - start) * NSEC_PER_USEC /
+                        num_of_tasks;
+
+    start = MonoClockNow();
+    for (i = 0; i < num_of_rounds; ++i)
+    {
+        task_t* task = (task_t*)HeapPQDequeue(pq);
+
+        TaskSetScheduledTime(task, TaskGetScheduledTime(task) +
+                                    RandomDeadline() / 64);
+        HeapPQEnqueue(pq, task);
+    }
+    result.tick_ns = (double)(MonoClockNow() - start) * NSEC_PER_USEC /
+                        (num_of_rounds ? num_of_rounds : 1);
+
+    start = MonoClockNow();
+    for (i = 0; i < num_of_tasks; ++i)
+    {
+        HeapPQDequeue(pq);
+    }
+    result.drain_ns = (double)(MonoClockNow() - start) * NSEC_PER_USEC /
+                        num_of_tasks;
+
+    HeapPQDestroy(pq);
+
+    return result;
+}
+
+static result_t RunDeadline(task_t** tasks, size_t num_of_tasks,
+                            size_t num_of_rounds)
+{
+    size_t i = 0;
+    result_t result;
+    mono_time_t start = 0;
+    deadline_heap_t* heap = DeadlineHeapCreate(0);
+
+    SetDeadlines(tasks, num_of_tasks);
+
+    start = MonoClockNow();
+    for (i = 0; i < num_of_tasks; ++i)
+    {
+        DeadlineHeapPush(heap, tasks[i]);
+    }
+    result.fill_ns = (double)(MonoClockNow() - start) * NSEC_PER_USEC /
+                        num_of_tasks;
+
+    start = MonoClockNow();
+    for (i = 0; i < num_of_rounds; ++i)
+    {
+        task_t* task = DeadlineHeapPop(heap);
+
+        TaskSetScheduledTime(task, TaskGetScheduledTime(task) +
+                                    RandomDeadline() / 64);
+        DeadlineHeapPush(heap, task);
+    }
+    result.tick_ns = (double)(MonoClockNow() - start) * NSEC_PER_USEC /
+                        (num_of_rounds ? num_of_rounds : 1);
+
+    start = MonoClockNow();
+    for (i = 0; i < num_of_tasks; ++i)
+    {
+        DeadlineHeapPop(heap);
+    }
+    result.drain_ns = (double)(MonoClockNow() - start) * NSEC_PER_USEC /
+                        num_of_tasks;
+
+    DeadlineHeapDestroy(heap);
+
+    return result;
+}
+
+static void PrintResult(const char* name, result_t result)
+{
+    printf("%-14s push %7.1f ns   pop %7.1f ns   pop + push %7.1f ns\n",
+            name, result.fill_ns, result.drain_ns, result.tick_ns);
+}
+
+static int Noop(void* params)
+{
+    (void)params;
+
+    return 0;
+}
@@ -0,0 +1,223 @@
+/*
+* File name: bench_dvector.c
+* Description: Push/pop oscillation benchmark for the dvector. A round
+*              pushes up to a high mark and pops back down to a low mark;
+*              every change of the capacity is one realloc. The dvector is
+*              compared with a minimal vector that keeps the policy it used
+*              to have: grow to twice the capacity plus one, and realloc
+*              down to exactly the size as soon as the size falls under a
+*              quarter of the capacity.
+*              Usage: bench_dvector.out [num_of_rounds]
+*/
+
+#include <stdio.h>          /* printf */
+#include <stdlib.h>         /* realloc, free, strtoul */
+
+#include "dvector.h"
+#include "mono_clock.h"
+
+#define NUM_OF_ROUNDS (1000)
+#define NUM_OF_CASES (3)
+#define OLD_GROWTH_FACTOR (2)
+#define OLD_SHRINK_DIVISOR (4)
+
+typedef struct bench_case
+{
+    size_t high;
+    size_t low;
+} bench_case_t;
+
+/* the policy DvectorPushBack/DvectorPopBack had before */
+typedef struct old_vector
+{
+    size_t* array;
+    size_t size;
+    size_t capacity;
+    size_t num_of_reallocs;
+} old_vector_t;
+
+typedef struct result
+{
+    double reallocs_per_round;
+    double us_per_round;
+} result_t;
+
+static result_t Run(bench_case_t bench_case, size_t num_of_rounds);
+static result_t RunOld(bench_case_t bench_case, size_t num_of_rounds);
+static size_t Push(dvector_t* vector, size_t count, size_t* capacity);
+static size_t Pop(dvector_t* vector, size_t count, size_t* capacity);
+static void OldPush(old_vector_t* vector, size_t count);
+static void OldPop(old_vector_t* vector, size_t count);
+static void OldResize(old_vector_t* vector, size_t capacity);
+
+int main(int argc, char* argv[])
+{
+    size_t i = 0;
+    size_t num_of_rounds = (argc > 1) ? strtoul(argv[1], NULL, 10) :
+                                        NUM_OF_ROUNDS;
+    /* the last case is a small queue that fills and drains */
+    const bench_case_t cases[NUM_OF_CASES] =
+    {
+        { 4096, 1000 }, { 100000, 20000 }, { 64, 4 }
+    };
+
+    if (0 == num_of_rounds)
+    {
+        return 1;
+    }
+
+    printf("%lu rounds\n", (unsigned long)num_of_rounds);
+
+    for (i = 0; i < NUM_OF_CASES; ++i)
+    {
+        result_t old = RunOld(cases[i], num_of_rounds);
+        result_t amortized = Run(cases[i], num_of_rounds);
+
+        /* the old vector has no per-element call, only reallocs compare */
+        printf("%6lu <-> %-6lu  old %5.2f reallocs   dvector %5.2f reallocs"
+                " %9.1f us  per round\n",
+                (unsigned long)cases[i].high, (unsigned long)cases[i].low,
+                old.reallocs_per_round, amortized.reallocs_per_round,
+                amortized.us_per_round);
+    }
+
+    return 0;
+}
+
+static size_t Push(dvector_t* vector, size_t count, size_t* capacity)
+{
+    size_t i = 0;
+    size_t num_of_reallocs = 0;
+
+    for (i = 0; i < count; ++i)
+    {
+        DvectorPushBack(vector, &i);
+
+        if (DvectorCapacity(vector) != *capacity)
+        {
+            *capacity = DvectorCapacity(vector);
+            ++num_of_reallocs;
+        }
+    }
+
+    return num_of_reallocs;
+}
+
+static size_t Pop(dvector_t* vector, size_t count, size_t* capacity)
+{
+    size_t i = 0;
+    size_t num_of_reallocs = 0;
+
+    for (i = 0; i < count; ++i)
+    {
+        DvectorPopBack(vector);
+
+        if (DvectorCapacity(vector) != *capacity)
+        {
+            *capacity = DvectorCapacity(vector);
+            ++num_of_reallocs;
+        }
+    }
+
+    return num_of_reallocs;
+}
+
+static result_t Run(bench_case_t bench_case, size_t num_of_rounds)
+{
+    size_t i = 0;
+    size_t num_of_reallocs = 0;
+    size_t capacity = 0;
+    mono_time_t start = 0;
+    result_t result;
+    dvector_t* vector = DvectorCreate(1, sizeof(size_t));
+
+    capacity = DvectorCapacity(vector);
+    Push(vector, bench_case.low, &capacity);
+
+    start = MonoClockNow();
+    for (i = 0; i < num_of_rounds; ++i)
+    {
+        num_of_reallocs += Push(vector, bench_case.high - bench_case.low,
+                                &capacity);
+        num_of_reallocs += Pop(vector, bench_case.high - bench_case.low,
+                                &capacity);
+    }
+
+    result.us_per_round = (double)(MonoClockNow() - start) /
+                            (double)num_of_rounds;
+    result.reallocs_per_round = (double)num_of_reallocs /
+                                (double)num_of_rounds;
+
+    DvectorDestroy(vector);
+
+    return result;
+}
+
+static void OldResize(old_vector_t* vector, size_t capacity)
+{
+    size_t* array = (size_t*)realloc(vector->array,
+                                        capacity * sizeof(size_t));
+
+    if (NULL != array)
+    {
+        vector->array = array;
+        vector->capacity = capacity;
+        ++(vector->num_of_reallocs);
+    }
+}
+
+static void OldPush(old_vector_t* vector, size_t count)
+{
+    size_t i = 0;
+
+    for (i = 0; i < count; ++i)
+    {
+        if (vector->size == vector->capacity)
+        {
+            OldResize(vector, vector->capacity * OLD_GROWTH_FACTOR + 1);
+        }
+
+        vector->array[(vector->size)++] = i;
+    }
+}
+
+static void OldPop(old_vector_t* vector, size_t count)
+{
+    size_t i = 0;
+
+    for (i = 0; i < count; ++i)
+    {
+        --(vector->size);
+
+        if ((vector->size < vector->capacity / OLD_SHRINK_DIVISOR) &&
+            (vector->capacity > OLD_SHRINK_DIVISOR))
+        {
+            OldResize(vector, vector->size);
+        }
+    }
+}
+
+static result_t RunOld(bench_case_t bench_case, size_t num_of_rounds)
+{
+    size_t i = 0;
+    result_t result;
+    old_vector_t vector = { NULL, 0, 0, 0 };
+
+    OldResize(&vector, 1);
+    OldPush(&vector, bench_case.low);
+    vector.num_of_reallocs = 0;
+
+    for (i = 0; i < num_of_rounds; ++i)
+    {
+        OldPush(&vector, bench_case.high - bench_case.low);
+        OldPop(&vector, bench_case.high - bench_case.low);
+    }
+
+    result.us_per_round = 0;
+    result.reallocs_per_round = (double)vector.num_of_reallocs /
+                                (double)num_of_rounds;
+
+    free(vector.array);
+
+    return result;
+}
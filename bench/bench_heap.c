@@ -0,0 +1,182 @@
+/*
+* File name: bench_heap.c
+* Description: Comparisons, slot writes and time per operation of the
+*              generic heap, in the scheduler's pattern: fill the heap, then
+*              pop the earliest element and push it back with a later key,
+*              then drain it. Slot writes are counted through the set_index
+*              callback, which the heap calls for every slot it writes.
+*              Runs binary, 4-ary and 8-ary heaps for each size, by default
+*              1K, 100K and 10M elements.
+*              Usage: bench_heap.out [num_of_rounds] [num_of_elements ...]
+*/
+
+#include <stdio.h>          /* printf */
+#include <stdlib.h>         /* malloc, free, rand, strtoul */
+
+#include "heap.h"
+#include "mono_clock.h"
+
+#define NUM_OF_ROUNDS (1000000)
+#define NUM_OF_ARITIES (3)
+#define NUM_OF_DEFAULT_SIZES (3)
+#define KEY_RANGE (60000000)
+#define NSEC_PER_USEC (1000)
+
+typedef struct element
+{
+    uint64_t key;
+    size_t index;
+} element_t;
+
+typedef struct counters
+{
+    size_t num_of_compares;
+    size_t num_of_writes;
+} counters_t;
+
+static int Compare(const void* data, const void* param);
+static void SetIndex(void* data, size_t index);
+static uint64_t RandomKey(void);
+static void PrintPhase(const char* name, counters_t before, mono_time_t start,
+                        size_t num_of_ops);
+static int RunHeap(size_t arity, element_t* elements, size_t num_of_elements,
+                    size_t num_of_rounds);
+static int RunSize(size_t num_of_elements, size_t num_of_rounds);
+
+static counters_t g_counters;
+
+int main(int argc, char* argv[])
+{
+    int i = 0;
+    int result = 0;
+    size_t num_of_rounds = (argc > 1) ? strtoul(argv[1], NULL, 10) :
+                                        NUM_OF_ROUNDS;
+    const size_t default_sizes[NUM_OF_DEFAULT_SIZES] = { 1000, 100000,
+                                                        10000000 };
+
+    if (argc > 2)
+    {
+        for (i = 2; i < argc; ++i)
+        {
+            result |= RunSize(strtoul(argv[i], NULL, 10), num_of_rounds);
+        }
+    }
+    else
+    {
+        for (i = 0; i < NUM_OF_DEFAULT_SIZES; ++i)
+        {
+            result |= RunSize(default_sizes[i], num_of_rounds);
+        }
+    }
+
+    return result;
+}
+
+static int RunSize(size_t num_of_elements, size_t num_of_rounds)
+{
+    size_t i = 0;
+    int result = 0;
+    const size_t arities[NUM_OF_ARITIES] = { HEAP_BINARY, HEAP_4_ARY,
+                                            HEAP_8_ARY };
+    element_t* elements = (element_t*)malloc(num_of_elements *
+                                                sizeof(element_t));
+
+    if ((NULL == elements) || (0 == num_of_elements))
+    {
+        free(elements);
+        return 1;
+    }
+
+    for (i = 0; i < NUM_OF_ARITIES; ++i)
+    {
+        printf("%lu-ary, %lu elements, %lu rounds\n", (unsigned long)arities[i],
+                (unsigned long)num_of_elements, (unsigned long)num_of_rounds);
+        result |= RunHeap(arities[i], elements, num_of_elements,
+                            num_of_rounds);
+    }
+
+    free(elements);
+
+    return result;
+}
+
+static int Compare(const void* data, const void* param)
+{
+    uint64_t lhs = ((const element_t*)data)->key;
+    uint64_t rhs = ((const element_t*)param)->key;
+
+    ++g_counters.num_of_compares;
+
+    return (lhs > rhs) - (lhs < rhs);
+}
+
+static void SetIndex(void* data, size_t index)
+{
+    ++g_counters.num_of_writes;
+    ((element_t*)data)->index = index;
+}
+
+static uint64_t RandomKey(void)
+{
+    return ((uint64_t)rand() * RAND_MAX + (uint64_t)rand()) % KEY_RANGE;
+}
+
+static void PrintPhase(const char* name, counters_t before, mono_time_t start,
+                        size_t num_of_ops)
+{
+    double ops = (double)(num_of_ops ? num_of_ops : 1);
+
+    printf("  %-10s %7.2f compares  %7.2f writes  %8.1f ns  per op\n", name,
+            (double)(g_counters.num_of_compares - before.num_of_compares) / ops,
+            (double)(g_counters.num_of_writes - before.num_of_writes) / ops,
+            (double)(MonoClockNow() - start) * NSEC_PER_USEC / ops);
+}
+
+static int RunHeap(size_t arity, element_t* elements, size_t num_of_elements,
+                    size_t num_of_rounds)
+{
+    size_t i = 0;
+    counters_t before;
+    mono_time_t start = 0;
+    heap_t* heap = HeapCreate(Compare, SetIndex, arity);
+
+    if (NULL == heap)
+    {
+        return 1;
+    }
+
+    srand(1);
+
+    before = g_counters;
+    start = MonoClockNow();
+    for (i = 0; i < num_of_elements; ++i)
+    {
+        elements[i].key = RandomKey();
+        HeapPush(heap, &elements[i]);
+    }
+    PrintPhase("push", before, start, num_of_elements);
+
+    before = g_counters;
+    start = MonoClockNow();
+    for (i = 0; i < num_of_rounds; ++i)
+    {
+        element_t* element = (element_t*)HeapPeek(heap);
+
+        HeapPop(heap);
+        element->key += RandomKey() / 64;
+        HeapPush(heap, element);
+    }
+    PrintPhase("pop + push", before, start, num_of_rounds);
+
+    before = g_counters;
+    start = MonoClockNow();
+    for (i = 0; i < num_of_elements; ++i)
+    {
+        HeapPop(heap);
+    }
+    PrintPhase("pop", before, start, num_of_elements);
+
+    HeapDestroy(heap);
+
+    return 0;
+}
@@ -0,0 +1,200 @@
+/*
+* File name: bench_sharded.c
+* Description: Scaling of the sharded scheduler from 1 shard to a given
+*              number of shards (powers of two). For each count, a set of
+*              periodic tasks runs while producer threads add and remove
+*              tasks through the front end, then the task runs per second
+*              and the add + remove pairs per second are printed. Shards
+*              beyond the number of CPUs share cores, so only measure
+*              scaling up to the CPU count of the host.
+*              Usage: bench_sharded.out [max_shards] [num_of_tasks]
+*                                       [num_of_producers] [duration_ms]
+*/
+
+#define _POSIX_C_SOURCE (200809L)
+
+#include <pthread.h>        /* pthread_create, pthread_join */
+#include <stdatomic.h>      /* atomic_int */
+#include <stdio.h>          /* printf */
+#include <stdlib.h>         /* calloc, free, strtoul */
+
+#include "sharded_scheduler.h"
+#include "mono_clock.h"
+
+#define MAX_SHARDS (8)
+#define NUM_OF_TASKS (1024)
+#define NUM_OF_PRODUCERS (4)
+#define MAX_PRODUCERS (64)
+#define DURATION_MS (1000)
+#define TASK_INTERVAL_US (MONO_USEC_PER_MSEC)
+
+typedef struct producer
+{
+    sharded_scheduler_t* sharded;
+    size_t num_of_pairs;
+} producer_t;
+
+typedef struct result
+{
+    double runs_per_sec;
+    double pairs_per_sec;
+} result_t;
+
+static int CountRun(void* params);
+static int Noop(void* params);
+static void* Produce(void* params);
+static int RunShards(size_t num_of_shards, size_t num_of_tasks,
+                        size_t num_of_producers, mono_time_t duration_us,
+                        result_t* result);
+
+static atomic_int g_is_done;
+
+int main(int argc, char* argv[])
+{
+    size_t num_of_shards = 0;
+    size_t max_shards = (argc > 1) ? strtoul(argv[1], NULL, 10) : MAX_SHARDS;
+    size_t num_of_tasks = (argc > 2) ? strtoul(argv[2], NULL, 10) :
+                                        NUM_OF_TASKS;
+    size_t num_of_producers = (argc > 3) ? strtoul(argv[3], NULL, 10) :
+                                            NUM_OF_PRODUCERS;
+    mono_time_t duration_us = ((argc > 4) ? strtoul(argv[4], NULL, 10) :
+                                DURATION_MS) * (mono_time_t)MONO_USEC_PER_MSEC;
+    result_t result;
+
+    if ((0 == max_shards) || (0 == duration_us) ||
+        (num_of_producers > MAX_PRODUCERS))
+    {
+        printf("1 or more shards, 0 to %d producers\n", MAX_PRODUCERS);
+        return 1;
+    }
+
+    printf("%lu tasks every %d us, %lu producers, %lu ms\n",
+            (unsigned long)num_of_tasks, TASK_INTERVAL_US,
+            (unsigned long)num_of_producers,
+            (unsigned long)(duration_us / MONO_USEC_PER_MSEC));
+
+    for (num_of_shards = 1; num_of_shards <= max_shards; num_of_shards *= 2)
+    {
+        if (0 != RunShards(num_of_shards, num_of_tasks, num_of_producers,
+                            duration_us, &result))
+        {
+            printf("shards %2lu: failed\n", (unsigned long)num_of_shards);
+            return 1;
+        }
+
+        printf("shards %2lu: %6.2f M runs/s   %6.2f M add + remove pairs/s\n",
+                (unsigned long)num_of_shards, result.runs_per_sec / 1e6,
+                result.pairs_per_sec / 1e6);
+    }
+
+    return 0;
+}
+
+/* one counter per task, a task has at most one run at a time */
+static int CountRun(void* params)
+{
+    ++*(size_t*)params;
+
+    return 0;
+}
+
+static int Noop(void* params)
+{
+    (void)params;
+
+    return 0;
+}
+
+static void* Produce(void* params)
+{
+    producer_t* producer = (producer_t*)params;
+
+    while (!atomic_load(&g_is_done))
+    {
+        uid_t uid = ShardedSchedulerAdd(producer->sharded, Noop, NULL,
+                                        MONO_USEC_PER_SEC);
+
+        ShardedSchedulerRemove(producer->sharded, uid);
+        ++producer->num_of_pairs;
+    }
+
+    return NULL;
+}
+
+static int RunShards(size_t num_of_shards, size_t num_of_tasks,
+                        size_t num_of_producers, mono_time_t duration_us,
+                        result_t* result)
+{
+    size_t i = 0;
+    size_t num_of_runs = 0;
+    size_t num_of_pairs = 0;
+    mono_time_t start = 0;
+    mono_time_t elapsed = 0;
+    pthread_t threads[MAX_PRODUCERS];
+    producer_t producers[MAX_PRODUCERS];
+    /* one spare, so no tasks isn't an allocation failure */
+    size_t* counts = (size_t*)calloc(num_of_tasks + 1, sizeof(size_t));
+    sharded_scheduler_t* sharded = ShardedSchedulerCreate(num_of_shards,
+                                                        SCHED_BACKEND_HEAP);
+
+    if ((NULL == counts) || (NULL == sharded))
+    {
+        free(counts);
+        ShardedSchedulerDestroy(sharded);
+        return 1;
+    }
+
+    for (i = 0; i < num_of_tasks; ++i)
+    {
+        ShardedSchedulerAdd(sharded, CountRun, &counts[i], TASK_INTERVAL_US);
+    }
+
+    atomic_store(&g_is_done, 0);
+    start = MonoClockNow();
+
+    if (0 != ShardedSchedulerStart(sharded))
+    {
+        free(counts);
+        ShardedSchedulerDestroy(sharded);
+        return 1;
+    }
+
+    for (i = 0; i < num_of_producers; ++i)
+    {
+        producers[i].sharded = sharded;
+        producers[i].num_of_pairs = 0;
+
+        if (0 != pthread_create(&threads[i], NULL, Produce, &producers[i]))
+        {
+            num_of_producers = i;
+            break;
+        }
+    }
+
+    MonoClockSleepUntil(start + duration_us);
+    atomic_store(&g_is_done, 1);
+
+    for (i = 0; i < num_of_producers; ++i)
+    {
+        pthread_join(threads[i], NULL);
+        num_of_pairs += producers[i].num_of_pairs;
+    }
+
+    ShardedSchedulerStop(sharded);
+    elapsed = MonoClockNow() - start;
+
+    for (i = 0; i < num_of_tasks; ++i)
+    {
+        num_of_runs += counts[i];
+    }
+
+    result->runs_per_sec = (double)num_of_runs * MONO_USEC_PER_SEC /
+                            (double)elapsed;
+    result->pairs_per_sec = (double)num_of_pairs * MONO_USEC_PER_SEC /
+                            (double)elapsed;
+
+    ShardedSchedulerDestroy(sharded);
+    free(counts);
+
+    return 0;
+}
@@ -0,0 +1,136 @@
+/*
+* File name: bench_spawn.c
+* Description: Cost of starting a process with fork + exec against
+*              posix_spawn, as the process grows. For each size, that many
+*              MiB are allocated and touched, then /bin/true is started and
+*              waited for a number of times with each method, and the mean
+*              latency of each is printed. fork copies the page tables of
+*              the touched memory, posix_spawn runs the child on the
+*              parent's memory until exec, so only fork grows with the size.
+*              Usage: bench_spawn.out [num_of_rounds] [size_mib]...
+*/
+
+#define _GNU_SOURCE
+
+#include <spawn.h>          /* posix_spawn */
+#include <stdio.h>          /* printf */
+#include <stdlib.h>         /* malloc, free, strtoul */
+#include <string.h>         /* memset */
+#include <unistd.h>         /* fork, execve, _exit */
+#include <sys/wait.h>       /* waitpid */
+
+#include "mono_clock.h"
+
+#define NUM_OF_ROUNDS (20)
+#define MIB (1024 * 1024)
+#define CHILD_PATH ("/bin/true")
+
+typedef pid_t (*start_func_t)(void);
+
+static pid_t StartWithFork(void);
+static pid_t StartWithSpawn(void);
+static double MeanLatencyUs(start_func_t start, size_t num_of_rounds);
+
+extern char** environ;
+static char* g_child_argv[] = { "true", NULL };
+
+int main(int argc, char* argv[])
+{
+    int i = 0;
+    size_t num_of_rounds = (argc > 1) ? strtoul(argv[1], NULL, 10) :
+                                        NUM_OF_ROUNDS;
+    const char* default_sizes[] = { "0", "64", "256", "1024" };
+    const char** sizes = (argc > 2) ? (const char**)argv + 2 : default_sizes;
+    int num_of_sizes = (argc > 2) ? argc - 2 :
+                        (int)(sizeof(default_sizes) / sizeof(default_sizes[0]));
+
+    if (0 == num_of_rounds)
+    {
+        printf("1 or more rounds\n");
+        return 1;
+    }
+
+    printf("%lu rounds of %s per method\n", (unsigned long)num_of_rounds,
+            CHILD_PATH);
+
+    for (i = 0; i < num_of_sizes; ++i)
+    {
+        size_t size = strtoul(sizes[i], NULL, 10) * MIB;
+        char* memory = (char*)malloc(size + 1);
+        double fork_us = 0;
+        double spawn_us = 0;
+
+        if (NULL == memory)
+        {
+            printf("%6s MiB: allocation failed\n", sizes[i]);
+            return 1;
+        }
+
+        /* every page mapped, as in a process that has been running a while */
+        memset(memory, 1, size + 1);
+
+        fork_us = MeanLatencyUs(StartWithFork, num_of_rounds);
+        spawn_us = MeanLatencyUs(StartWithSpawn, num_of_rounds);
+
+        if ((fork_us < 0) || (spawn_us < 0))
+        {
+            printf("%6s MiB: start failed\n", sizes[i]);
+            free(memory);
+            return 1;
+        }
+
+        printf("%6s MiB: fork + exec %9.1f us   posix_spawn %9.1f us\n",
+                sizes[i], fork_us, spawn_us);
+
+        free(memory);
+    }
+
+    return 0;
+}
+
+static pid_t StartWithFork(void)
+{
+    pid_t pid = fork();
+
+    if (0 == pid)
+    {
+        execve(CHILD_PATH, g_child_argv, environ);
+        _exit(1);
+    }
+
+    return pid;
+}
+
+static pid_t StartWithSpawn(void)
+{
+    pid_t pid = -1;
+
+    if (0 != posix_spawn(&pid, CHILD_PATH, NULL, NULL, g_child_argv, environ))
+    {
+        return -1;
+    }
+
+    return pid;
+}
+
+/* start to exit of the child, -1 if a start or the child failed */
+static double MeanLatencyUs(start_func_t start, size_t num_of_rounds)
+{
+    size_t i = 0;
+    int status = 0;
+    pid_t pid = -1;
+    mono_time_t begin = MonoClockNow();
+
+    for (i = 0; i < num_of_rounds; ++i)
+    {
+        pid = start();
+
+        if ((-1 == pid) || (pid != waitpid(pid, &status, 0)) ||
+            !WIFEXITED(status) || (0 != WEXITSTATUS(status)))
+        {
+            return -1;
+        }
+    }
+
+    return (double)(MonoClockNow() - begin) / (double)num_of_rounds;
+}
@@ -0,0 +1,207 @@
+/*
+* File name: bench_timer_queues.c
+* Description: Add, cancel and expire cost of the scheduler's two queue
+*              backends, the deadline heap and the timing wheel, with the
+*              tasks' deadlines spread over a time span. Expiring walks the
+*              clock forward one wheel tick at a time and pops everything
+*              due, as the scheduler's loop does.
+*              Usage: bench_timer_queues.out [num_of_tasks] [span_ms]
+*/
+
+#include <stdio.h>          /* printf */
+#include <stdlib.h>         /* malloc, free, rand, strtoul */
+
+#include "deadline_heap.h"
+#include "mono_clock.h"
+#include "task.h"
+#include "timing_wheel.h"
+
+#define NUM_OF_TASKS (200000)
+#define SPAN_MS (60000)
+#define TICK_US (MONO_USEC_PER_MSEC)
+#define NSEC_PER_USEC (1000)
+
+typedef struct result
+{
+    double add_ns;
+    double cancel_ns;
+    double expire_ns;
+} result_t;
+
+static void SetDeadlines(task_t** tasks, size_t num_of_tasks,
+                            mono_time_t span_us);
+static result_t RunHeap(task_t** tasks, size_t num_of_tasks,
+                        mono_time_t span_us);
+static result_t RunWheel(task_t** tasks, size_t num_of_tasks,
+                            mono_time_t span_us);
+static double PerOp(mono_time_t start, size_t num_of_ops);
+static void PrintResult(const char* name, result_t result);
+static int Noop(void* params);
+
+int main(int argc, char* argv[])
+{
+    size_t i = 0;
+    size_t num_of_tasks = (argc > 1) ? strtoul(argv[1], NULL, 10) :
+                                        NUM_OF_TASKS;
+    mono_time_t span_us = ((argc > 2) ? strtoul(argv[2], NULL, 10) :
+                            SPAN_MS) * (mono_time_t)MONO_USEC_PER_MSEC;
+    task_t** tasks = (task_t**)malloc(num_of_tasks * sizeof(task_t*));
+
+    if ((NULL == tasks) || (0 == num_of_tasks) || (0 == span_us))
+    {
+        free(tasks);
+        return 1;
+    }
+
+    for (i = 0; i < num_of_tasks; ++i)
+    {
+        tasks[i] = TaskCreate(Noop, NULL, 1);
+
+        if (NULL == tasks[i])
+        {
+            printf("allocation failed\n");
+            return 1;
+        }
+    }
+
+    printf("%lu tasks over %lu ms\n", (unsigned long)num_of_tasks,
+            (unsigned long)(span_us / MONO_USEC_PER_MSEC));
+    PrintResult("heap", RunHeap(tasks, num_of_tasks, span_us));
+    PrintResult("timing wheel", RunWheel(tasks, num_of_tasks, span_us));
+
+    for (i = 0; i < num_of_tasks; ++i)
+    {
+        TaskDestroy(tasks[i]);
+    }
+
+    free(tasks);
+
+    return 0;
+}
+
+/* the same deadlines for both backends, in (0, span] */
+static void SetDeadlines(task_t** tasks, size_t num_of_tasks,
+                            mono_time_t span_us)
+{
+    size_t i = 0;
+
+    srand(1);
+
+    for (i = 0; i < num_of_tasks; ++i)
+    {
+        mono_time_t offset = ((mono_time_t)rand() * RAND_MAX +
+                                (mono_time_t)rand()) % span_us;
+
+        TaskSetScheduledTime(tasks[i], offset + 1);
+    }
+}
+
+static double PerOp(mono_time_t start, size_t num_of_ops)
+{
+    return (double)(MonoClockNow() - start) * NSEC_PER_USEC /
+            (double)num_of_ops;
+}
+
+static result_t RunHeap(task_t** tasks, size_t num_of_tasks,
+                        mono_time_t span_us)
+{
+    size_t i = 0;
+    mono_time_t now = 0;
+    mono_time_t start = 0;
+    result_t result;
+    deadline_heap_t* heap = DeadlineHeapCreate(0);
+
+    SetDeadlines(tasks, num_of_tasks, span_us);
+
+    start = MonoClockNow();
+    for (i = 0; i < num_of_tasks; ++i)
+    {
+        DeadlineHeapPush(heap, tasks[i]);
+    }
+    result.add_ns = PerOp(start, num_of_tasks);
+
+    /* in insertion order, so removals hit all over the heap */
+    start = MonoClockNow();
+    for (i = 0; i < num_of_tasks; ++i)
+    {
+        DeadlineHeapRemoveAt(heap, TaskGetQueueIndex(tasks[i]));
+    }
+    result.cancel_ns = PerOp(start, num_of_tasks);
+
+    for (i = 0; i < num_of_tasks; ++i)
+    {
+        DeadlineHeapPush(heap, tasks[i]);
+    }
+
+    start = MonoClockNow();
+    for (now = 0; !DeadlineHeapIsEmpty(heap); now += TICK_US)
+    {
+        while (!DeadlineHeapIsEmpty(heap) &&
+                (DeadlineHeapPeekTime(heap) <= now))
+        {
+            DeadlineHeapPop(heap);
+        }
+    }
+    result.expire_ns = PerOp(start, num_of_tasks);
+
+    DeadlineHeapDestroy(heap);
+
+    return result;
+}
+
+static result_t RunWheel(task_t** tasks, size_t num_of_tasks,
+                            mono_time_t span_us)
+{
+    size_t i = 0;
+    mono_time_t now = 0;
+    mono_time_t start = 0;
+    result_t result;
+    timing_wheel_t* wheel = TimingWheelCreate(TICK_US, 0);
+
+    SetDeadlines(tasks, num_of_tasks, span_us);
+
+    start = MonoClockNow();
+    for (i = 0; i < num_of_tasks; ++i)
+    {
+        TimingWheelAdd(wheel, tasks[i]);
+    }
+    result.add_ns = PerOp(start, num_of_tasks);
+
+    start = MonoClockNow();
+    for (i = 0; i < num_of_tasks; ++i)
+    {
+        TimingWheelRemove(wheel, tasks[i]);
+    }
+    result.cancel_ns = PerOp(start, num_of_tasks);
+
+    for (i = 0; i < num_of_tasks; ++i)
+    {
+        TimingWheelAdd(wheel, tasks[i]);
+    }
+
+    start = MonoClockNow();
+    for (now = 0; 0 != TimingWheelSize(wheel); now += TICK_US)
+    {
+        while (NULL != TimingWheelPopExpired(wheel, now))
+        {
+        }
+    }
+    result.expire_ns = PerOp(start, num_of_tasks);
+
+    TimingWheelDestroy(wheel);
+
+    return result;
+}
+
+static void PrintResult(const char* name, result_t result)
+{
+    printf("%-13s add %6.1f ns   cancel %6.1f ns   expire %6.1f ns\n", name,
+            result.add_ns, result.cancel_ns, result.expire_ns);
+}
+
+static int Noop(void* params)
+{
+    (void)params;
+
+    return 0;
+}
@@ -0,0 +1,125 @@
+/*
+* File name: bench_uid.c
+* Description: UIDs per second from UIDCreate, against the per-UID
+*              getifaddrs() lookup it used before the node identity was
+*              cached. The lookup is timed over fewer calls, it is slow.
+*              Usage: bench_uid.out [num_of_uids] [num_of_threads]
+*/
+
+#define _POSIX_C_SOURCE (200809L)
+
+#include <ifaddrs.h>        /* getifaddrs, freeifaddrs */
+#include <pthread.h>        /* pthread_create, pthread_join */
+#include <stdio.h>          /* printf */
+#include <stdlib.h>         /* strtoul */
+#include <time.h>           /* time */
+#include <unistd.h>         /* getpid */
+
+#include "uid.h"
+#include "mono_clock.h"
+
+#define NUM_OF_UIDS (10000000)
+#define LOOKUP_DIVISOR (1000)   /* the old path runs on 1/1000 of the calls */
+#define MAX_THREADS (64)
+
+typedef struct worker
+{
+    size_t count;
+    uint64_t sum;               /* keeps the calls from being optimized out */
+} worker_t;
+
+static void* CreateUIDs(void* params);
+static double TimeCreate(size_t num_of_uids, size_t num_of_threads);
+static double TimeLookup(size_t num_of_uids);
+
+static volatile uint64_t g_sink = 0;
+
+int main(int argc, char* argv[])
+{
+    size_t num_of_uids = (argc > 1) ? strtoul(argv[1], NULL, 10) :
+                                        NUM_OF_UIDS;
+    size_t num_of_threads = (argc > 2) ? strtoul(argv[2], NULL, 10) : 1;
+    size_t num_of_lookups = num_of_uids / LOOKUP_DIVISOR + 1;
+
+    if ((0 == num_of_threads) || (num_of_threads > MAX_THREADS))
+    {
+        printf("1 to %d threads\n", MAX_THREADS);
+        return 1;
+    }
+
+    printf("getifaddrs per uid  %12.0f uids/s  (%lu calls)\n",
+            TimeLookup(num_of_lookups), (unsigned long)num_of_lookups);
+    printf("UIDCreate           %12.0f uids/s  (%lu calls, %lu threads)\n",
+            TimeCreate(num_of_uids, num_of_threads),
+            (unsigned long)num_of_uids, (unsigned long)num_of_threads);
+
+    return 0;
+}
+
+static void* CreateUIDs(void* params)
+{
+    size_t i = 0;
+    worker_t* worker = (worker_t*)params;
+
+    for (i = 0; i < worker->count; ++i)
+    {
+        worker->sum += UIDCreate().lo;
+    }
+
+    return NULL;
+}
+
+static double TimeCreate(size_t num_of_uids, size_t num_of_threads)
+{
+    size_t i = 0;
+    size_t per_thread = num_of_uids / num_of_threads;
+    pthread_t threads[MAX_THREADS];
+    worker_t workers[MAX_THREADS];
+    mono_time_t start = 0;
+
+    /* the one-time lookup is not part of the steady state */
+    UIDCreate();
+    start = MonoClockNow();
+
+    for (i = 0; i < num_of_threads; ++i)
+    {
+        workers[i].count = per_thread;
+        workers[i].sum = 0;
+        pthread_create(&threads[i], NULL, CreateUIDs, &workers[i]);
+    }
+
+    for (i = 0; i < num_of_threads; ++i)
+    {
+        pthread_join(threads[i], NULL);
+        g_sink += workers[i].sum;
+    }
+
+    return (double)(per_thread * num_of_threads) * MONO_USEC_PER_SEC /
+            (double)(MonoClockNow() - start);
+}
+
+/* what UIDCreate did per call before: walk the interfaces, getpid, time */
+static double TimeLookup(size_t num_of_uids)
+{
+    size_t i = 0;
+    uint64_t sum = 0;
+    struct ifaddrs* addrs = NULL;
+    mono_time_t start = MonoClockNow();
+
+    for (i = 0; i < num_of_uids; ++i)
+    {
+        if (0 == getifaddrs(&addrs))
+        {
+            sum += (NULL != addrs->ifa_addr) ?
+                    (unsigned char)addrs->ifa_addr->sa_data[0] : 0;
+            freeifaddrs(addrs);
+        }
+
+        sum += (uint64_t)getpid() + (uint64_t)time(NULL) + i;
+    }
+
+    g_sink += sum;
+
+    return (double)num_of_uids * MONO_USEC_PER_SEC /
+            (double)(MonoClockNow() - start);
+}
@@ -0,0 +1,88 @@
+/* async_log.h */
+
+#ifndef __ASYNC_LOG_H__
+#define __ASYNC_LOG_H__
+
+#include <stddef.h>         /* size_t */
+
+/*
+*   Append-only text log written by a background thread. Every thread that
+*   writes gets its own single producer ring of fixed size lines, so writing
+*   is a copy and two atomic operations: no lock, no system call, and a full
+*   ring drops the line instead of waiting. The writer thread keeps the file
+*   open, drains the rings with one writev per batch and rotates the file
+*   once it grows past a size. Lines of one thread keep their order, lines of
+*   different threads may be reordered by up to one flush interval.
+*/
+typedef struct async_log async_log_t;
+
+#define ASYNC_LOG_LINE_MAX (256)    /* longer lines are truncated */
+
+/*
+*   @desc:          Opens @path for appending, creating it if needed, and
+*				starts the writer thread. Must be destroyed with
+*				@AsyncLogDestroy
+*   @params: 		@path: file to write to
+*				@max_file_size: once the file reaches this many bytes it is
+*				renamed to @path with ".1" appended, replacing the previous
+*				one, and a new file is started. zero to never rotate
+*   @return value:  Pointer to the new log
+*   @error: 		Returns NULL if @path cannot be opened, or if allocation
+*				or thread creation fails
+*   @time complex: 	O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+async_log_t* AsyncLogCreate(const char* path, size_t max_file_size);
+
+/*
+*   @desc:          Writes out every line already queued, stops the writer
+*				thread, closes the file and frees @log. No thread may write
+*				to @log during or after the call
+*   @params: 		@log: log created with @AsyncLogCreate
+*   @return value:  None
+*   @error: 		None
+*   @time complex: 	O(queued lines + threads) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+void AsyncLogDestroy(async_log_t* log);
+
+/*
+*   @desc:          Queues @text to be appended as is, newline included. Never
+*				blocks: the first call of a thread allocates its ring, later
+*				calls only copy. Safe to call from any thread
+*   @params: 		@log: log created with @AsyncLogCreate
+*				@text: null terminated string
+*   @return value:  zero if queued, nonzero if dropped
+*   @error: 		Drops the line if the thread's ring is full or can't be
+*				allocated, see @AsyncLogDropped. Undefined behavior if @log
+*				or @text is invalid
+*   @time complex: 	O(1) AC, O(threads) WC
+*   @space complex: O(1) AC, O(ring size) WC
+*/
+int AsyncLogWrite(async_log_t* log, const char* text);
+
+/*
+*   @desc:          Blocks until every line queued before the call is written
+*				to the file. Memory stays valid, so unlike @AsyncLogDestroy
+*				it may run while other threads still write, e.g. at exit
+*   @params: 		@log: log created with @AsyncLogCreate
+*   @return value:  None
+*   @error: 		Undefined behavior if @log is invalid
+*   @time complex: 	O(queued lines + threads) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+void AsyncLogFlush(async_log_t* log);
+
+/*
+*   @desc:          Returns the number of lines dropped so far because a ring
+*				was full. The writer also notes each batch of drops in the
+*				file
+*   @params: 		@log: log created with @AsyncLogCreate
+*   @return value:  Number of dropped lines
+*   @error: 		Undefined behavior if @log is invalid
+*   @time complex: 	O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+size_t AsyncLogDropped(async_log_t* log);
+
+#endif /* __ASYNC_LOG_H__ */
@@ -0,0 +1,140 @@
+/* deadline_heap.h */
+
+#ifndef __DEADLINE_HEAP_H__
+#define __DEADLINE_HEAP_H__
+
+#include <stddef.h>         /* size_t */
+
+#include "task.h"           /* task_t */
+#include "mono_clock.h"     /* mono_time_t */
+
+/*
+*   Min-heap of tasks ordered by scheduled time. Each slot stores the
+*   {deadline, task} pair inline, so sifting compares deadlines without
+*   dereferencing tasks. The arity is set at build time with
+*   DEADLINE_HEAP_ARITY (default 2) and sibling groups are cache-line
+*   aligned. The slot of every task is kept up to date with
+*   @TaskSetQueueIndex.
+*/
+typedef struct deadline_heap deadline_heap_t;
+
+/*
+*   @desc:          Allocates an empty deadline heap
+*   @params: 		@capacity_hint: number of slots to preallocate, may be 0
+*   @return value:  Pointer to the new heap
+*   @error: 		Returns NULL if allocation fails
+*   @time complex: 	O(malloc) for both AC/WC
+*   @space complex: O(capacity_hint) for both AC/WC
+*/
+deadline_heap_t* DeadlineHeapCreate(size_t capacity_hint);
+
+/*
+*   @desc:          Frees @heap. The tasks it holds are not freed
+*   @params: 		@heap: heap created with @DeadlineHeapCreate
+*   @return value:  None
+*   @error: 		Undefined behavior if @heap is invalid
+*   @time complex: 	O(free) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+void DeadlineHeapDestroy(deadline_heap_t* heap);
+
+/*
+*   @desc:          Inserts @task keyed by its current scheduled time
+*   @params: 		@heap: pre allocated heap
+*				@task: task to insert
+*   @return value:  zero on success, nonzero if growing the heap failed
+*   @error: 		Undefined behavior if @heap or @task is invalid
+*   @time complex: 	O(log(n)) AC, O(n) WC
+*   @space complex: O(1) AC, O(n) WC
+*/
+int DeadlineHeapPush(deadline_heap_t* heap, task_t* task);
+
+/*
+*   @desc:          Inserts @count tasks at once with a single grow. Large
+*				batches are heapified bottom-up instead of sifted one by one
+*   @params: 		@heap: pre allocated heap
+*				@tasks: array of @count tasks to insert
+*				@count: number of tasks, may be 0
+*   @return value:  zero on success, nonzero if growing the heap failed, in
+*				which case none of the tasks were inserted
+*   @error: 		Undefined behavior if @heap or any task is invalid
+*   @time complex: 	O(count * log(n)) if count < n, else O(n + count)
+*   @space complex: O(1) AC, O(n + count) WC
+*/
+int DeadlineHeapPushMany(deadline_heap_t* heap, task_t* const* tasks,
+                        size_t count);
+
+/*
+*   @desc:          Removes and returns the task with the earliest deadline
+*   @params: 		@heap: pre allocated heap
+*   @return value:  The removed task
+*   @error: 		Undefined behavior if @heap is invalid or empty
+*   @time complex: 	O(log(n)) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+task_t* DeadlineHeapPop(deadline_heap_t* heap);
+
+/*
+*   @desc:          Returns the task with the earliest deadline
+*   @params: 		@heap: pre allocated heap
+*   @return value:  The first task
+*   @error: 		Undefined behavior if @heap is invalid or empty
+*   @time complex: 	O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+task_t* DeadlineHeapPeek(const deadline_heap_t* heap);
+
+/*
+*   @desc:          Returns the earliest deadline, without touching the task
+*   @params: 		@heap: pre allocated heap
+*   @return value:  Earliest deadline in the heap
+*   @error: 		Undefined behavior if @heap is invalid or empty
+*   @time complex: 	O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+mono_time_t DeadlineHeapPeekTime(const deadline_heap_t* heap);
+
+/*
+*   @desc:          Removes the task at slot @index (see @TaskGetQueueIndex)
+*   @params: 		@heap: pre allocated heap
+*				@index: current slot of the task
+*   @return value:  The removed task
+*   @error: 		Undefined behavior if @heap or @index is invalid
+*   @time complex: 	O(log(n)) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+task_t* DeadlineHeapRemoveAt(deadline_heap_t* heap, size_t index);
+
+/*
+*   @desc:          Re-reads the scheduled time of the task at slot @index
+*				and restores the heap order
+*   @params: 		@heap: pre allocated heap
+*				@index: current slot of the task
+*   @return value:  None
+*   @error: 		Undefined behavior if @heap or @index is invalid
+*   @time complex: 	O(log(n)) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+void DeadlineHeapUpdate(deadline_heap_t* heap, size_t index);
+
+/*
+*   @desc:          Returns the number of tasks in @heap
+*   @params: 		@heap: pre allocated heap
+*   @return value:  Number of tasks
+*   @error: 		Undefined behavior if @heap is invalid
+*   @time complex: 	O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+size_t DeadlineHeapSize(const deadline_heap_t* heap);
+
+/*
+*   @desc:          Checks if @heap is empty
+*   @params: 		@heap: pre allocated heap
+*   @return value:  1 if empty, 0 otherwise
+*   @error: 		Undefined behavior if @heap is invalid
+*   @time complex: 	O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+int DeadlineHeapIsEmpty(const deadline_heap_t* heap);
+
+#endif /* __DEADLINE_HEAP_H__ */
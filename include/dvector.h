@@ -62,12 +62,16 @@ void DvectorGetElement(const dvector_t* dvector, size_t index, void* dest);
 * 	@Desc: Pushes an element to the last valid element index (DvectorSize)
 * 	@Params: Pointer to a pre-allocated dvector_t data type,
 *            void* to the return element.
-* 	@Return: Return success (0) or failure (1)
+* 	@Return: Return success (0) or failure (1) if growing the dvector failed,
+*            in which case the dvector is left unchanged
 */
 int DvectorPushBack(dvector_t* dvector, const void* element);
 
 /*
 * 	@Desc: Pops out the element at the last valid index in dvector (DvectorSize)
+*          Once size drops below a quarter of the capacity, the capacity is
+*          cut to twice the size, but never below the capacity the vector was
+*          created or reserved with, nor below a small fixed floor.
 * 	@Params: Pointer to a pre-allocated dvector_t data type.
 * 	@Return: Return success (0) or failure (1). If this element is required
 *            use DvectorGetElement before.
@@ -90,7 +94,7 @@ int DvectorPopBack(dvector_t* dvector);
 int DvectorResize(dvector_t* dvector, size_t new_capacity);
 
 /*
-* 	@Desc: Shrink to size.
+* 	@Desc: Shrink to size. Same as DvectorShrinkToFit.
 * 	@Params: pointer to a pre-allocated dvector_t data type
 * 	@Return: (0) if success or (1) for failure
 * 	Edge Cases:
@@ -102,4 +106,75 @@ int DvectorResize(dvector_t* dvector, size_t new_capacity);
 */
 int DvectorShrink(dvector_t* dvector);
 
+/*
+* 	@Desc: Makes room for at least @capacity elements and keeps automatic
+*          shrinking from going below @capacity, until DvectorShrinkToFit
+*          or another DvectorReserve.
+* 	@Params: pointer to a pre-allocated dvector_t data type,
+*            size_t minimum capacity for the dvector
+* 	@Return: (0) if success or (1) for failure
+* 	Edge Cases:
+* 	1) (capacity <= current capacity) -> only sets the floor, return SUCCESS.
+* 	2) memory reallocation failure -> dvector is unchanged, return FAILURE.
+* 	3) (dvector = NULL) -> assert.
+*/
+int DvectorReserve(dvector_t* dvector, size_t capacity);
+
+/*
+* 	@Desc: Sets the capacity to exactly the size and drops the floor set by
+*          creation or DvectorReserve.
+* 	@Params: pointer to a pre-allocated dvector_t data type
+* 	@Return: (0) if success or (1) for failure
+* 	Edge Cases:
+* 	1) (capacity = size) -> return SUCCESS.
+* 	2) (size = 0) -> array is freed, the next push allocates it again.
+* 	3) memory reallocation failure -> capacity is unchanged, return FAILURE.
+* 	4) (dvector = NULL) -> assert.
+*/
+int DvectorShrinkToFit(dvector_t* dvector);
+
+/*
+* 	@Desc: Appends @count elements stored contiguously at @elements with a
+*          single grow and a single copy.
+* 	@Params: pointer to a pre-allocated dvector_t data type,
+*            pointer to the first element to append, number of elements
+* 	@Return: (0) if success or (1) for failure
+* 	Edge Cases:
+* 	1) (count = 0) -> nothing is appended, return SUCCESS.
+* 	2) memory reallocation failure -> dvector is unchanged, return FAILURE.
+* 	3) @elements overlapping the dvector's own array -> undefined behavior.
+* 	4) (dvector = NULL) -> assert.
+*/
+int DvectorAppendRange(dvector_t* dvector, const void* elements, size_t count);
+
+/*
+* 	@Desc: Adds one uninitialized element at the end, to be written in place
+*          by the caller instead of being copied in.
+* 	@Params: pointer to a pre-allocated dvector_t data type
+* 	@Return: pointer to the new element, or NULL if growing failed (the
+*            dvector is unchanged). The pointer is valid until the next
+*            change of capacity.
+*/
+void* DvectorEmplaceBack(dvector_t* dvector);
+
+/*
+* 	@Desc: Direct access to the contiguous array of elements, element i is
+*          at byte offset i * element_size.
+* 	@Params: pointer to a pre-allocated dvector_t data type
+* 	@Return: pointer to the first element. The pointer is valid until the
+*            next change of capacity (push/emplace/append past the capacity,
+*            automatic shrinking on pop, reserve, resize or shrink).
+*/
+void* DvectorData(const dvector_t* dvector);
+
+/*
+* 	@Desc: Exchanges the elements at @index1 and @index2 in place.
+* 	@Params: pointer to a pre-allocated dvector_t data type, two indexes
+* 	@Return: none
+* 	Edge Cases:
+* 	1) (index1 = index2) -> nothing changes.
+* 	2) index out of range -> assert.
+*/
+void DvectorSwap(dvector_t* dvector, size_t index1, size_t index2);
+
 #endif  /* End of header guard Dvector */
@@ -0,0 +1,109 @@
+/* fd_poller.h */
+
+#ifndef __FD_POLLER_H__
+#define __FD_POLLER_H__
+
+#include <stddef.h>         /* size_t */
+#include <stdint.h>         /* uint64_t */
+
+#include "mono_clock.h"     /* mono_time_t */
+
+/*
+*   Linux readiness poller: epoll over the registered file descriptors, plus
+*   one timerfd armed with the absolute monotonic deadline of the wait and
+*   one eventfd that lets other threads interrupt it. A single thread can
+*   this way wait for its next timer and for I/O at once, with a precise
+*   wakeup and no signals involved.
+*/
+typedef struct fd_poller fd_poller_t;
+
+/* one ready descriptor, as returned by @FdPollerWait */
+typedef struct fd_poller_event
+{
+    uint64_t key;               /* as given to @FdPollerAdd */
+    unsigned int events;        /* EPOLLIN, EPOLLOUT, EPOLLERR ... bits */
+} fd_poller_event_t;
+
+#define FD_POLLER_NO_DEADLINE ((mono_time_t)-1)
+#define FD_POLLER_MAX_KEY (UINT64_MAX - 1)  /* the poller keeps the rest */
+
+/*
+*   @desc:          Allocates a poller with nothing registered. Must be
+*				destroyed with @FdPollerDestroy
+*   @params: 		None
+*   @return value:  Pointer to the new poller
+*   @error: 		Returns NULL if allocation or creating the descriptors
+*				fails
+*   @time complex: 	O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+fd_poller_t* FdPollerCreate(void);
+
+/*
+*   @desc:          Closes the poller's own descriptors and frees it. The
+*				registered descriptors are not closed
+*   @params: 		@poller: poller created with @FdPollerCreate
+*   @return value:  None
+*   @error: 		None
+*   @time complex: 	O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+void FdPollerDestroy(fd_poller_t* poller);
+
+/*
+*   @desc:          Starts reporting @events on @fd, level triggered, tagged
+*				with @key
+*   @params: 		@poller: poller created with @FdPollerCreate
+*				@fd: open descriptor, not registered yet
+*				@events: EPOLLIN, EPOLLOUT ... bits to wait for
+*				@key: value to report with the events of @fd, below
+*				FD_POLLER_MAX_KEY
+*   @return value:  zero on success, nonzero if epoll refused @fd
+*   @error: 		Undefined behavior if @poller is invalid
+*   @time complex: 	O(log(n)) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+int FdPollerAdd(fd_poller_t* poller, int fd, unsigned int events,
+                uint64_t key);
+
+/*
+*   @desc:          Stops reporting events of @fd
+*   @params: 		@poller: poller created with @FdPollerCreate
+*				@fd: descriptor registered with @FdPollerAdd
+*   @return value:  zero on success, nonzero if @fd wasn't registered
+*   @error: 		Undefined behavior if @poller is invalid
+*   @time complex: 	O(log(n)) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+int FdPollerRemove(fd_poller_t* poller, int fd);
+
+/*
+*   @desc:          Waits until a registered descriptor is ready, @deadline
+*				passes or @FdPollerWake is called, whichever is first
+*   @params: 		@poller: poller created with @FdPollerCreate
+*				@deadline: absolute monotonic time, or
+*				FD_POLLER_NO_DEADLINE to wait without a timeout
+*				@events: array that receives up to @max_events ready
+*				descriptors
+*				@max_events: size of @events, must be nonzero
+*   @return value:  number of entries written to @events, 0 if the wait
+*				ended by the deadline, a wake or a signal
+*   @error: 		Returns -1 if epoll failed
+*   @time complex: 	O(max_events) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+int FdPollerWait(fd_poller_t* poller, mono_time_t deadline,
+                    fd_poller_event_t* events, size_t max_events);
+
+/*
+*   @desc:          Ends the current or the next @FdPollerWait early. May be
+*				called from any thread
+*   @params: 		@poller: poller created with @FdPollerCreate
+*   @return value:  None
+*   @error: 		None
+*   @time complex: 	O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+void FdPollerWake(fd_poller_t* poller);
+
+#endif /* __FD_POLLER_H__ */
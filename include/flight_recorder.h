@@ -0,0 +1,87 @@
+/* flight_recorder.h */
+
+#ifndef __FLIGHT_RECORDER_H__
+#define __FLIGHT_RECORDER_H__
+
+#include <stddef.h>         /* size_t */
+#include <stdint.h>         /* uint64_t */
+
+/*
+*   Fixed size ring of binary event records in a shared memory mapped file.
+*   Recording claims a slot with one atomic add and fills it with one 16 byte
+*   store: no lock, no system call, and safe in a signal handler. The pages
+*   belong to the file, so the last records survive a crash or a kill of the
+*   process, and several processes may record into the same file. The file
+*   layout below is what decoders read.
+*/
+typedef struct flight_recorder flight_recorder_t;
+
+#define FR_MAGIC (UINT64_C(0x5448474C46445755))   /* "UWDFLGHT" */
+#define FR_VERSION (1)
+
+/* at offset 0 of the file, the records follow it */
+typedef struct fr_file_header
+{
+    uint64_t magic;
+    uint32_t version;
+    uint32_t record_size;
+    uint64_t capacity;          /* number of records in the ring */
+    uint64_t next;              /* total records ever claimed */
+    int64_t mono_to_real_us;    /* add to a time_us for wall clock time */
+    uint64_t reserved[3];
+} fr_file_header_t;
+
+typedef struct fr_record
+{
+    uint64_t time_us;           /* monotonic, see mono_clock.h. 0 if unused */
+    uint64_t info;              /* pid, event and counter, see below */
+} fr_record_t;
+
+#define FR_RECORD_PID(record) ((uint32_t)((record)->info & 0xFFFFFFFFU))
+#define FR_RECORD_EVENT(record) ((unsigned int)(((record)->info >> 32) & \
+                                                0xFFFFU))
+#define FR_RECORD_COUNTER(record) ((unsigned int)((record)->info >> 48))
+
+/*
+*   @desc:          Maps @path as a ring of @capacity records, creating the
+*				file if needed. An existing file of the same layout keeps its
+*				records and its position, so a restarted process appends
+*				to the history of the one it replaces; any other file is
+*				reset. Must be destroyed with @FlightRecorderDestroy
+*   @params: 		@path: file to record into
+*				@capacity: number of records kept, must be nonzero
+*   @return value:  Pointer to the new recorder
+*   @error: 		Returns NULL if the file cannot be opened, sized or mapped,
+*				or on allocation failure
+*   @time complex: 	O(1) AC, O(capacity) WC when the file is reset
+*   @space complex: O(1) for both AC/WC
+*/
+flight_recorder_t* FlightRecorderCreate(const char* path, size_t capacity);
+
+/*
+*   @desc:          Unmaps the file and frees @recorder. The records stay in
+*				the file. No thread may record during or after the call
+*   @params: 		@recorder: recorder created with @FlightRecorderCreate
+*   @return value:  None
+*   @error: 		None
+*   @time complex: 	O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+void FlightRecorderDestroy(flight_recorder_t* recorder);
+
+/*
+*   @desc:          Records @event with @counter, the time and the pid of the
+*				process that created @recorder, overwriting the oldest record
+*				once the ring is full. Async signal safe
+*   @params: 		@recorder: recorder created with @FlightRecorderCreate
+*				@event: caller defined event type, 16 bits are kept
+*				@counter: caller defined value, 16 bits are kept
+*   @return value:  None
+*   @error: 		Undefined behavior if @recorder is invalid
+*   @time complex: 	O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+void FlightRecorderRecord(flight_recorder_t* recorder, unsigned int event,
+							unsigned int counter);
+
+#endif /* __FLIGHT_RECORDER_H__ */
@@ -8,6 +8,16 @@
 typedef struct heap heap_t;
 typedef int (*compare_func_t)(const void* data, const void* param);
 typedef int (*is_match_t)(const void* data1, const void* data2);
+typedef void (*set_index_t)(void* data, size_t index);
+
+/*
+* common arities for @HeapCreate. 8 pointer-sized children take 64 bytes, but
+* the array isn't aligned, so a group usually spans two cache lines. Only
+* deadline_heap aligns its sibling groups to lines
+*/
+#define HEAP_BINARY (2)
+#define HEAP_4_ARY (4)
+#define HEAP_8_ARY (8)
 
 
 /*
@@ -15,12 +25,22 @@ typedef int (*is_match_t)(const void* data1, const void* data2);
 *	@param:				@compare_func: compare function returns zero if equal,
 *						negative if @data1 is less than @data2 and otherwise
 *						postive
+*						@set_index: optional (may be NULL) callback that is
+*						invoked with an element's new position whenever it
+*						is placed in the heap. Storing that position makes
+*						the heap addressable through @HeapRemoveAt
+*						@arity: number of children per node (>= 2). A wider
+*						heap is shallower: pushes do fewer comparisons and
+*						pops touch fewer, contiguous, levels, which pays off
+*						for large heaps
 *	@return:			Newly allocated heap
 *	@error:				Returns NULL if allocation failed
+*						Undefined behavior if @arity < 2
 *	@time complexity:	O(malloc) for both AC/WC
 *	@space complexity:	O(malloc) for both AC/WC
 */
-heap_t* HeapCreate(compare_func_t compare_func);
+heap_t* HeapCreate(compare_func_t compare_func, set_index_t set_index,
+                    size_t arity);
 
 
 /*
@@ -46,6 +66,23 @@ void HeapDestroy(heap_t* heap);
 */
 int HeapPush(heap_t* heap, void* data);
 
+/*
+*	@desc:				Pushes @count elements to @heap with one copy into the
+*						heap's array. When the batch is at least as large as
+*						the heap, the whole heap is rebuilt bottom-up instead
+*						of sifting every element up
+*	@param:				@heap: preallocated heap, may already hold elements
+*						@elements: array of @count user data pointers
+*						@count: number of elements, may be 0
+*	@return:			Zero if function successful otherwise non zero, in
+*						which case none of the elements were pushed
+*	@error:				Undefined behavior if @heap is invalid
+*						Returns nonzero value if allocation failed
+*	@time complexity:	O(count * log(n)) if count < n, else O(n + count)
+*	@space complexity:	O(1) for AC and O(n + count) for WC
+*/
+int HeapBuild(heap_t* heap, void* const* elements, size_t count);
+
 
 /*
 *	@desc:				Pops the first element from @heap
@@ -106,4 +143,33 @@ int HeapIsEmpty(const heap_t* heap);
 */
 void* HeapRemove(heap_t* heap, void* param, is_match_t is_match);
 
+
+/*
+*	@desc:				Removes the element at position @index, as reported by
+*						the @set_index callback given to @HeapCreate
+*	@param:				@heap: preallocated heap
+*						@index: current position of the element to remove
+*	@return:			Returns the removed element
+*	@error:				Undefined behavior if @heap is invalid or @index is
+*						out of range
+*	@time complexity:	O(log(n)) for both AC/WC
+*	@space complexity:	O(1) for both AC/WC
+*/
+void* HeapRemoveAt(heap_t* heap, size_t index);
+
+
+/*
+*	@desc:				Restores heap order after the key of the element at
+*						position @index was changed in place (decreased or
+*						increased), with a single sift up or down
+*	@param:				@heap: preallocated heap
+*						@index: current position of the changed element
+*	@return:			None
+*	@error:				Undefined behavior if @heap is invalid or @index is
+*						out of range
+*	@time complexity:	O(log(n)) for both AC/WC
+*	@space complexity:	O(1) for both AC/WC
+*/
+void HeapUpdate(heap_t* heap, size_t index);
+
 #endif /* __HEAP_H__ */
@@ -0,0 +1,112 @@
+/* heap_kernel.h */
+
+#ifndef __HEAP_KERNEL_H__
+#define __HEAP_KERNEL_H__
+
+#include <stddef.h>     /* size_t */
+
+/*
+*	@desc:		Generates a d-ary min-heap kernel specialized for @ELEM_TYPE
+*				elements stored inline in a plain array. Unlike heap.c there
+*				is no compare callback and no per-element memcpy: keys are
+*				compared directly with @IS_LESS and sifting moves a hole,
+*				writing the sifted element once at its final slot.
+*				Defines the static functions:
+*				void PREFIX##SiftUp(ELEM_TYPE* arr, size_t idx)
+*				void PREFIX##SiftDown(ELEM_TYPE* arr, size_t size, size_t idx)
+*				void PREFIX##Resift(ELEM_TYPE* arr, size_t size, size_t idx)
+*				void PREFIX##Heapify(ELEM_TYPE* arr, size_t size) - orders
+*				an arbitrary array in O(size), bottom-up. Leaves that stay
+*				where they are are not passed to ON_PLACE
+*	@param:		@PREFIX: prefix of the generated function names
+*				@ELEM_TYPE: element type, copied by assignment
+*				@ARITY: number of children per node (>= 2). The children
+*				of node i are the contiguous slots ARITY * i + 1 ..
+*				ARITY * i + ARITY
+*				@IS_LESS(a, b): expression, nonzero if element a orders
+*				before element b
+*				@ON_PLACE(elem, idx): statement run whenever an element is
+*				written to slot idx (use an empty expansion when unused)
+*/
+#define HEAP_KERNEL_DEFINE(PREFIX, ELEM_TYPE, ARITY, IS_LESS, ON_PLACE)      \
+                                                                             \
+static void PREFIX##SiftUp(ELEM_TYPE* arr, size_t idx)                       \
+{                                                                            \
+    ELEM_TYPE moving = arr[idx];                                             \
+                                                                             \
+    while (idx > 0)                                                          \
+    {                                                                        \
+        size_t parent = (idx - 1) / (ARITY);                                 \
+                                                                             \
+        if (!(IS_LESS(moving, arr[parent])))                                 \
+        {                                                                    \
+            break;                                                           \
+        }                                                                    \
+                                                                             \
+        arr[idx] = arr[parent];                                              \
+        ON_PLACE(arr[idx], idx);                                             \
+        idx = parent;                                                        \
+    }                                                                        \
+                                                                             \
+    arr[idx] = moving;                                                       \
+    ON_PLACE(arr[idx], idx);                                                 \
+}                                                                            \
+                                                                             \
+static void PREFIX##SiftDown(ELEM_TYPE* arr, size_t size, size_t idx)        \
+{                                                                            \
+    ELEM_TYPE moving = arr[idx];                                             \
+    size_t first = (ARITY) * idx + 1;                                        \
+                                                                             \
+    while (first < size)                                                     \
+    {                                                                        \
+        size_t child = first;                                                \
+        size_t runner = first + 1;                                           \
+        size_t end = (first + (ARITY) < size) ? first + (ARITY) : size;      \
+                                                                             \
+        for (; runner < end; ++runner)                                       \
+        {                                                                    \
+            if (IS_LESS(arr[runner], arr[child]))                            \
+            {                                                                \
+                child = runner;                                              \
+            }                                                                \
+        }                                                                    \
+                                                                             \
+        if (!(IS_LESS(arr[child], moving)))                                  \
+        {                                                                    \
+            break;                                                           \
+        }                                                                    \
+                                                                             \
+        arr[idx] = arr[child];                                               \
+        ON_PLACE(arr[idx], idx);                                             \
+        idx = child;                                                         \
+        first = (ARITY) * idx + 1;                                           \
+    }                                                                        \
+                                                                             \
+    arr[idx] = moving;                                                       \
+    ON_PLACE(arr[idx], idx);                                                 \
+}                                                                            \
+                                                                             \
+static void PREFIX##Resift(ELEM_TYPE* arr, size_t size, size_t idx)          \
+{                                                                            \
+    if ((idx > 0) && (IS_LESS(arr[idx], arr[(idx - 1) / (ARITY)])))          \
+    {                                                                        \
+        PREFIX##SiftUp(arr, idx);                                            \
+    }                                                                        \
+    else                                                                     \
+    {                                                                        \
+        PREFIX##SiftDown(arr, size, idx);                                    \
+    }                                                                        \
+}                                                                            \
+                                                                             \
+static void PREFIX##Heapify(ELEM_TYPE* arr, size_t size)                     \
+{                                                                            \
+    /* one past the last node that has children */                          \
+    size_t idx = (size > 1) ? (size - 2) / (ARITY) + 1 : 0;                  \
+                                                                             \
+    while (idx-- > 0)                                                        \
+    {                                                                        \
+        PREFIX##SiftDown(arr, size, idx);                                    \
+    }                                                                        \
+}
+
+#endif /* __HEAP_KERNEL_H__ */
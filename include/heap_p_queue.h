@@ -11,13 +11,20 @@ typedef struct heap_pq heap_pq_t;
 *   @desc:          Allocates Priority Queue.
 *   @params: 		@priority_func: Compare function that the priority is sorted
 *									by.
+*					@set_index: Optional (may be NULL) callback receiving an
+*								element's position whenever it moves. Needed
+*								for @HeapPQEraseAt
+*					@arity: number of children per heap node, see
+*							@HeapCreate
 *   @return value:  Pointer to the allocated Priority Queue
 *   @error: 		NULL if allocation fails
 *					Undefined behavior if @compare_func is not valid
 *   @time complex: 	O(malloc) for both AC/WC
 *   @space complex: O(malloc) for both AC/WC
 */
-heap_pq_t* HeapPQCreate(int (*compare_func)(const void*, const void*));
+heap_pq_t* HeapPQCreate(int (*compare_func)(const void*, const void*),
+                        void (*set_index)(void* data, size_t index),
+                        size_t arity);
 
 /*
 *   @desc: 	        Frees Priority Queue. Must be created using @PQCreate.
@@ -42,6 +49,20 @@ void HeapPQDestroy(heap_pq_t* heap_pq);
 */
 int HeapPQEnqueue(heap_pq_t* heap_pq, void* data);
 
+/*
+*   @desc: 	     Enqueues @count items to @pq at once, see @HeapBuild.
+*   @params: 	    	@pq : pre allocated priority queue.
+*				@data: array of @count data pointers of the new elements
+*				@count: number of elements, may be 0
+*   @return value: 	returns 0 on success
+*   @error: 		In the event insertion fails(due to allocation) will return
+* 				    non zero value and none of the items are enqueued.
+*					Undefined Behavior if @pq is not valid.
+*   @time complex: 	O(count * log(n)) if count < n, else O(n + count)
+*   @space complex: O(1) AC, O(n + count) WC
+*/
+int HeapPQEnqueueMany(heap_pq_t* heap_pq, void* const* data, size_t count);
+
 /*
 *   @desc:		   	Removes the first element from @pq.
 *   @params: 	   	@pq : pre allocated priority queue.
@@ -104,4 +125,28 @@ void HeapPQClear(heap_pq_t* heap_pq);
 void* HeapPQErase(heap_pq_t* heap_pq, int (*is_match)(const void*, const void*),
                     const void* param);
 
+/*
+*   @desc:          	Removes the element at position @index, as last reported
+*					through the @set_index callback, and returns its value
+*	@params:        	@pq : pre allocated priority queue.
+*					@index: current position of the element
+*	@return value:		The data of the erased element
+*	@error:			Undefined behavior if @pq or @index is invalid
+*	@time complex:		O(log(n)) for both AC/WC.
+*	@space complex:	O(1) for both AC/WC.
+*/
+void* HeapPQEraseAt(heap_pq_t* heap_pq, size_t index);
+
+/*
+*   @desc:          	Restores the queue order after the priority of the element
+*					at position @index was changed by the user
+*	@params:        	@pq : pre allocated priority queue.
+*					@index: current position of the changed element
+*	@return value:		None
+*	@error:			Undefined behavior if @pq or @index is invalid
+*	@time complex:		O(log(n)) for both AC/WC.
+*	@space complex:	O(1) for both AC/WC.
+*/
+void HeapPQUpdate(heap_pq_t* heap_pq, size_t index);
+
 #endif  /* __HEAP_PQ_H__ */
@@ -6,7 +6,15 @@
 #include <stddef.h>     /* size_t */
 
 #include "uid.h"   		/* uid_t */
+#include "mono_clock.h"		/* mono_time_t */
 
+/*
+* Every function may be called from any thread, including from the tasks
+* themselves, while another thread is blocked in @HeapSchedulerRun. Changes
+* that affect the next wakeup (add, remove, reschedule, stop, destroy) wake
+* the run loop at once instead of at its next deadline. Tasks run without
+* the scheduler's lock held
+*/
 typedef struct heap_scheduler heap_scheduler_t;
 
 typedef enum status
@@ -18,6 +26,41 @@ typedef enum status
     RUNNING = 4		/* to avoid re-run when is already running */
 } status_t;
 
+typedef enum sched_backend
+{
+    SCHED_BACKEND_HEAP = 0,			/* O(log(n)) add/remove, exact deadlines */
+    SCHED_BACKEND_TIMING_WHEEL = 1	/* O(1) add/remove/expire, deadlines
+									   rounded up to 1 ms */
+} sched_backend_t;
+
+/* description of one task for @HeapSchedulerAddBatch */
+typedef struct sched_task
+{
+    int (*action_func)(void* params);
+    void* params;
+    size_t interval_us;
+} sched_task_t;
+
+/* what a periodic task does after its deadlines were missed */
+typedef enum sched_miss_policy
+{
+    SCHED_MISS_CATCH_UP = 0,	/* run once per missed deadline, back to back */
+    SCHED_MISS_SKIP = 1,		/* run once, then continue on the original
+								   grid of deadlines */
+    SCHED_MISS_REALIGN = 2		/* run once, then continue one interval from
+								   that run */
+} sched_miss_policy_t;
+
+/* lateness of the runs of one task, see @HeapSchedulerGetTaskStats */
+typedef struct sched_task_stats
+{
+    size_t num_of_runs;
+    size_t num_of_missed;			/* deadlines dropped by the miss policy */
+    mono_time_t last_lateness_us;   /* start of the last run - its deadline */
+    mono_time_t max_lateness_us;
+    mono_time_t mean_lateness_us;
+} sched_task_stats_t;
+
 /*
 *   @desc:          Allocates new scheduler. must be destroyed with
 *				@SchedulerDestroy
@@ -29,22 +72,42 @@ typedef enum status
 */
 heap_scheduler_t* HeapSchedulerCreate(void);
 
+/*
+*   @desc:          Allocates new scheduler that keeps its tasks in @backend.
+*				@HeapSchedulerCreate is the same as using SCHED_BACKEND_HEAP.
+*				All the other functions behave the same for every backend.
+*				Tasks are allocated from a pool owned by the scheduler, so
+*				once it holds @capacity_hint tasks (or has grown to its
+*				working size) adding and removing tasks doesn't allocate
+*   @params: 		@backend: queue implementation to use
+*				@capacity_hint: number of tasks to preallocate room for,
+*				may be 0
+*   @return value:  Pointer to the new scheduler
+*   @error: 		Returns NULL if allocation fails
+*   @time complex: 	O(capacity_hint) for both AC/WC
+*   @space complex: O(capacity_hint) for both AC/WC
+*/
+heap_scheduler_t* HeapSchedulerCreateEx(sched_backend_t backend,
+										size_t capacity_hint);
+
 /*
 *   @desc:          Destroys and frees @scheduler. In the event the scheduler is
 *				still running it will signal to the scheduler to destroy
 *				itself, after the current task is done running and will
-*				return DESTROYED on	@SchedulerRun return value
+*				return DESTROYED on	@SchedulerRun return value.
+*				With workers, the actions still running are finished first
 *   @params: 		@scheduler: pre allocated scheduler
 *   @return value:  None
 *   @error: 		Undefined behavior if @scheduler is not valid
-*   @time complex: 	O(n) for both AC/WC
+*   @time complex: 	O(1) - the tasks are released with the pool's slabs,
+*				not one by one
 *   @space complex: O(1) for both AC/WC
 */
 void HeapSchedulerDestroy(heap_scheduler_t* heap_scheduler);
 
 /*
 *   @desc:          Adds a new task to @scheduler that will perform @action_func
-*				with @params as params to @action_func and @interval_in_sec
+*				with @params as params to @action_func and @interval_us
 *				which will say the amount of time between each invocation of
 *				@action_func should pass
 *   @params: 		@scheduler: pre allocated scheduler
@@ -53,44 +116,235 @@ void HeapSchedulerDestroy(heap_scheduler_t* heap_scheduler);
 *                   indicate it shouldn't repeat no more.
 *				@params: user pointer to additional data the user might want
 *				to send to the function.
-*				@interval_sec: the amount of seconds that should pass
-*				between each invocation of @action_func
+*				@interval_us: the amount of microseconds that should pass
+*				between each invocation of @action_func. Deadlines are kept
+*				on the monotonic clock, so wall-clock jumps do not affect
+*				them
 *   @return value:  Returns the unique uid of the newly added task.
 *   @error: 		In the event that this function failed to add
 				a new task it will return @bad_uid
 				that is defined externally.
 *				Undefined behavior if @scheduler is not valid or
 *				@action_func is not valid
-*   @time complex: 	O(n) for both AC/WC
+*   @time complex: 	O(log(n)) AC, O(n) WC
 *   @space complex: O(1) for both AC/WC
 */
 uid_t HeapSchedulerAdd(heap_scheduler_t* heap_scheduler,
                             int (*action_func)(void* params),
                             void* params,
-                            size_t interval_sec);
+                            size_t interval_us);
+
+/*
+*   @desc:          Same as @HeapSchedulerAdd, but the new task is identified
+*				by @uid instead of a newly created uid. Lets a caller that
+*				spreads tasks over several schedulers pick the scheduler by
+*				the uid before adding the task
+*   @params: 		@scheduler: pre allocated scheduler
+*				@uid: identifier for the new task, from @UIDCreate
+*				the rest are as in @HeapSchedulerAdd
+*   @return value:  Returns @uid
+*   @error: 		Returns @bad_uid if adding the task failed, if @uid is
+*				@bad_uid or if @scheduler already has a task with @uid
+*				Undefined behavior if @scheduler or @action_func is invalid
+*   @time complex: 	O(log(n)) AC, O(n) WC
+*   @space complex: O(1) for both AC/WC
+*/
+uid_t HeapSchedulerAddWithUID(heap_scheduler_t* heap_scheduler, uid_t uid,
+							  int (*action_func)(void* params),
+							  void* params, size_t interval_us);
+
+/*
+*   @desc:          Adds @count tasks at once, as if each was passed to
+*				@HeapSchedulerAdd, but with the task memory and the lookup
+*				index reserved up front and the queue built in one pass
+*				instead of one insertion per task. Meant for loading a large
+*				schedule, e.g. at startup
+*   @params: 		@scheduler: pre allocated scheduler
+*				@tasks: array of @count task descriptions, every
+*				@action_func must be valid
+*				@count: number of tasks, may be 0
+*				@uids: array of @count uids to receive the uids of the new
+*				tasks in the order of @tasks, or NULL
+*   @return value:  zero on success, nonzero if an allocation failed, in
+*				which case none of the tasks were added
+*   @error: 		Undefined behavior if @scheduler or @tasks is not valid
+*   @time complex: 	O(n + count) when loading into an empty or smaller
+*				scheduler, O(count * log(n)) otherwise
+*   @space complex: O(count) for both AC/WC
+*/
+int HeapSchedulerAddBatch(heap_scheduler_t* heap_scheduler,
+						  const sched_task_t* tasks, size_t count,
+						  uid_t* uids);
 
 /*
 *   @desc:          Removes a task from @scheduler identified by @identifier
 *				In the event that a task requests to remove itself during
 *				it's own run the task will not be found. use	the action
-*				func return value to remove a running task from @scheduler
+*				func return value to remove a running task from @scheduler.
+*				A task whose action is running on another thread, inline
+*				or on a worker, is removed once its action returns and is
+*				not run again
 *   @params: 		@scheduler: pre allocated scheduler
 *				@identifier: identifier to search for task to remove
 *   @return value:  zero if found and removed the task and
 *				nonzero if failed to find the task
 *   @error: 		Undefined behavior if @scheduler is invalid
-*   @time complex: 	O(n) for both AC/WC
+*   @time complex: 	O(log(n)) AC, O(n) WC
 *   @space complex: O(1) for both AC/WC
 */
 int HeapSchedulerRemove(heap_scheduler_t* heap_scheduler, uid_t identifier);
 
+/*
+*   @desc:          Moves the next run of the task identified by @identifier
+*				to @new_time. Later runs follow the task's interval from
+*				@new_time. May be called by the running task on itself
+*   @params: 		@scheduler: pre allocated scheduler
+*				@identifier: identifier of the task to reschedule
+*				@new_time: absolute monotonic time in microseconds
+*				(see @MonoClockNow)
+*   @return value:  zero if the task was found and nonzero otherwise
+*   @error: 		Undefined behavior if @scheduler is invalid
+*   @time complex: 	O(log(n)) AC, O(n) WC
+*   @space complex: O(1) for both AC/WC
+*/
+int HeapSchedulerReschedule(heap_scheduler_t* heap_scheduler, uid_t identifier,
+                            mono_time_t new_time);
+
+/*
+*   @desc:          Lets @scheduler wake up to @slack_us late, so that tasks
+*				whose deadlines fall within that window run together in one
+*				wakeup instead of one wakeup each. Tasks never run before
+*				their deadline. The default is 0 - wake up on time
+*   @params: 		@scheduler: pre allocated scheduler
+*				@slack_us: maximal wakeup delay in microseconds
+*   @return value:  None
+*   @error: 		Undefined behavior if @scheduler is invalid
+*   @time complex: 	O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+void HeapSchedulerSetSlack(heap_scheduler_t* heap_scheduler, size_t slack_us);
+
+/*
+*   @desc:          Makes @scheduler run the actions of due tasks on a pool of
+*				@num_of_workers threads, while the thread in
+*				@HeapSchedulerRun only keeps the deadlines, so a slow action
+*				doesn't delay the tasks due after it. Each task still has at
+*				most one run at a time, but different tasks may run at the
+*				same time. 0 workers, the default, runs the actions on the
+*				@HeapSchedulerRun thread. A task removed while its action
+*				runs on a worker is dropped once the action returns, see
+*				@HeapSchedulerRemove. Must not be called while @scheduler
+*				is running
+*   @params: 		@scheduler: pre allocated scheduler
+*				@num_of_workers: number of threads, may be 0
+*   @return value:  zero on success, nonzero if the threads couldn't be
+*				started, in which case the previous setting stays
+*   @error: 		Undefined behavior if @scheduler is invalid or running
+*   @time complex: 	O(num_of_workers) for both AC/WC
+*   @space complex: O(num_of_workers) for both AC/WC
+*/
+int HeapSchedulerSetWorkers(heap_scheduler_t* heap_scheduler,
+							size_t num_of_workers);
+
+/*
+*   @desc:          Sets what the task identified by @identifier does when the
+*				scheduler falls behind (a slow action, a suspended host ...)
+*				so that more than one of its deadlines already passed.
+*				SCHED_MISS_CATCH_UP, the default, runs it once per missed
+*				deadline. SCHED_MISS_SKIP and SCHED_MISS_REALIGN run it once
+*				and count the rest in the task's statistics. Deadlines never
+*				drift otherwise: each one is the previous plus the interval
+*   @params: 		@scheduler: pre allocated scheduler
+*				@identifier: identifier of the task
+*				@policy: the new policy
+*   @return value:  zero if the task was found and nonzero otherwise
+*   @error: 		Undefined behavior if @scheduler is invalid
+*   @time complex: 	O(1) AC, O(n) WC
+*   @space complex: O(1) for both AC/WC
+*/
+int HeapSchedulerSetMissPolicy(heap_scheduler_t* heap_scheduler,
+							   uid_t identifier, sched_miss_policy_t policy);
+
+/*
+*   @desc:          Reports how late the runs of the task identified by
+*				@identifier started, measured from each run's deadline to
+*				the moment its action was called
+*   @params: 		@scheduler: pre allocated scheduler
+*				@identifier: identifier of the task
+*				@stats: receives the statistics
+*   @return value:  zero if the task was found and nonzero otherwise
+*   @error: 		Undefined behavior if @scheduler or @stats is invalid
+*   @time complex: 	O(1) AC, O(n) WC
+*   @space complex: O(1) for both AC/WC
+*/
+int HeapSchedulerGetTaskStats(const heap_scheduler_t* heap_scheduler,
+							  uid_t identifier, sched_task_stats_t* stats);
+
+/*
+*   @desc:          By default @HeapSchedulerRun returns SUCCESS once there are
+*				no tasks left. When @keep_alive is nonzero it waits for new
+*				tasks instead, and only returns when stopped, destroyed or
+*				on an error. Meant for a scheduler that owns a thread and is
+*				fed from other threads
+*   @params: 		@scheduler: pre allocated scheduler
+*				@keep_alive: nonzero to keep running while empty
+*   @return value:  None
+*   @error: 		Undefined behavior if @scheduler is invalid
+*   @time complex: 	O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+void HeapSchedulerSetKeepAlive(heap_scheduler_t* heap_scheduler,
+							   int keep_alive);
+
+/*
+*   @desc:          Has the run loop call @on_ready whenever @fd is ready for
+*				@events, level triggered. The first watched descriptor
+*				switches the loop from a condition variable wait to an
+*				epoll wait with a timerfd deadline, so timers and I/O are
+*				served by the same thread. @HeapSchedulerRun keeps running
+*				while descriptors are watched. @on_ready is called on the
+*				thread of @HeapSchedulerRun without the scheduler's lock
+*				held, and may unwatch @fd
+*   @params: 		@scheduler: pre allocated scheduler
+*				@fd: open descriptor, not watched yet. It is not closed
+*				by the scheduler
+*				@events: EPOLLIN, EPOLLOUT ... bits to wait for
+*				@on_ready: receives @fd, the ready bits and @params
+*				@params: passed to @on_ready
+*   @return value:  zero on success and nonzero otherwise
+*   @error: 		Returns nonzero if @fd is already watched, cannot be
+*				polled or on allocation failure. Undefined behavior if
+*				@scheduler or @on_ready is invalid
+*   @time complex: 	O(w) for both AC/WC, w the number of watched descriptors
+*   @space complex: O(1) AC, O(w) WC
+*/
+int HeapSchedulerWatchFd(heap_scheduler_t* heap_scheduler, int fd,
+						 unsigned int events,
+						 void (*on_ready)(int fd, unsigned int events,
+										  void* params),
+						 void* params);
+
+/*
+*   @desc:          Stops watching @fd. Must be called before @fd is closed
+*   @params: 		@scheduler: pre allocated scheduler
+*				@fd: descriptor watched with @HeapSchedulerWatchFd
+*   @return value:  zero if @fd was watched and nonzero otherwise
+*   @error: 		Undefined behavior if @scheduler is invalid
+*   @time complex: 	O(w) for both AC/WC, w the number of watched descriptors
+*   @space complex: O(1) for both AC/WC
+*/
+int HeapSchedulerUnwatchFd(heap_scheduler_t* heap_scheduler, int fd);
+
 /*
 *   @desc:          Starts running @scheduler or if already running will return
-*				@RUNNING status code
+*				@RUNNING status code. Every wakeup runs all the tasks that
+*				are due by then as one batch, reading the clock at most once.
+*				A batch runs in deadline order; on the timing wheel, tasks
+*				that fall in the same tick run in the order they were added
 *   @params: 		@scheduler: pre allocated scheduler
 *   @return value:  status code of the running process:
 *				@SUCCESS means it ended successfully without getting called
-*				to stop
+*				to stop, there were no tasks left
 *				@STOPPED means a function called for the scheduler to stop
 *				@ERROR means an error accored mid running of the scheduler
 *				@DESTROYED means a function called for destroy during the
@@ -102,7 +356,11 @@ int HeapSchedulerRemove(heap_scheduler_t* heap_scheduler, uid_t identifier);
 status_t HeapSchedulerRun(heap_scheduler_t* heap_scheduler);
 
 /*
-*   @desc:          Sends a signal to the scheduler to stop @scheduler
+*   @desc:          Sends a signal to the scheduler to stop @scheduler. A run
+*				blocked waiting for its next task returns right away, a
+*				running task is finished first. If @scheduler isn't running
+*				the stop stays pending, and the next @HeapSchedulerRun
+*				returns @STOPPED without running any task
 *   @params: 		@scheduler: pre allocated scheduler
 *   @return value:  None
 *   @error: 		Undefined behavior if @scheduler is invalid
@@ -112,7 +370,8 @@ status_t HeapSchedulerRun(heap_scheduler_t* heap_scheduler);
 void HeapSchedulerStop(heap_scheduler_t* heap_scheduler);
 
 /*
-*   @desc:          Counts the amount of tasks currently in @scheduler
+*   @desc:          Counts the amount of tasks currently in @scheduler,
+*				not including the tasks whose action is running
 *   @params: 		@scheduler: pre allocated scheduler
 *   @return value:  Returns the count of tasks in @scheduler
 *   @error: 		Undefined behavior if @scheduler is invalid
@@ -134,7 +393,8 @@ int HeapSchedulerIsEmpty(const heap_scheduler_t* heap_scheduler);
 
 /*
 *   @desc:          Removes all tasks from @scheduler. If it is called from
-*				a task it will remove all the tasks besides the caller
+*				a task it will remove all the tasks besides the caller, and
+*				besides any other task running on a worker at the time
 *   @params: 		@scheduler: pre allocated scheduler
 *   @return value:  None
 *   @error: 		Undefined behavior if scheduler is invalid
@@ -0,0 +1,53 @@
+/* mono_clock.h */
+
+#ifndef __MONO_CLOCK_H__
+#define __MONO_CLOCK_H__
+
+#include <stdint.h>         /* uint64_t */
+#include <time.h>           /* struct timespec */
+
+#define MONO_USEC_PER_MSEC (1000)
+#define MONO_USEC_PER_SEC (1000000)
+
+/* microseconds on CLOCK_MONOTONIC, unaffected by wall-clock jumps */
+typedef uint64_t mono_time_t;
+
+/* <time.h> declares it only under a POSIX feature test macro */
+struct timespec;
+
+/*
+*   @desc:          Reads the monotonic clock
+*   @params: 		None
+*   @return value:  Current monotonic time in microseconds
+*   @error: 		None
+*   @time complex: 	O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+mono_time_t MonoClockNow(void);
+
+/*
+*   @desc:          Sleeps until the monotonic clock reaches @deadline. Returns
+*				immediately if @deadline already passed
+*   @params: 		@deadline: absolute monotonic time in microseconds
+*   @return value:  zero if @deadline was reached, nonzero if the sleep was
+*				interrupted by a signal handler before @deadline
+*   @error: 		None
+*   @time complex: 	O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+int MonoClockSleepUntil(mono_time_t deadline);
+
+/*
+*   @desc:          Converts @time to a timespec, for absolute timeouts of
+*				waits on CLOCK_MONOTONIC (e.g. pthread_cond_timedwait with a
+*				monotonic condition attribute)
+*   @params: 		@time: monotonic time in microseconds
+*				@ts: receives @time
+*   @return value:  None
+*   @error: 		Undefined behavior if @ts is invalid
+*   @time complex: 	O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+void MonoClockToTimespec(mono_time_t time, struct timespec* ts);
+
+#endif /* __MONO_CLOCK_H__ */
@@ -0,0 +1,121 @@
+/* sharded_scheduler.h */
+
+#ifndef __SHARDED_SCHEDULER_H__
+#define __SHARDED_SCHEDULER_H__
+
+#include <stddef.h>             /* size_t */
+
+#include "uid.h"                /* uid_t */
+#include "heap_scheduler.h"     /* heap_scheduler_t, sched_backend_t */
+
+/*
+*   Several independent schedulers (shards), each run by its own thread that
+*   is pinned to a CPU. A task belongs to the shard picked by the hash of its
+*   uid, so adding and removing a task only takes the lock of its own shard
+*   and the shards never wait for each other.
+*/
+typedef struct sharded_scheduler sharded_scheduler_t;
+
+/*
+*   @desc:          Allocates @num_of_shards schedulers on @backend. Must be
+*				destroyed with @ShardedSchedulerDestroy
+*   @params: 		@num_of_shards: number of shards, must be nonzero
+*				@backend: queue implementation of every shard
+*   @return value:  Pointer to the new sharded scheduler
+*   @error: 		Returns NULL if allocation fails
+*   @time complex: 	O(num_of_shards) for both AC/WC
+*   @space complex: O(num_of_shards) for both AC/WC
+*/
+sharded_scheduler_t* ShardedSchedulerCreate(size_t num_of_shards,
+											sched_backend_t backend);
+
+/*
+*   @desc:          Stops @sharded if it was started, then frees it with all
+*				of its tasks
+*   @params: 		@sharded: pre allocated sharded scheduler
+*   @return value:  None
+*   @error: 		Must not be called from a task
+*   @time complex: 	O(num_of_shards) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+void ShardedSchedulerDestroy(sharded_scheduler_t* sharded);
+
+/*
+*   @desc:          Starts one thread per shard, shard i pinned to CPU
+*				i % number of online CPUs. The shards keep running while
+*				empty, until @ShardedSchedulerStop
+*   @params: 		@sharded: pre allocated sharded scheduler, not started
+*   @return value:  zero on success, nonzero if a thread couldn't be started,
+*				in which case none is left running
+*   @error: 		Undefined behavior if @sharded is invalid or started
+*   @time complex: 	O(num_of_shards) for both AC/WC
+*   @space complex: O(num_of_shards) for both AC/WC
+*/
+int ShardedSchedulerStart(sharded_scheduler_t* sharded);
+
+/*
+*   @desc:          Stops every shard and waits for their threads. The tasks
+*				stay, a later @ShardedSchedulerStart continues them
+*   @params: 		@sharded: pre allocated sharded scheduler
+*   @return value:  zero if every shard ended with STOPPED, nonzero if any of
+*				them ended on an error
+*   @error: 		Must not be called from a task. Does nothing if @sharded
+*				isn't started
+*   @time complex: 	O(num_of_shards) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+int ShardedSchedulerStop(sharded_scheduler_t* sharded);
+
+/*
+*   @desc:          Adds a task to the shard that owns its uid, see
+*				@HeapSchedulerAdd. May be called from any thread, before or
+*				after @ShardedSchedulerStart
+*   @params: 		@sharded: pre allocated sharded scheduler
+*				the rest are as in @HeapSchedulerAdd
+*   @return value:  Returns the uid of the new task
+*   @error: 		Returns @bad_uid if adding the task failed
+*   @time complex: 	O(log(n / num_of_shards)) AC, O(n) WC
+*   @space complex: O(1) for both AC/WC
+*/
+uid_t ShardedSchedulerAdd(sharded_scheduler_t* sharded,
+						  int (*action_func)(void* params), void* params,
+						  size_t interval_us);
+
+/*
+*   @desc:          Removes a task from the shard that owns @identifier, see
+*				@HeapSchedulerRemove. May be called from any thread
+*   @params: 		@sharded: pre allocated sharded scheduler
+*				@identifier: uid returned by @ShardedSchedulerAdd
+*   @return value:  zero if found and removed the task and nonzero otherwise
+*   @error: 		Undefined behavior if @sharded is invalid
+*   @time complex: 	O(log(n / num_of_shards)) AC, O(n) WC
+*   @space complex: O(1) for both AC/WC
+*/
+int ShardedSchedulerRemove(sharded_scheduler_t* sharded, uid_t identifier);
+
+/*
+*   @desc:          Counts the tasks of all the shards, see
+*				@HeapSchedulerSize
+*   @params: 		@sharded: pre allocated sharded scheduler
+*   @return value:  Number of tasks
+*   @error: 		Undefined behavior if @sharded is invalid
+*   @time complex: 	O(num_of_shards) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+size_t ShardedSchedulerSize(const sharded_scheduler_t* sharded);
+
+/*
+*   @desc:          Returns the shard that owns @identifier, for the
+*				@HeapScheduler functions that have no sharded counterpart
+*				(reschedule, statistics ...)
+*   @params: 		@sharded: pre allocated sharded scheduler
+*				@identifier: uid of a task
+*   @return value:  The owning shard
+*   @error: 		Undefined behavior if @sharded is invalid
+*   @time complex: 	O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+heap_scheduler_t* ShardedSchedulerShardOf(const sharded_scheduler_t* sharded,
+										  uid_t identifier);
+
+#endif /* __SHARDED_SCHEDULER_H__ */
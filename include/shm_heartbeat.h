@@ -0,0 +1,86 @@
+/* shm_heartbeat.h */
+
+#ifndef __SHM_HEARTBEAT_H__
+#define __SHM_HEARTBEAT_H__
+
+#include <stddef.h>         /* size_t */
+#include <stdint.h>         /* uint64_t */
+
+/*
+*   Heartbeat channel between two processes over one shared memory page.
+*   Each side owns a sequence counter on its own cache line: a beat is one
+*   atomic store to it, and checking on the peer is one atomic load of the
+*   other - no system call and nothing delivered to the peer. The page lives
+*   in an anonymous memory file whose descriptor is inherited over fork and
+*   exec, so a restarted process joins the same channel.
+*/
+typedef struct shm_heartbeat shm_heartbeat_t;
+
+typedef enum shm_heartbeat_side
+{
+    SHM_HEARTBEAT_SIDE_A = 0,
+    SHM_HEARTBEAT_SIDE_B = 1
+} shm_heartbeat_side_t;
+
+/*
+*   @desc:          Creates the memory file of a new channel, both counters
+*				at zero. The descriptor is left open on exec, so that child
+*				processes can pass it to @ShmHeartbeatCreate
+*   @params: 		None
+*   @return value:  The descriptor
+*   @error: 		Returns -1 if neither memfd_create nor shm_open works
+*   @time complex: 	O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+int ShmHeartbeatCreateFd(void);
+
+/*
+*   @desc:          Maps the channel of @fd and joins it as @side. The
+*				descriptor stays open and owned by the caller. Must be
+*				destroyed with @ShmHeartbeatDestroy
+*   @params: 		@fd: descriptor from @ShmHeartbeatCreateFd, in this
+*				process or inherited
+*				@side: the counter this process beats on, the peer takes
+*				the other one
+*   @return value:  Pointer to the new handle
+*   @error: 		Returns NULL if @fd is not a heartbeat channel, cannot be
+*				mapped, or on allocation failure
+*   @time complex: 	O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+shm_heartbeat_t* ShmHeartbeatCreate(int fd, shm_heartbeat_side_t side);
+
+/*
+*   @desc:          Unmaps the page and frees @heartbeat. The descriptor is not
+*				closed
+*   @params: 		@heartbeat: handle created with @ShmHeartbeatCreate
+*   @return value:  None
+*   @error: 		None
+*   @time complex: 	O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+void ShmHeartbeatDestroy(shm_heartbeat_t* heartbeat);
+
+/*
+*   @desc:          Advances this side's counter. Async signal safe
+*   @params: 		@heartbeat: handle created with @ShmHeartbeatCreate
+*   @return value:  None
+*   @error: 		Undefined behavior if @heartbeat is invalid, or if two
+*				processes beat on the same side
+*   @time complex: 	O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+void ShmHeartbeatBeat(shm_heartbeat_t* heartbeat);
+
+/*
+*   @desc:          Returns the peer's counter. It has beaten since an earlier
+*				call if the value differs
+*   @params: 		@heartbeat: handle created with @ShmHeartbeatCreate
+*   @return value:  The number of beats of the other side so far
+*   @error: 		Undefined behavior if @heartbeat is invalid
+*   @time complex: 	O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+uint64_t ShmHeartbeatPeer(const shm_heartbeat_t* heartbeat);
+
+#endif /* __SHM_HEARTBEAT_H__ */
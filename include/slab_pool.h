@@ -0,0 +1,75 @@
+/* slab_pool.h */
+
+#ifndef __SLAB_POOL_H__
+#define __SLAB_POOL_H__
+
+#include <stddef.h>         /* size_t */
+
+/*
+*   Fixed-size object allocator. Objects are carved out of large slabs and
+*   recycled through an intrusive free list, so once the pool has grown to
+*   its working size allocating and freeing an object never calls malloc or
+*   free. Slabs are only released when the pool itself is destroyed.
+*/
+typedef struct slab_pool slab_pool_t;
+
+/*
+*   @desc:          Allocates an empty pool of @elem_size objects
+*   @params: 		@elem_size: size in bytes of every object, must be nonzero
+*				@capacity_hint: number of objects to preallocate in the
+*				first slab, may be 0
+*   @return value:  Pointer to the new pool
+*   @error: 		Returns NULL if allocation fails
+*   @time complex: 	O(capacity_hint) for both AC/WC
+*   @space complex: O(capacity_hint) for both AC/WC
+*/
+slab_pool_t* SlabPoolCreate(size_t elem_size, size_t capacity_hint);
+
+/*
+*   @desc:          Releases every slab of @pool. Objects still allocated from
+*				@pool become invalid, they don't need to be freed first
+*   @params: 		@pool: pool created with @SlabPoolCreate
+*   @return value:  None
+*   @error: 		None
+*   @time complex: 	O(number of slabs) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+void SlabPoolDestroy(slab_pool_t* pool);
+
+/*
+*   @desc:          Returns an uninitialized object from @pool, allocating a
+*				new slab, as large as all the previous slabs together,
+*				when the free list is empty
+*   @params: 		@pool: pre allocated pool
+*   @return value:  Pointer to the object
+*   @error: 		Returns NULL if a new slab was needed and malloc failed
+*   @time complex: 	AC - O(1), WC - O(size of the new slab)
+*   @space complex: AC - O(1), WC - O(size of the new slab)
+*/
+void* SlabPoolAlloc(slab_pool_t* pool);
+
+/*
+*   @desc:          Returns @elem to @pool for reuse
+*   @params: 		@pool: pre allocated pool
+*				@elem: object allocated from @pool
+*   @return value:  None
+*   @error: 		Undefined behavior if @elem wasn't allocated from @pool
+*   @time complex: 	O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+void SlabPoolFree(slab_pool_t* pool, void* elem);
+
+/*
+*   @desc:          Makes sure the next @count calls to @SlabPoolAlloc succeed
+*				without allocating, by adding one slab for whatever the free
+*				list is missing
+*   @params: 		@pool: pre allocated pool
+*				@count: number of objects about to be allocated
+*   @return value:  zero on success, nonzero if malloc failed
+*   @error: 		None
+*   @time complex: 	O(1) if enough objects are free, else O(count)
+*   @space complex: O(1) if enough objects are free, else O(count)
+*/
+int SlabPoolReserve(slab_pool_t* pool, size_t count);
+
+#endif /* __SLAB_POOL_H__ */
@@ -6,27 +6,90 @@
 #include <stddef.h>  	 	/* size_t */
 
 #include "uid.h"			/* uid_t */
+#include "mono_clock.h"		/* mono_time_t */
+#include "slab_pool.h"		/* slab_pool_t */
 
 typedef struct task task_t;
 
+/* what @TaskAdvance does with the deadlines that already passed */
+typedef enum task_miss_policy
+{
+    TASK_MISS_CATCH_UP = 0,     /* run once for every one of them */
+    TASK_MISS_SKIP = 1,         /* drop them, keep the interval grid */
+    TASK_MISS_REALIGN = 2       /* drop them, start a new grid from now */
+} task_miss_policy_t;
+
+/* how late the runs of a task started relative to their deadlines */
+typedef struct task_stats
+{
+    size_t num_of_runs;
+    mono_time_t last_lateness_us;
+    mono_time_t max_lateness_us;
+    mono_time_t total_lateness_us;
+    size_t num_of_missed;       /* deadlines dropped by the miss policy */
+} task_stats_t;
+
 /*
 *   @desc:          Allocates new task must be destroyed with @TaskDestroy
 *   @params: 		@action_func: the function the task will call when it runs
 *				will return 0 if it should repeat using the interval or
 *				non zero value to indicate it shouldn't repeat no more.
 *				@params: user params to send into @action_func
-*				@interval_sec: the amount of time that should pass between
-*				each invocation of @action_func
+*				@interval_us: the amount of microseconds that should pass
+*				between each invocation of @action_func
 *   @return value:  Pointer to the new task
 *   @error: 		Returns NULL if the allocation fails
 *   @time complex: 	O(malloc) for both AC/WC
 *   @space complex: O(malloc) for both AC/WC
 */
 task_t* TaskCreate(int (*action_func)(void* params), void* params,
-			    size_t interval_sec);
+			    size_t interval_us);
+
+/*
+*   @desc:          Same as @TaskCreate, but takes the task's memory from
+*				@pool instead of malloc. @TaskDestroy returns it to @pool
+*   @params: 		@pool: pool created with @TaskPoolCreate
+*				the rest are as in @TaskCreate
+*   @return value:  Pointer to the new task
+*   @error: 		Returns NULL if the pool couldn't grow
+*   @time complex: 	AC - O(1), WC - O(size of a new slab)
+*   @space complex: AC - O(1), WC - O(size of a new slab)
+*/
+task_t* TaskCreateFromPool(slab_pool_t* pool,
+				int (*action_func)(void* params), void* params,
+				size_t interval_us);
+
+/*
+*   @desc:          Same as @TaskCreateFromPool, but the task gets @uid
+*				instead of a newly created one, for owners that have to know
+*				the uid before the task exists
+*   @params: 		@pool: pool created with @TaskPoolCreate
+*				@uid: identifier of the new task, must not be @bad_uid
+*				the rest are as in @TaskCreate
+*   @return value:  Pointer to the new task
+*   @error: 		Returns NULL if the pool couldn't grow or @uid is @bad_uid
+*   @time complex: 	AC - O(1), WC - O(size of a new slab)
+*   @space complex: AC - O(1), WC - O(size of a new slab)
+*/
+task_t* TaskCreateFromPoolWithUID(slab_pool_t* pool, uid_t uid,
+				int (*action_func)(void* params), void* params,
+				size_t interval_us);
+
+/*
+*   @desc:          Allocates a pool of task sized objects for
+*				@TaskCreateFromPool. Destroy it with @SlabPoolDestroy, which
+*				also releases every task still allocated from it
+*   @params: 		@capacity_hint: number of tasks to preallocate, may be 0
+*   @return value:  Pointer to the new pool
+*   @error: 		Returns NULL if allocation fails
+*   @time complex: 	O(capacity_hint) for both AC/WC
+*   @space complex: O(capacity_hint) for both AC/WC
+*/
+slab_pool_t* TaskPoolCreate(size_t capacity_hint);
 
 /*
 *   @desc:          Frees allocated task which was created using @TaskCreate
+*				or @TaskCreateFromPool
 *   @params: 		@task: pre allocated task
 *   @return value:  None
 *   @error: 		None
@@ -47,6 +110,113 @@ void TaskDestroy(task_t* task);
 */
 int TaskRun(task_t* task);
 
+/*
+*   @desc:          Moves @task's next scheduled run time one interval ahead,
+*				the first half of @TaskRun. Lets the owner of @task update
+*				it before handing the action to another thread. Deadlines are
+*				always advanced from the previous deadline, never from the
+*				time of the run, so they don't drift. If the new deadline
+*				is already at or before @now, the task's miss policy decides
+*				whether it stays (catch up) or is moved past @now
+*   @params: 		@task: pre allocated task
+*				@now: monotonic time the run starts at
+*   @return value:  None
+*   @error: 		Undefined behavior if @task is invalid
+*   @time complex: 	O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+void TaskAdvance(task_t* task, mono_time_t now);
+
+/*
+*   @desc:          Sets how @TaskAdvance treats deadlines that already passed,
+*				see @task_miss_policy_t. The default is TASK_MISS_CATCH_UP
+*   @params: 		@task: pre allocated task
+*				@policy: the new policy
+*   @return value:  None
+*   @error: 		Undefined behavior if @task is invalid
+*   @time complex: 	O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+void TaskSetMissPolicy(task_t* task, task_miss_policy_t policy);
+
+/*
+*   @desc:          Runs the action of @task without touching its schedule,
+*				the second half of @TaskRun
+*   @params: 		@task: pre allocated task
+*   @return value:  Returns the @task's action return value which was described
+*				@TaskCreate
+*   @error: 		Undefined behavior if @task is invalid
+*   @time complex: 	O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+int TaskExecute(const task_t* task);
+
+/*
+*   @desc:          Adds one run that started @lateness_us after its deadline
+*				to the statistics of @task
+*   @params: 		@task: pre allocated task
+*				@lateness_us: start time minus deadline, in microseconds
+*   @return value:  None
+*   @error: 		Undefined behavior if @task is invalid
+*   @time complex: 	O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+void TaskRecordLateness(task_t* task, mono_time_t lateness_us);
+
+/*
+*   @desc:          Copies the run statistics of @task into @stats
+*   @params: 		@task: pre allocated task
+*				@stats: receives the statistics
+*   @return value:  None
+*   @error: 		Undefined behavior if @task or @stats is invalid
+*   @time complex: 	O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+void TaskGetStats(const task_t* task, task_stats_t* stats);
+
+/*
+*   @desc:          Marks whether @task is currently out of its queue because
+*				its action is running
+*   @params: 		@task: pre allocated task
+*				@is_running: 1 while the action runs, 0 otherwise
+*   @return value:  None
+*   @error: 		Undefined behavior if @task is invalid
+*   @time complex: 	O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+void TaskSetRunning(task_t* task, int is_running);
+
+/*
+*   @desc:          Returns the mark last stored with @TaskSetRunning
+*   @params: 		@task: pre allocated task
+*   @return value:  1 if @task is marked as running and 0 otherwise
+*   @error: 		Undefined behavior if @task is invalid
+*   @time complex: 	O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+int TaskIsRunning(const task_t* task);
+
+/*
+*   @desc:          Marks @task to be dropped once its running action returns,
+*				instead of going back to its queue
+*   @params: 		@task: pre allocated task, marked as running
+*   @return value:  None
+*   @error: 		Undefined behavior if @task is invalid
+*   @time complex: 	O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+void TaskSetRemoved(task_t* task);
+
+/*
+*   @desc:          Returns whether @task was marked with @TaskSetRemoved
+*   @params: 		@task: pre allocated task
+*   @return value:  1 if @task is marked as removed and 0 otherwise
+*   @error: 		Undefined behavior if @task is invalid
+*   @time complex: 	O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+int TaskIsRemoved(const task_t* task);
+
 /*
 *   @desc:          Returns the @task's unique identifier for identification
 *   @params: 		@task: pre allocated task
@@ -60,12 +230,25 @@ uid_t TaskGetUID(const task_t* task);
 /*
 *   @desc:          Returns @task's next scheduled run time
 *   @params: 		@task: pre allocated task
-*   @return value:  Returns the task's next scheduled run time
+*   @return value:  Returns the task's next scheduled run time as monotonic
+*				time in microseconds
 *   @error: 		Undefined behavior if @task is invalid
 *   @time complex: 	O(1) for both AC/WC
 *   @space complex: O(1) for both AC/WC
 */
-size_t TaskGetScheduledTime(const task_t* task);
+mono_time_t TaskGetScheduledTime(const task_t* task);
+
+/*
+*   @desc:          Overrides @task's next scheduled run time. The following
+*				runs keep using the task's interval from @time_to_run
+*   @params: 		@task: pre allocated task
+*				@time_to_run: monotonic time in microseconds
+*   @return value:  None
+*   @error: 		Undefined behavior if @task is invalid
+*   @time complex: 	O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+void TaskSetScheduledTime(task_t* task, mono_time_t time_to_run);
 
 /*
 *   @desc:          Returns if @task1 and @task2 are the same task
@@ -77,4 +260,26 @@ size_t TaskGetScheduledTime(const task_t* task);
 */
 int TaskIsEqual(const task_t* task1, const task_t* task2);
 
+/*
+*   @desc:          Stores the current position of @task inside the queue that
+*				holds it, so the queue can locate it without searching
+*   @params: 		@task: pre allocated task
+*				@index: position of @task in its queue
+*   @return value:  None
+*   @error: 		Undefined behavior if @task is invalid
+*   @time complex: 	O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+void TaskSetQueueIndex(task_t* task, size_t index);
+
+/*
+*   @desc:          Returns the position last stored with @TaskSetQueueIndex
+*   @params: 		@task: pre allocated task
+*   @return value:  Position of @task in its queue
+*   @error: 		Undefined behavior if @task is invalid
+*   @time complex: 	O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+size_t TaskGetQueueIndex(const task_t* task);
+
 #endif /* __TASK_H__ */
@@ -0,0 +1,122 @@
+/* timing_wheel.h */
+
+#ifndef __TIMING_WHEEL_H__
+#define __TIMING_WHEEL_H__
+
+#include <stddef.h>         /* size_t */
+
+#include "task.h"           /* task_t */
+#include "mono_clock.h"     /* mono_time_t */
+
+/*
+*   Hierarchical timing wheel of tasks keyed by scheduled time: 5 levels of
+*   64 slots each (2^30 ticks), plus an overflow list for later deadlines.
+*   Deadlines are rounded up to a whole tick, so a task never expires early.
+*   The node of every task is stored with @TaskSetQueueIndex.
+*/
+typedef struct timing_wheel timing_wheel_t;
+
+/*
+*   @desc:          Allocates an empty timing wheel
+*   @params: 		@tick_us: wheel resolution in microseconds
+*				@now: current monotonic time, the wheel starts there
+*   @return value:  Pointer to the new wheel
+*   @error: 		Returns NULL if allocation fails
+*   @time complex: 	O(malloc) for both AC/WC
+*   @space complex: O(malloc) for both AC/WC
+*/
+timing_wheel_t* TimingWheelCreate(mono_time_t tick_us, mono_time_t now);
+
+/*
+*   @desc:          Frees @wheel. The tasks it holds are not freed
+*   @params: 		@wheel: wheel created with @TimingWheelCreate
+*   @return value:  None
+*   @error: 		Undefined behavior if @wheel is invalid
+*   @time complex: 	O(free) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+void TimingWheelDestroy(timing_wheel_t* wheel);
+
+/*
+*   @desc:          Inserts @task keyed by its current scheduled time
+*   @params: 		@wheel: pre allocated wheel
+*				@task: task to insert
+*   @return value:  zero on success, nonzero if growing the node pool failed
+*   @error: 		Undefined behavior if @wheel or @task is invalid
+*   @time complex: 	O(1) AC, O(n) WC
+*   @space complex: O(1) AC, O(n) WC
+*/
+int TimingWheelAdd(timing_wheel_t* wheel, task_t* task);
+
+/*
+*   @desc:          Removes @task from @wheel
+*   @params: 		@wheel: pre allocated wheel
+*				@task: task currently held by @wheel
+*   @return value:  None
+*   @error: 		Undefined behavior if @task is not in @wheel
+*   @time complex: 	O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+void TimingWheelRemove(timing_wheel_t* wheel, task_t* task);
+
+/*
+*   @desc:          Moves @task to the slot of its current scheduled time
+*   @params: 		@wheel: pre allocated wheel
+*				@task: task currently held by @wheel
+*   @return value:  None
+*   @error: 		Undefined behavior if @task is not in @wheel
+*   @time complex: 	O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+void TimingWheelUpdate(timing_wheel_t* wheel, task_t* task);
+
+/*
+*   @desc:          Advances @wheel to @now and removes one task whose
+*				deadline has passed. Tasks come out in the order of their
+*				ticks, also when one call passes several ticks; a task
+*				added or updated to a passed deadline comes after those
+*				already expired
+*   @params: 		@wheel: pre allocated wheel
+*				@now: current monotonic time
+*   @return value:  An expired task, or NULL if none is due
+*   @error: 		Undefined behavior if @wheel is invalid
+*   @time complex: 	O(1) amortized per expired task and per non-empty slot
+*				passed
+*   @space complex: O(1) for both AC/WC
+*/
+task_t* TimingWheelPopExpired(timing_wheel_t* wheel, mono_time_t now);
+
+/*
+*   @desc:          Removes an arbitrary task, regardless of its deadline
+*   @params: 		@wheel: pre allocated, non empty wheel
+*   @return value:  The removed task
+*   @error: 		Undefined behavior if @wheel is invalid or empty
+*   @time complex: 	O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+task_t* TimingWheelPopAny(timing_wheel_t* wheel);
+
+/*
+*   @desc:          Returns the time @wheel next needs to be advanced: either
+*				a deadline or an internal cascade point. Waking earlier than
+*				the real deadline is harmless, @TimingWheelPopExpired then
+*				returns NULL
+*   @params: 		@wheel: pre allocated, non empty wheel
+*   @return value:  Monotonic time to wake up at
+*   @error: 		Undefined behavior if @wheel is invalid or empty
+*   @time complex: 	O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+mono_time_t TimingWheelNextExpiry(const timing_wheel_t* wheel);
+
+/*
+*   @desc:          Returns the number of tasks in @wheel
+*   @params: 		@wheel: pre allocated wheel
+*   @return value:  Number of tasks
+*   @error: 		Undefined behavior if @wheel is invalid
+*   @time complex: 	O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+size_t TimingWheelSize(const timing_wheel_t* wheel);
+
+#endif /* __TIMING_WHEEL_H__ */
@@ -3,33 +3,40 @@
 #ifndef __UID_H__
 #define __UID_H__
 
-#include <time.h>           /* time_t, strftime */
-#include <sys/types.h>      /* pid_t , size_t */
+#include <stdint.h>         /* uint64_t */
 
+#define UID_STR_SIZE (33)   /* 32 hex digits + '\0' */
+#define UID_BIN_SIZE (16)
 
+/*
+*   Packed 128-bit unique identifier:
+*   @hi: node id (32 bits, folded network address) | pid (32 bits)
+*   @lo: creation time in seconds (32 bits) | per-process counter (32 bits)
+*/
 typedef struct
 {
-    time_t time;
-    size_t counter;
-    pid_t pid;
-    unsigned char ip[14];
+    uint64_t hi;
+    uint64_t lo;
 } uid_t;
 
 extern const uid_t bad_uid;
 
 /*
-*   @desc:          Create Unique UID.
+*   @desc:          Create Unique UID. The node identity (network address and
+*                   pid) is resolved once per process and refreshed in the
+*                   child after fork, so creating a UID costs only an atomic
+*                   increment and a clock read.
 *   @params: 		None.
 *   @return value:  Unique ID by value.
 *   @error: 		Returns bad_uid if failed to create the UID.
-*   @time complex: 	O(n)
-*   @space complex: O(n)
+*   @time complex: 	O(1), O(n) on the first call in a process
+*   @space complex: O(1), O(n) on the first call in a process
 */
 uid_t UIDCreate(void);
 
 
 /*
-*   @desc:          Checks if the uids are the same
+*   @desc:          Checks if the uids are the same (branch-free)
 *   @params: 		@uid1: Unique ID
 *                   @uid2: Unique ID
 *   @return value:  1 if they are the same otherwise 0
@@ -39,4 +46,63 @@ uid_t UIDCreate(void);
 */
 int UIDIsSame(uid_t uid1, uid_t uid2);
 
+
+/*
+*   @desc:          Hashes @uid. The result depends only on the value of @uid,
+*                   so it is stable across processes and runs.
+*   @params: 		@uid: Unique ID
+*   @return value:  64-bit hash of @uid
+*   @error: 		None
+*   @time complex: 	O(1)
+*   @space complex: O(1)
+*/
+uint64_t UIDHash(uid_t uid);
+
+
+/*
+*   @desc:          Encodes @uid as 32 lowercase hex digits
+*   @params: 		@uid: Unique ID
+*                   @dest: buffer of at least UID_STR_SIZE chars
+*   @return value:  None
+*   @error: 		Undefined behavior if @dest is too small
+*   @time complex: 	O(1)
+*   @space complex: O(1)
+*/
+void UIDToString(uid_t uid, char* dest);
+
+
+/*
+*   @desc:          Decodes a UID written by @UIDToString
+*   @params: 		@str: string of 32 hex digits
+*                   @uid: output UID
+*   @return value:  0 on success, 1 if @str is not a valid encoding
+*   @error: 		Undefined behavior if @str or @uid is NULL
+*   @time complex: 	O(1)
+*   @space complex: O(1)
+*/
+int UIDFromString(const char* str, uid_t* uid);
+
+
+/*
+*   @desc:          Encodes @uid as UID_BIN_SIZE bytes in network byte order
+*   @params: 		@uid: Unique ID
+*                   @dest: buffer of at least UID_BIN_SIZE bytes
+*   @return value:  None
+*   @error: 		Undefined behavior if @dest is too small
+*   @time complex: 	O(1)
+*   @space complex: O(1)
+*/
+void UIDToBytes(uid_t uid, unsigned char* dest);
+
+
+/*
+*   @desc:          Decodes a UID written by @UIDToBytes
+*   @params: 		@src: buffer of UID_BIN_SIZE bytes
+*   @return value:  The decoded UID
+*   @error: 		Undefined behavior if @src is too small
+*   @time complex: 	O(1)
+*   @space complex: O(1)
+*/
+uid_t UIDFromBytes(const unsigned char* src);
+
 #endif	/* __UID_H__ */
@@ -0,0 +1,99 @@
+/* uid_map.h */
+
+#ifndef __UID_MAP_H__
+#define __UID_MAP_H__
+
+#include <stddef.h>     /* size_t */
+
+#include "uid.h"        /* uid_t */
+
+typedef struct uid_map uid_map_t;
+
+/*
+*   @desc:          Allocates a hash map from uid_t keys to user pointers
+*				(open addressing, linear probing)
+*   @params: 		@capacity_hint: expected number of entries, may be 0
+*   @return value:  Pointer to the new map
+*   @error: 		Returns NULL if allocation fails
+*   @time complex: 	O(malloc) for both AC/WC
+*   @space complex: O(capacity_hint) for both AC/WC
+*/
+uid_map_t* UIDMapCreate(size_t capacity_hint);
+
+/*
+*   @desc:          Frees @map. The stored values are not freed
+*   @params: 		@map: map created with @UIDMapCreate
+*   @return value:  None
+*   @error: 		Undefined behavior if @map is invalid
+*   @time complex: 	O(free) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+void UIDMapDestroy(uid_map_t* map);
+
+/*
+*   @desc:          Grows @map once so that @count more keys can be inserted
+*				without rehashing
+*   @params: 		@map: pre allocated map
+*				@count: number of keys about to be inserted
+*   @return value:  zero on success, nonzero if growing the map failed
+*   @error: 		Undefined behavior if @map is invalid
+*   @time complex: 	O(1) if no growth is needed, else O(n + count)
+*   @space complex: O(1) if no growth is needed, else O(n + count)
+*/
+int UIDMapReserve(uid_map_t* map, size_t count);
+
+/*
+*   @desc:          Inserts or replaces the value of @key
+*   @params: 		@map: pre allocated map
+*				@key: uid to insert, must not be @bad_uid
+*				@value: non NULL user pointer
+*   @return value:  zero on success, nonzero if growing the map failed
+*   @error: 		Undefined behavior if @map is invalid or @value is NULL
+*   @time complex: 	O(1) AC, O(n) WC
+*   @space complex: O(1) AC, O(n) WC
+*/
+int UIDMapInsert(uid_map_t* map, uid_t key, void* value);
+
+/*
+*   @desc:          Looks up @key
+*   @params: 		@map: pre allocated map
+*				@key: uid to look for
+*   @return value:  The value stored for @key or NULL if not found
+*   @error: 		Undefined behavior if @map is invalid
+*   @time complex: 	O(1) AC, O(n) WC
+*   @space complex: O(1) for both AC/WC
+*/
+void* UIDMapFind(const uid_map_t* map, uid_t key);
+
+/*
+*   @desc:          Removes @key from @map
+*   @params: 		@map: pre allocated map
+*				@key: uid to remove
+*   @return value:  The value that was stored for @key or NULL if not found
+*   @error: 		Undefined behavior if @map is invalid
+*   @time complex: 	O(1) AC, O(n) WC
+*   @space complex: O(1) for both AC/WC
+*/
+void* UIDMapRemove(uid_map_t* map, uid_t key);
+
+/*
+*   @desc:          Returns the number of entries in @map
+*   @params: 		@map: pre allocated map
+*   @return value:  Number of entries
+*   @error: 		Undefined behavior if @map is invalid
+*   @time complex: 	O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+size_t UIDMapSize(const uid_map_t* map);
+
+/*
+*   @desc:          Removes all entries from @map, keeping its capacity
+*   @params: 		@map: pre allocated map
+*   @return value:  None
+*   @error: 		Undefined behavior if @map is invalid
+*   @time complex: 	O(capacity) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+void UIDMapClear(uid_map_t* map);
+
+#endif /* __UID_MAP_H__ */
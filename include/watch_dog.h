@@ -20,6 +20,24 @@
 #define UNUSED(x) ((void)x)
 #define SEM_NAME ("/wd_sem")
 #define EXEC_WD_PATH ("./wd_exec.out")
+#define WD_FLAGS_ENV_VAR_NAME ("WD_FLAGS")
+#define WD_SHM_FD_ENV_VAR_NAME ("WD_SHM_FD")
+
+
+/* flight recorder events, decoded by tools/fr_decode.c */
+typedef enum wd_event
+{
+    WD_EV_START = 1,            /* counter: 1 in the user process */
+    WD_EV_BEAT_SENT,            /* counter: beats sent since the last reply */
+    WD_EV_BEAT_RECEIVED,        /* counter: the beat's number, signalfd mode */
+    WD_EV_THRESHOLD,            /* counter: missed beats, the peer restarts */
+    WD_EV_RESTART_WATCHDOG,     /* counter: restarts by this process so far */
+    WD_EV_RESTART_USER,         /* counter: as above */
+    WD_EV_STOP_REQUESTED,
+    WD_EV_STOP,
+    WD_EV_PEER_EXITED,          /* counter: missed beats, the peer restarts */
+    WD_NUM_OF_EVENTS
+} wd_event_t;
 
 
 typedef struct params_obj
@@ -29,19 +47,29 @@ typedef struct params_obj
     char** argv_wd;
     int is_user;
     pid_t pid_other;
-    size_t interval;
+    size_t interval;                    /* milliseconds */
     size_t threshold;
     heap_scheduler_t* sched;
 } params_obj_t;
 
 
 /**
- * @desc:       Appends a given text string to a log file. Ensures thread-safe
- *              logging for debugging or monitoring purposes.
+ * @desc:       Queues a given text string to be appended to the log file by
+ *              a background thread, see async_log.h. Never blocks, may be
+ *              called from any thread. Each process writes its own file,
+ *              <path>.<pid>, where <path> is ./log.txt unless the
+ *              WD_LOG_PATH environment variable names another one, and
+ *              rotates only that file, to <path>.<pid>.1 at 4 MiB. The user
+ *              and the watchdog thus never rotate each other's lines away,
+ *              and the file of a process that died is kept. A user
+ *              restarted by exec keeps the pid, so it continues the file of
+ *              the watchdog it replaces. Queued lines are written out at
+ *              exit and before that exec.
  * @params:     @str_input: A null-terminated string to be appended
  *              to the log file.
  * @return:     None.
- * @error:      If the log file cannot be opened, the error is ignored silently.
+ * @error:      If the log file cannot be opened or the calling thread's
+ *              buffer is full, the text is dropped silently.
  * @time:       O(1) for AC/WC.
  * @space:      O(1) for AC/WC.
  */
@@ -52,7 +80,8 @@ void AppendText(const char* str_input);
 *   @desc:      Initializes parameters for the Watchdog process. Prepares
 *               necessary structures and environment variables.
 *   @params:    @threshold: Threshold value for missed signals.
-*               @interval: Interval for signal transmission.
+*               @interval: Interval for signal transmission, in
+*               milliseconds.
 *               @argc: Number of arguments passed to the process.
 *               @argv: Argument list for the process.
 *   @return:    0 on success, non-zero on failure.
@@ -62,13 +91,49 @@ int InitParams(size_t threshold, size_t interval, int argc, char** argv);
 
 
 /**
-*   @desc:      Executes the Watchdog process by replacing the current process
-*               image with the Watchdog executable.
+*   @desc:      Reads the wd_flags_t bits from the WD_FLAGS environment
+*               variable.
+*   @params:    None.
+*   @return:    The flags, zero if the variable is unset.
+*   @error:     None.
+*/
+unsigned int GetFlags(void);
+
+
+/**
+*   @desc:      Blocks SIGUSR1 and SIGUSR2 in the calling thread when
+*               WD_FLAG_SIGNALFD is set in @flags and unblocks them
+*               otherwise, since a restarted process inherits the mask of its
+*               peer. Threads created afterwards inherit the mask.
+*   @params:    @flags: wd_flags_t bits.
+*   @return:    0 on success, non-zero on failure.
+*   @error:     None.
+*/
+int SetSignalMask(unsigned int flags);
+
+
+/**
+*   @desc:      Makes sure WD_SHM_FD names an open heartbeat page descriptor
+*               that the watchdog process will inherit: keeps the one a
+*               restarted process inherited, creates one otherwise.
 *   @params:    None.
 *   @return:    0 on success, non-zero on failure.
-*   @error:     Undefined behavior if execution fails.
+*   @error:     None.
+*/
+int InitHeartbeatChannel(void);
+
+
+/**
+*   @desc:      Starts the Watchdog executable in a new process with
+*               posix_spawn, which does not copy the caller's page tables.
+*               The child gets stdio and the heartbeat page descriptor only,
+*               SIGUSR1 and SIGUSR2 at their default dispositions, and those
+*               two blocked in signalfd mode with nothing blocked otherwise.
+*   @params:    None.
+*   @return:    The pid of the Watchdog process, -1 on failure.
+*   @error:     None.
 */
-int ExecWatchDog();
+pid_t SpawnWatchDog(void);
 
 
 /**
@@ -20,6 +20,22 @@ typedef enum wd_status
     WD_NUM_OF_STATUS
 } wd_status_t;
 
+typedef enum wd_flags
+{
+    WD_FLAG_NONE = 0,
+    /*
+    *   SIGUSR1/SIGUSR2 are blocked and read from a signalfd on the watchdog
+    *   thread instead of interrupting the application with a handler
+    */
+    WD_FLAG_SIGNALFD = 1,
+    /*
+    *   beats are counters in a shared memory page, polled by the peer once
+    *   per interval, instead of a SIGUSR1 per beat. Signals remain only for
+    *   stop and reset
+    */
+    WD_FLAG_SHM_HEARTBEAT = 2
+} wd_flags_t;
+
 
 /**
 *   @desc:              Initializes and starts the Watchdog service by creating
@@ -37,6 +53,55 @@ typedef enum wd_status
 wd_status_t WDStart(size_t threshold, size_t interval, int argc, char** argv);
 
 
+/**
+*   @desc:              Same as @WDStart, with the interval given in
+*                       milliseconds. Allows sub-second hang detection: the
+*                       failover time is @threshold * @interval_ms.
+*                       The flags are taken from the WD_FLAGS environment
+*                       variable (a number, see @WDStartEx), none if unset.
+*   @params:            @threshold: Number of missed SIGUSR1 signals before
+*                       the Watchdog takes recovery action.
+*                       @interval_ms: Interval (in milliseconds) between signals
+*                       sent by the Watchdog process.
+*                       @argc: Number of command-line arguments for the process.
+*                       @argv: Command-line arguments.
+*   @return:            WD_SUCCESS on successful launch, WD_FAILURE on failure.
+*   @error:             If the semaphore or thread creation fails, the function
+*                       returns a failure status.
+*/
+wd_status_t WDStartMs(size_t threshold, size_t interval_ms, int argc,
+                        char** argv);
+
+
+/**
+*   @desc:              Same as @WDStartMs, with explicit @flags.
+*                       With WD_FLAG_SIGNALFD, SIGUSR1 and SIGUSR2 are blocked
+*                       in the calling thread and in every thread it creates
+*                       afterwards, so it must be called before the
+*                       application starts its threads. The watchdog then
+*                       consumes them synchronously, and every heartbeat
+*                       carries its sequence number as a sigqueue value.
+*                       With WD_FLAG_SHM_HEARTBEAT, a beat costs no system
+*                       call on either side and nothing is delivered to the
+*                       monitored process; the page is passed on as an
+*                       inherited descriptor named by WD_SHM_FD.
+*                       The flags are passed on to the watchdog process and
+*                       to restarted processes through WD_FLAGS.
+*   @params:            @threshold: Number of missed SIGUSR1 signals before
+*                       the Watchdog takes recovery action.
+*                       @interval_ms: Interval (in milliseconds) between signals
+*                       sent by the Watchdog process.
+*                       @flags: Bitwise or of wd_flags_t values.
+*                       @argc: Number of command-line arguments for the process.
+*                       @argv: Command-line arguments.
+*   @return:            WD_SUCCESS on successful launch, WD_FAILURE on failure.
+*   @error:             If the semaphore, the shared page or thread creation
+*                       fails, the function returns a failure status.
+*/
+wd_status_t WDStartEx(size_t threshold, size_t interval_ms, unsigned int flags,
+                        int argc, char** argv);
+
+
 /**
 *   @desc:              Stops the Watchdog process and releases all allocated
 *                       resources. Also signals the monitored process to stop.
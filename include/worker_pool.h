@@ -0,0 +1,64 @@
+/* worker_pool.h */
+
+#ifndef __WORKER_POOL_H__
+#define __WORKER_POOL_H__
+
+#include <stddef.h>         /* size_t */
+
+/*
+*   Fixed set of threads that run submitted jobs. Every worker owns a deque
+*   of jobs, submitted jobs are spread over the deques round robin, and an
+*   idle worker steals from the others before going to sleep, so one slow
+*   job only holds up its own worker.
+*/
+typedef struct worker_pool worker_pool_t;
+
+/*
+*   @desc:          Starts a pool of @num_of_workers threads. Must be
+*				destroyed with @WorkerPoolDestroy
+*   @params: 		@num_of_workers: number of threads, must be nonzero
+*   @return value:  Pointer to the new pool
+*   @error: 		Returns NULL if allocation or thread creation fails
+*   @time complex: 	O(num_of_workers) for both AC/WC
+*   @space complex: O(num_of_workers) for both AC/WC
+*/
+worker_pool_t* WorkerPoolCreate(size_t num_of_workers);
+
+/*
+*   @desc:          Runs every job already submitted to @pool, then stops its
+*				threads and frees it. Must not be called from a job
+*   @params: 		@pool: pool created with @WorkerPoolCreate
+*   @return value:  None
+*   @error: 		None
+*   @time complex: 	O(num_of_workers + pending jobs) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+void WorkerPoolDestroy(worker_pool_t* pool);
+
+/*
+*   @desc:          Queues @job_func to be called with @params on one of the
+*				workers. Jobs are started in submission order per worker,
+*				with no order guarantee between workers. May be called from
+*				any thread, including from a job
+*   @params: 		@pool: pool created with @WorkerPoolCreate
+*				@job_func: function to run
+*				@params: argument for @job_func
+*   @return value:  zero on success, nonzero if the job couldn't be queued
+*   @error: 		Undefined behavior if @pool or @job_func is invalid
+*   @time complex: 	O(1) AC, O(pending jobs) WC
+*   @space complex: O(1) AC, O(pending jobs) WC
+*/
+int WorkerPoolSubmit(worker_pool_t* pool, void (*job_func)(void* params),
+						void* params);
+
+/*
+*   @desc:          Returns the number of threads of @pool
+*   @params: 		@pool: pool created with @WorkerPoolCreate
+*   @return value:  Number of workers
+*   @error: 		Undefined behavior if @pool is invalid
+*   @time complex: 	O(1) for both AC/WC
+*   @space complex: O(1) for both AC/WC
+*/
+size_t WorkerPoolSize(const worker_pool_t* pool);
+
+#endif /* __WORKER_POOL_H__ */
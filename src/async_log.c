@@ -0,0 +1,505 @@
+/******************************************************************************
+ * File name: async_log.c
+ * Owner: Ofir Nahshoni
+ ******************************************************************************/
+
+#define _POSIX_C_SOURCE (200809L)
+
+#include <assert.h>         /* assert */
+#include <errno.h>          /* ETIMEDOUT */
+#include <fcntl.h>          /* open, O_APPEND */
+#include <pthread.h>        /* pthread_create, pthread_key_t */
+#include <signal.h>         /* pthread_sigmask */
+#include <stdatomic.h>      /* atomic_size_t, atomic_uintptr_t */
+#include <stdio.h>          /* sprintf, rename */
+#include <stdlib.h>         /* malloc, free */
+#include <string.h>         /* memcpy, strlen, strcpy */
+#include <unistd.h>         /* close, lseek */
+#include <sys/uio.h>        /* writev */
+
+#include "async_log.h"
+#include "mono_clock.h"     /* MonoClockNow, MonoClockToTimespec */
+
+/*-----------------------------------macros-----------------------------------*/
+#define RING_LINES (256)    /* power of 2, so the indices may wrap around */
+#define MAX_BATCH (64)      /* lines per writev, below IOV_MAX */
+#define CACHE_LINE (64)
+#define FLUSH_INTERVAL_US (20 * MONO_USEC_PER_MSEC)
+#define BACKUP_SUFFIX (".1")
+#define FILE_MODE (0644)
+
+/*-----------------------------typdefs & Structures---------------------------*/
+typedef struct line
+{
+    size_t len;
+    char text[ASYNC_LOG_LINE_MAX];
+} line_t;
+
+/* single producer - the owning thread, single consumer - the writer */
+typedef struct ring
+{
+    atomic_size_t head;         /* next line to fill */
+    char head_pad[CACHE_LINE - sizeof(atomic_size_t)];
+    atomic_size_t tail;         /* next line to write out */
+    char tail_pad[CACHE_LINE - sizeof(atomic_size_t)];
+    atomic_int is_owned;        /* cleared when the owning thread exits */
+    struct ring* next;          /* never changes once the ring is listed */
+    line_t lines[RING_LINES];
+} ring_t;
+
+struct async_log
+{
+    atomic_uintptr_t rings;     /* ring_t*, only ever pushed to */
+    pthread_key_t key;          /* the calling thread's ring */
+    atomic_size_t num_of_dropped;
+    atomic_int is_nudged;       /* a ring filled up half way */
+    size_t num_of_reported;     /* drops already noted in the file */
+    int fd;
+    char* path;
+    char* backup_path;
+    size_t max_file_size;
+    size_t file_size;
+    pthread_t writer;
+    pthread_mutex_t lock;       /* guards the fields below */
+    pthread_cond_t wakeup;
+    int is_stopping;
+    size_t flush_requested;
+    size_t flush_done;
+};
+
+/*------------------------------static functions------------------------------*/
+static int OpenFile(async_log_t* log)
+{
+    off_t size = 0;
+
+    log->fd = open(log->path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC,
+                    FILE_MODE);
+
+    if (-1 == log->fd)
+    {
+        return 1;
+    }
+
+    size = lseek(log->fd, 0, SEEK_END);
+    log->file_size = (size > 0) ? (size_t)size : 0;
+
+    return 0;
+}
+
+/* called by the writer only */
+static void Rotate(async_log_t* log)
+{
+    int old_fd = log->fd;
+
+    if (0 != rename(log->path, log->backup_path))
+    {
+        return;
+    }
+
+    /* if the new file can't be opened, keep appending to the renamed one */
+    if (0 != OpenFile(log))
+    {
+        log->fd = old_fd;
+        return;
+    }
+
+    close(old_fd);
+}
+
+static void WriteOut(async_log_t* log, const struct iovec* iov, size_t count)
+{
+    ssize_t written = writev(log->fd, iov, (int)count);
+
+    if (written > 0)
+    {
+        log->file_size += (size_t)written;
+    }
+
+    if ((0 != log->max_file_size) && (log->file_size >= log->max_file_size))
+    {
+        Rotate(log);
+    }
+}
+
+static void DrainRing(async_log_t* log, ring_t* ring)
+{
+    size_t count = 0;
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    struct iovec iov[MAX_BATCH];
+
+    while (tail != head)
+    {
+        for (count = 0; (tail + count != head) && (count < MAX_BATCH);
+            ++count)
+        {
+            line_t* line = &ring->lines[(tail + count) % RING_LINES];
+
+            iov[count].iov_base = line->text;
+            iov[count].iov_len = line->len;
+        }
+
+        WriteOut(log, iov, count);
+
+        /* the lines are free for the producer only once they're written */
+        tail += count;
+        atomic_store_explicit(&ring->tail, tail, memory_order_release);
+    }
+}
+
+static void ReportDrops(async_log_t* log)
+{
+    char text[ASYNC_LOG_LINE_MAX];
+    struct iovec iov;
+    size_t num_of_dropped = atomic_load(&log->num_of_dropped);
+
+    if (num_of_dropped == log->num_of_reported)
+    {
+        return;
+    }
+
+    sprintf(text, "async_log: %lu lines dropped\n",
+            (unsigned long)(num_of_dropped - log->num_of_reported));
+    log->num_of_reported = num_of_dropped;
+
+    iov.iov_base = text;
+    iov.iov_len = strlen(text);
+    WriteOut(log, &iov, 1);
+}
+
+static void Drain(async_log_t* log)
+{
+    ring_t* ring = (ring_t*)atomic_load_explicit(&log->rings,
+                                                    memory_order_acquire);
+
+    for (; NULL != ring; ring = ring->next)
+    {
+        DrainRing(log, ring);
+    }
+
+    ReportDrops(log);
+}
+
+static void* WriterRoutine(void* params)
+{
+    async_log_t* log = (async_log_t*)params;
+    size_t flush_target = 0;
+    int is_stopping = 0;
+    struct timespec wake_ts;
+
+    pthread_mutex_lock(&log->lock);
+
+    while (!is_stopping)
+    {
+        MonoClockToTimespec(MonoClockNow() + FLUSH_INTERVAL_US, &wake_ts);
+
+        while (!log->is_stopping &&
+                (log->flush_requested == log->flush_done) &&
+                !atomic_exchange(&log->is_nudged, 0) &&
+                (ETIMEDOUT != pthread_cond_timedwait(&log->wakeup, &log->lock,
+                                                        &wake_ts)))
+        {
+        }
+
+        flush_target = log->flush_requested;
+        is_stopping = log->is_stopping;
+        pthread_mutex_unlock(&log->lock);
+
+        Drain(log);
+
+        pthread_mutex_lock(&log->lock);
+        log->flush_done = flush_target;
+        pthread_cond_broadcast(&log->wakeup);
+    }
+
+    pthread_mutex_unlock(&log->lock);
+
+    return NULL;
+}
+
+/* pthread key destructor: the ring is left to the next thread that writes */
+static void DetachRing(void* ring)
+{
+    atomic_store(&((ring_t*)ring)->is_owned, 0);
+}
+
+static ring_t* AttachRing(async_log_t* log)
+{
+    int expected = 0;
+    uintptr_t first = atomic_load(&log->rings);
+    ring_t* ring = (ring_t*)first;
+
+    /* a ring whose thread exited is reused, so thread churn doesn't grow */
+    for (; NULL != ring; ring = ring->next)
+    {
+        expected = 0;
+
+        if (atomic_compare_exchange_strong(&ring->is_owned, &expected, 1))
+        {
+            break;
+        }
+    }
+
+    if (NULL == ring)
+    {
+        ring = (ring_t*)malloc(sizeof(ring_t));
+
+        if (NULL == ring)
+        {
+            return NULL;
+        }
+
+        atomic_init(&ring->head, 0);
+        atomic_init(&ring->tail, 0);
+        atomic_init(&ring->is_owned, 1);
+        do
+        {
+            ring->next = (ring_t*)first;
+        } while (!atomic_compare_exchange_weak(&log->rings, &first,
+                                                (uintptr_t)ring));
+    }
+
+    if (0 != pthread_setspecific(log->key, ring))
+    {
+        atomic_store(&ring->is_owned, 0);
+        return NULL;
+    }
+
+    return ring;
+}
+
+static int InitSync(async_log_t* log)
+{
+    pthread_condattr_t attr;
+
+    if (0 != pthread_mutex_init(&log->lock, NULL))
+    {
+        return 1;
+    }
+
+    if (0 != pthread_condattr_init(&attr))
+    {
+        pthread_mutex_destroy(&log->lock);
+        return 1;
+    }
+
+    if ((0 != pthread_condattr_setclock(&attr, CLOCK_MONOTONIC)) ||
+        (0 != pthread_cond_init(&log->wakeup, &attr)))
+    {
+        pthread_condattr_destroy(&attr);
+        pthread_mutex_destroy(&log->lock);
+        return 1;
+    }
+
+    pthread_condattr_destroy(&attr);
+
+    return 0;
+}
+
+/* the writer takes no signals, they belong to the application's threads */
+static int StartWriter(async_log_t* log)
+{
+    int result = 0;
+    sigset_t all;
+    sigset_t old;
+
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &old);
+    result = pthread_create(&log->writer, NULL, WriterRoutine, log);
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+    return (0 != result);
+}
+
+static void FreeLog(async_log_t* log)
+{
+    ring_t* ring = (ring_t*)atomic_load(&log->rings);
+
+    while (NULL != ring)
+    {
+        ring_t* next = ring->next;
+
+        free(ring);
+        ring = next;
+    }
+
+    pthread_key_delete(log->key);
+    pthread_cond_destroy(&log->wakeup);
+    pthread_mutex_destroy(&log->lock);
+    close(log->fd);
+    free(log->path);
+    free(log);
+}
+
+/*--------------------------------API functions-------------------------------*/
+async_log_t* AsyncLogCreate(const char* path, size_t max_file_size)
+{
+    size_t path_len = 0;
+    async_log_t* log = NULL;
+
+    assert(path);
+
+    log = (async_log_t*)malloc(sizeof(async_log_t));
+
+    if (NULL == log)
+    {
+        return NULL;
+    }
+
+    /* both paths in one block */
+    path_len = strlen(path);
+    log->path = (char*)malloc(2 * (path_len + 1) + sizeof(BACKUP_SUFFIX));
+
+    if (NULL == log->path)
+    {
+        free(log);
+        return NULL;
+    }
+
+    strcpy(log->path, path);
+    log->backup_path = log->path + path_len + 1;
+    strcpy(log->backup_path, path);
+    strcpy(log->backup_path + path_len, BACKUP_SUFFIX);
+
+    if (0 != OpenFile(log))
+    {
+        free(log->path);
+        free(log);
+        return NULL;
+    }
+
+    if (0 != pthread_key_create(&log->key, DetachRing))
+    {
+        close(log->fd);
+        free(log->path);
+        free(log);
+        return NULL;
+    }
+
+    if (0 != InitSync(log))
+    {
+        pthread_key_delete(log->key);
+        close(log->fd);
+        free(log->path);
+        free(log);
+        return NULL;
+    }
+
+    atomic_init(&log->rings, (uintptr_t)NULL);
+    atomic_init(&log->num_of_dropped, 0);
+    atomic_init(&log->is_nudged, 0);
+    log->num_of_reported = 0;
+    log->max_file_size = max_file_size;
+    log->is_stopping = 0;
+    log->flush_requested = 0;
+    log->flush_done = 0;
+
+    if (0 != StartWriter(log))
+    {
+        FreeLog(log);
+        return NULL;
+    }
+
+    return log;
+}
+
+void AsyncLogDestroy(async_log_t* log)
+{
+    if (NULL == log)
+    {
+        return;
+    }
+
+    /* the writer drains once more after it sees the flag */
+    pthread_mutex_lock(&log->lock);
+    log->is_stopping = 1;
+    pthread_cond_signal(&log->wakeup);
+    pthread_mutex_unlock(&log->lock);
+
+    pthread_join(log->writer, NULL);
+    FreeLog(log);
+}
+
+int AsyncLogWrite(async_log_t* log, const char* text)
+{
+    size_t len = 0;
+    size_t head = 0;
+    size_t used = 0;
+    line_t* line = NULL;
+    ring_t* ring = NULL;
+
+    assert(log);
+    assert(text);
+
+    ring = (ring_t*)pthread_getspecific(log->key);
+
+    if ((NULL == ring) && (NULL == (ring = AttachRing(log))))
+    {
+        atomic_fetch_add(&log->num_of_dropped, 1);
+        return 1;
+    }
+
+    head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    used = head - atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+    if (RING_LINES == used)
+    {
+        atomic_fetch_add(&log->num_of_dropped, 1);
+        return 1;
+    }
+
+    /*
+    * a burst shouldn't wait for the next flush interval. Signaling without
+    * the mutex may be missed by a writer about to wait, the interval covers
+    * that
+    */
+    if ((RING_LINES / 2 == used) && !atomic_exchange(&log->is_nudged, 1))
+    {
+        pthread_cond_signal(&log->wakeup);
+    }
+
+    line = &ring->lines[head % RING_LINES];
+    len = strlen(text);
+
+    if (len > ASYNC_LOG_LINE_MAX)
+    {
+        len = ASYNC_LOG_LINE_MAX;
+        /* a cut line still ends its line in the file */
+        memcpy(line->text, text, len - 1);
+        line->text[len - 1] = '\n';
+    }
+    else
+    {
+        memcpy(line->text, text, len);
+    }
+
+    line->len = len;
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+
+    return 0;
+}
+
+void AsyncLogFlush(async_log_t* log)
+{
+    size_t flush_target = 0;
+
+    assert(log);
+
+    pthread_mutex_lock(&log->lock);
+    flush_target = ++(log->flush_requested);
+    pthread_cond_broadcast(&log->wakeup);
+
+    while ((log->flush_done < flush_target) && !log->is_stopping)
+    {
+        pthread_cond_wait(&log->wakeup, &log->lock);
+    }
+
+    pthread_mutex_unlock(&log->lock);
+}
+
+size_t AsyncLogDropped(async_log_t* log)
+{
+    assert(log);
+
+    return atomic_load(&log->num_of_dropped);
+}
@@ -0,0 +1,252 @@
+/******************************************************************************
+ * File name: deadline_heap.c
+ * Owner: Ofir Nahshoni
+ ******************************************************************************/
+
+#define _POSIX_C_SOURCE (200809L)   /* posix_memalign */
+
+#include <assert.h>         /* assert */
+#include <stdlib.h>         /* malloc, posix_memalign, free */
+#include <string.h>         /* memcpy */
+
+#include "heap_kernel.h"    /* HEAP_KERNEL_DEFINE */
+#include "deadline_heap.h"
+
+/*-----------------------------------macros-----------------------------------*/
+#define MIN_CAPACITY (16)
+#define GROWTH_FACTOR (2)
+#define CACHE_LINE_SIZE (64)
+/* 16-byte entries: siblings never straddle a cache line for arity 2 or 4
+   (4 children fill one line). Binary measured fastest for the scheduler's
+   pop + re-push pattern, up to 10M timers */
+#ifndef DEADLINE_HEAP_ARITY
+#define DEADLINE_HEAP_ARITY (2)
+#endif
+#define ARITY (DEADLINE_HEAP_ARITY)
+/* root is stored at slot ARITY - 1 so every group of siblings starts on an
+   ARITY-entry boundary of the cache-line aligned block */
+#define PADDING (ARITY - 1)
+#define IS_EARLIER(a, b) ((a).deadline < (b).deadline)
+#define UPDATE_SLOT(entry, idx) (TaskSetQueueIndex((entry).task, (idx)))
+
+/*-----------------------------typdefs & Structures---------------------------*/
+typedef struct entry
+{
+    mono_time_t deadline;
+    task_t* task;
+} entry_t;
+
+struct deadline_heap
+{
+    size_t size;
+    size_t capacity;
+    entry_t* entries;       /* logical slot 0, inside the aligned block */
+};
+
+/*------------------------------static functions------------------------------*/
+HEAP_KERNEL_DEFINE(Entries, entry_t, ARITY, IS_EARLIER, UPDATE_SLOT)
+
+static entry_t* AllocEntries(size_t capacity)
+{
+    void* block = NULL;
+
+    if (0 != posix_memalign(&block, CACHE_LINE_SIZE,
+                            (capacity + PADDING) * sizeof(entry_t)))
+    {
+        return NULL;
+    }
+
+    return ((entry_t*)block + PADDING);
+}
+
+static void FreeEntries(entry_t* entries)
+{
+    free(entries - PADDING);
+}
+
+static int Grow(deadline_heap_t* heap, size_t min_capacity)
+{
+    size_t new_capacity = heap->capacity * GROWTH_FACTOR;
+    entry_t* new_entries = NULL;
+
+    if (new_capacity < min_capacity)
+    {
+        new_capacity = min_capacity;
+    }
+
+    new_entries = AllocEntries(new_capacity);
+
+    if (NULL == new_entries)
+    {
+        return 1;
+    }
+
+    memcpy(new_entries, heap->entries, heap->size * sizeof(entry_t));
+    FreeEntries(heap->entries);
+
+    heap->entries = new_entries;
+    heap->capacity = new_capacity;
+
+    return 0;
+}
+
+/*--------------------------------API functions-------------------------------*/
+deadline_heap_t* DeadlineHeapCreate(size_t capacity_hint)
+{
+    deadline_heap_t* heap = (deadline_heap_t*)malloc(sizeof(deadline_heap_t));
+
+    if (NULL == heap)
+    {
+        return NULL;
+    }
+
+    heap->size = 0;
+    heap->capacity = (capacity_hint > MIN_CAPACITY) ? capacity_hint :
+                                                        MIN_CAPACITY;
+    heap->entries = AllocEntries(heap->capacity);
+
+    if (NULL == heap->entries)
+    {
+        free(heap);
+        return NULL;
+    }
+
+    return heap;
+}
+
+void DeadlineHeapDestroy(deadline_heap_t* heap)
+{
+    if (NULL != heap)
+    {
+        FreeEntries(heap->entries);
+        free(heap);
+    }
+}
+
+int DeadlineHeapPush(deadline_heap_t* heap, task_t* task)
+{
+    assert(heap);
+    assert(task);
+
+    if ((heap->size == heap->capacity) && (0 != Grow(heap, 0)))
+    {
+        return 1;
+    }
+
+    heap->entries[heap->size].deadline = TaskGetScheduledTime(task);
+    heap->entries[heap->size].task = task;
+    ++(heap->size);
+
+    EntriesSiftUp(heap->entries, heap->size - 1);
+
+    return 0;
+}
+
+int DeadlineHeapPushMany(deadline_heap_t* heap, task_t* const* tasks,
+                        size_t count)
+{
+    size_t i = 0;
+    size_t old_size = 0;
+
+    assert(heap);
+    assert(tasks || (0 == count));
+
+    if ((heap->size + count > heap->capacity) &&
+        (0 != Grow(heap, heap->size + count)))
+    {
+        return 1;
+    }
+
+    old_size = heap->size;
+
+    for (i = 0; i < count; ++i)
+    {
+        heap->entries[old_size + i].deadline = TaskGetScheduledTime(tasks[i]);
+        heap->entries[old_size + i].task = tasks[i];
+        TaskSetQueueIndex(tasks[i], old_size + i);
+    }
+
+    heap->size += count;
+
+    /* a rebuild is O(size), sifting the new ones up O(count * log(size)) */
+    if (count < old_size)
+    {
+        for (i = old_size; i < heap->size; ++i)
+        {
+            EntriesSiftUp(heap->entries, i);
+        }
+    }
+    else
+    {
+        EntriesHeapify(heap->entries, heap->size);
+    }
+
+    return 0;
+}
+
+task_t* DeadlineHeapPop(deadline_heap_t* heap)
+{
+    assert(heap);
+    assert(0 != heap->size);
+
+    return DeadlineHeapRemoveAt(heap, 0);
+}
+
+task_t* DeadlineHeapPeek(const deadline_heap_t* heap)
+{
+    assert(heap);
+    assert(0 != heap->size);
+
+    return heap->entries[0].task;
+}
+
+mono_time_t DeadlineHeapPeekTime(const deadline_heap_t* heap)
+{
+    assert(heap);
+    assert(0 != heap->size);
+
+    return heap->entries[0].deadline;
+}
+
+task_t* DeadlineHeapRemoveAt(deadline_heap_t* heap, size_t index)
+{
+    task_t* removed = NULL;
+
+    assert(heap);
+    assert(index < heap->size);
+
+    removed = heap->entries[index].task;
+    --(heap->size);
+
+    if (index < heap->size)
+    {
+        heap->entries[index] = heap->entries[heap->size];
+        EntriesResift(heap->entries, heap->size, index);
+    }
+
+    return removed;
+}
+
+void DeadlineHeapUpdate(deadline_heap_t* heap, size_t index)
+{
+    assert(heap);
+    assert(index < heap->size);
+
+    heap->entries[index].deadline =
+                                TaskGetScheduledTime(heap->entries[index].task);
+    EntriesResift(heap->entries, heap->size, index);
+}
+
+size_t DeadlineHeapSize(const deadline_heap_t* heap)
+{
+    assert(heap);
+
+    return heap->size;
+}
+
+int DeadlineHeapIsEmpty(const deadline_heap_t* heap)
+{
+    assert(heap);
+
+    return (0 == heap->size);
+}
@@ -12,15 +12,39 @@
 #include "dvector.h"
 
 #define GROWTH_FACTOR (2)
+/* automatic shrinking never goes below this many elements */
+#define MIN_SHRINK_CAPACITY (16)
+/* shrink once size drops under capacity / SHRINK_TRIGGER ... */
+#define SHRINK_TRIGGER (4)
+/* ... and leave room for twice the remaining elements */
+#define SHRINK_SLACK (2)
 
 struct dvector
 {
 	size_t size;
 	size_t capacity;
+	size_t min_capacity;	/* floor for automatic shrinking */
 	size_t element_size;
 	void* array;
 };
 
+static size_t ShrinkTarget(const dvector_t* dvector)
+{
+	size_t target = dvector->size * SHRINK_SLACK;
+
+	if (target < dvector->min_capacity)
+	{
+		target = dvector->min_capacity;
+	}
+
+	if (target < MIN_SHRINK_CAPACITY)
+	{
+		target = MIN_SHRINK_CAPACITY;
+	}
+
+	return target;
+}
+
 dvector_t* DvectorCreate(size_t capacity, size_t element_size)
 {
 	dvector_t* dvector = NULL;
@@ -37,6 +61,7 @@ dvector_t* DvectorCreate(size_t capacity, size_t element_size)
 
 	dvector->size = 0;
 	dvector->capacity = capacity;
+	dvector->min_capacity = capacity;
 	dvector->element_size = element_size;
 
 	dvector->array = malloc(capacity * element_size);
@@ -95,16 +120,19 @@ void DvectorGetElement(const dvector_t* dvector, size_t index, void* dest)
 
 int DvectorPushBack(dvector_t* dvector, const void* element)
 {
+	void* slot = NULL;
+
 	assert(NULL != dvector);
 	assert(NULL != element);
 
-	if (dvector->size == dvector->capacity)
+	slot = DvectorEmplaceBack(dvector);
+
+	if (NULL == slot)
 	{
-		DvectorResize(dvector, dvector->capacity * GROWTH_FACTOR + 1);
+		return 1;
 	}
 
-	++(dvector->size);
-	DvectorSetElement(dvector, dvector->size - 1, element);
+	memcpy(slot, element, dvector->element_size);
 
 	return 0;
 }
@@ -120,12 +148,16 @@ int DvectorPopBack(dvector_t* dvector)
 
     --(dvector->size);
 
-    if ((dvector->size < (dvector->capacity / 4)) && (dvector->capacity > 4))
+    /*
+     * shrinking only to twice the size means the vector has to double or
+     * halve again before the next realloc, so push/pop around a boundary
+     * can't make it realloc back and forth
+     */
+    if ((dvector->size < (dvector->capacity / SHRINK_TRIGGER)) &&
+        (ShrinkTarget(dvector) < dvector->capacity))
     {
-        if (0 != DvectorShrink(dvector))
-        {
-            return 1;
-        }
+        /* failing to give memory back leaves a valid, larger vector */
+        DvectorResize(dvector, ShrinkTarget(dvector));
     }
 
     return 0;
@@ -169,5 +201,115 @@ int DvectorShrink(dvector_t* dvector)
 	assert(NULL != dvector);
 	assert(NULL != dvector->array);
 
-	return (DvectorResize(dvector, dvector->size));
+	return DvectorShrinkToFit(dvector);
+}
+
+int DvectorReserve(dvector_t* dvector, size_t capacity)
+{
+	assert(NULL != dvector);
+
+	if ((capacity > dvector->capacity) &&
+		(0 != DvectorResize(dvector, capacity)))
+	{
+		return 1;
+	}
+
+	dvector->min_capacity = capacity;
+
+	return 0;
+}
+
+int DvectorShrinkToFit(dvector_t* dvector)
+{
+	assert(NULL != dvector);
+
+	dvector->min_capacity = 0;
+
+	if (dvector->size == dvector->capacity)
+	{
+		return 0;
+	}
+
+	return DvectorResize(dvector, dvector->size);
+}
+
+int DvectorAppendRange(dvector_t* dvector, const void* elements, size_t count)
+{
+	size_t new_size = 0;
+	size_t new_capacity = 0;
+
+	assert(NULL != dvector);
+	assert((NULL != elements) || (0 == count));
+
+	new_size = dvector->size + count;
+
+	if (new_size > dvector->capacity)
+	{
+		new_capacity = dvector->capacity * GROWTH_FACTOR + 1;
+
+		if (new_capacity < new_size)
+		{
+			new_capacity = new_size;
+		}
+
+		if (0 != DvectorResize(dvector, new_capacity))
+		{
+			return 1;
+		}
+	}
+
+	if (0 != count)
+	{
+		memcpy((unsigned char*)(dvector->array) + dvector->size *
+				dvector->element_size, elements, count * dvector->element_size);
+	}
+
+	dvector->size = new_size;
+
+	return 0;
+}
+
+void* DvectorEmplaceBack(dvector_t* dvector)
+{
+	assert(NULL != dvector);
+
+	if ((dvector->size == dvector->capacity) &&
+		(0 != DvectorResize(dvector, dvector->capacity * GROWTH_FACTOR + 1)))
+	{
+		return NULL;
+	}
+
+	++(dvector->size);
+
+	return ((unsigned char*)(dvector->array) + (dvector->size - 1) *
+			dvector->element_size);
+}
+
+void* DvectorData(const dvector_t* dvector)
+{
+	assert(NULL != dvector);
+
+	return dvector->array;
+}
+
+void DvectorSwap(dvector_t* dvector, size_t index1, size_t index2)
+{
+	size_t i = 0;
+	unsigned char* elem1 = NULL;
+	unsigned char* elem2 = NULL;
+
+	assert(NULL != dvector);
+	assert(index1 < dvector->size);
+	assert(index2 < dvector->size);
+
+	elem1 = (unsigned char*)(dvector->array) + index1 * dvector->element_size;
+	elem2 = (unsigned char*)(dvector->array) + index2 * dvector->element_size;
+
+	for (i = 0; i < dvector->element_size; ++i)
+	{
+		unsigned char temp = elem1[i];
+
+		elem1[i] = elem2[i];
+		elem2[i] = temp;
+	}
 }
@@ -0,0 +1,213 @@
+/******************************************************************************
+ * File name: fd_poller.c
+ * Owner: Ofir Nahshoni
+ ******************************************************************************/
+
+#define _POSIX_C_SOURCE (200809L)
+
+#include <assert.h>         /* assert */
+#include <errno.h>          /* EINTR */
+#include <stdlib.h>         /* malloc, free */
+#include <unistd.h>         /* read, write, close */
+#include <sys/epoll.h>      /* epoll_create1, epoll_ctl, epoll_wait */
+#include <sys/eventfd.h>    /* eventfd */
+#include <sys/timerfd.h>    /* timerfd_create, timerfd_settime */
+
+#include "fd_poller.h"
+
+/*-----------------------------------macros-----------------------------------*/
+#define TIMER_KEY (UINT64_MAX)
+#define WAKE_KEY (UINT64_MAX - 1)
+#define MAX_BATCH (64)
+
+/*-----------------------------typdefs & Structures---------------------------*/
+struct fd_poller
+{
+    int epoll_fd;
+    int timer_fd;
+    int wake_fd;
+    mono_time_t armed_deadline;     /* what timer_fd is set to */
+};
+
+/*------------------------------static functions------------------------------*/
+static int Register(int epoll_fd, int fd, unsigned int events, uint64_t key)
+{
+    struct epoll_event event;
+
+    event.events = events;
+    event.data.u64 = key;
+
+    return (0 != epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event));
+}
+
+/* only touches the timer when the deadline changed since the last wait */
+static void ArmTimer(fd_poller_t* poller, mono_time_t deadline)
+{
+    struct itimerspec spec = { 0 };
+
+    if (deadline == poller->armed_deadline)
+    {
+        return;
+    }
+
+    /* an all zero it_value disarms the timer */
+    if (FD_POLLER_NO_DEADLINE != deadline)
+    {
+        MonoClockToTimespec(deadline, &spec.it_value);
+
+        if ((0 == spec.it_value.tv_sec) && (0 == spec.it_value.tv_nsec))
+        {
+            spec.it_value.tv_nsec = 1;
+        }
+    }
+
+    timerfd_settime(poller->timer_fd, TFD_TIMER_ABSTIME, &spec, NULL);
+    poller->armed_deadline = deadline;
+}
+
+/* reads the counter of an eventfd / timerfd so it stops being ready */
+static void Drain(int fd)
+{
+    uint64_t count = 0;
+
+    while (sizeof(count) == read(fd, &count, sizeof(count)))
+    {
+    }
+}
+
+/*--------------------------------API functions-------------------------------*/
+fd_poller_t* FdPollerCreate(void)
+{
+    fd_poller_t* poller = (fd_poller_t*)malloc(sizeof(fd_poller_t));
+
+    if (NULL == poller)
+    {
+        return NULL;
+    }
+
+    poller->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    poller->timer_fd = timerfd_create(CLOCK_MONOTONIC,
+                                        TFD_NONBLOCK | TFD_CLOEXEC);
+    poller->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    poller->armed_deadline = FD_POLLER_NO_DEADLINE;
+
+    if ((-1 == poller->epoll_fd) || (-1 == poller->timer_fd) ||
+        (-1 == poller->wake_fd) ||
+        (0 != Register(poller->epoll_fd, poller->timer_fd, EPOLLIN,
+                        TIMER_KEY)) ||
+        (0 != Register(poller->epoll_fd, poller->wake_fd, EPOLLIN, WAKE_KEY)))
+    {
+        FdPollerDestroy(poller);
+        return NULL;
+    }
+
+    return poller;
+}
+
+void FdPollerDestroy(fd_poller_t* poller)
+{
+    if (NULL == poller)
+    {
+        return;
+    }
+
+    if (-1 != poller->wake_fd)
+    {
+        close(poller->wake_fd);
+    }
+
+    if (-1 != poller->timer_fd)
+    {
+        close(poller->timer_fd);
+    }
+
+    if (-1 != poller->epoll_fd)
+    {
+        close(poller->epoll_fd);
+    }
+
+    free(poller);
+}
+
+int FdPollerAdd(fd_poller_t* poller, int fd, unsigned int events,
+                uint64_t key)
+{
+    assert(poller);
+    assert(key < FD_POLLER_MAX_KEY);
+
+    return Register(poller->epoll_fd, fd, events, key);
+}
+
+int FdPollerRemove(fd_poller_t* poller, int fd)
+{
+    /* non NULL for kernels before 2.6.9 */
+    struct epoll_event unused;
+
+    assert(poller);
+
+    return (0 != epoll_ctl(poller->epoll_fd, EPOLL_CTL_DEL, fd, &unused));
+}
+
+int FdPollerWait(fd_poller_t* poller, mono_time_t deadline,
+                    fd_poller_event_t* events, size_t max_events)
+{
+    int i = 0;
+    int num_of_ready = 0;
+    int num_of_events = 0;
+    struct epoll_event ready[MAX_BATCH];
+
+    assert(poller);
+    assert(events);
+    assert(max_events > 0);
+
+    if (max_events > MAX_BATCH)
+    {
+        max_events = MAX_BATCH;
+    }
+
+    ArmTimer(poller, deadline);
+
+    num_of_ready = epoll_wait(poller->epoll_fd, ready, (int)max_events, -1);
+
+    if (-1 == num_of_ready)
+    {
+        return (EINTR == errno) ? 0 : -1;
+    }
+
+    for (i = 0; i < num_of_ready; ++i)
+    {
+        switch (ready[i].data.u64)
+        {
+            case TIMER_KEY:
+                Drain(poller->timer_fd);
+                /* expired, the next wait re-arms even for the same time */
+                poller->armed_deadline = FD_POLLER_NO_DEADLINE;
+                break;
+
+            case WAKE_KEY:
+                Drain(poller->wake_fd);
+                break;
+
+            default:
+                events[num_of_events].key = ready[i].data.u64;
+                events[num_of_events].events = ready[i].events;
+                ++num_of_events;
+                break;
+        }
+    }
+
+    return num_of_events;
+}
+
+void FdPollerWake(fd_poller_t* poller)
+{
+    uint64_t one = 1;
+
+    assert(poller);
+
+    /* can only fail if the counter is saturated, which wakes just as well */
+    if (sizeof(one) != write(poller->wake_fd, &one, sizeof(one)))
+    {
+        return;
+    }
+}
@@ -0,0 +1,215 @@
+/******************************************************************************
+ * File name: flight_recorder.c
+ * Owner: Ofir Nahshoni
+ ******************************************************************************/
+
+#define _POSIX_C_SOURCE (200809L)
+
+#include <assert.h>         /* assert */
+#include <fcntl.h>          /* open, fcntl, F_SETLKW */
+#include <stdatomic.h>      /* atomic_fetch_add_explicit */
+#include <stdlib.h>         /* malloc, free */
+#include <string.h>         /* memset */
+#include <time.h>           /* clock_gettime */
+#include <unistd.h>         /* ftruncate, getpid, close */
+#include <sys/mman.h>       /* mmap, munmap */
+#include <sys/stat.h>       /* fstat */
+
+#include "flight_recorder.h"
+#include "mono_clock.h"     /* MonoClockNow */
+
+/*-----------------------------------macros-----------------------------------*/
+#define FILE_MODE (0644)
+#define EVENT_MASK (0xFFFFU)
+#define COUNTER_MASK (0xFFFFU)
+#define NSEC_PER_USEC (1000)
+
+/*-----------------------------typdefs & Structures---------------------------*/
+struct flight_recorder
+{
+    fr_file_header_t* header;
+    fr_record_t* records;
+    size_t map_size;
+    uint64_t capacity;
+    uint64_t pid;               /* cached - getpid is a system call */
+};
+
+#ifdef __GNUC__
+/* one 16 byte vector store on targets that have one */
+typedef uint64_t record_store_t
+                        __attribute__((vector_size(sizeof(fr_record_t))));
+#endif
+
+/*------------------------------static functions------------------------------*/
+/* serializes processes that open the same file at once */
+static int LockFile(int fd, short type)
+{
+    struct flock lock;
+
+    memset(&lock, 0, sizeof(lock));
+    lock.l_type = type;
+    lock.l_whence = SEEK_SET;
+
+    return (0 != fcntl(fd, F_SETLKW, &lock));
+}
+
+static int IsSameLayout(const fr_file_header_t* header, uint64_t capacity)
+{
+    return ((FR_MAGIC == header->magic) && (FR_VERSION == header->version) &&
+            (sizeof(fr_record_t) == header->record_size) &&
+            (capacity == header->capacity));
+}
+
+static void ResetFile(flight_recorder_t* recorder)
+{
+    fr_file_header_t* header = recorder->header;
+
+    memset(recorder->records, 0, recorder->capacity * sizeof(fr_record_t));
+    memset(header, 0, sizeof(fr_file_header_t));
+    header->version = FR_VERSION;
+    header->record_size = sizeof(fr_record_t);
+    header->capacity = recorder->capacity;
+    header->next = 0;
+    /* last, a decoder trusts nothing before it */
+    header->magic = FR_MAGIC;
+}
+
+static int64_t MonoToRealOffset(void)
+{
+    struct timespec real;
+
+    clock_gettime(CLOCK_REALTIME, &real);
+
+    return ((int64_t)real.tv_sec * MONO_USEC_PER_SEC +
+            real.tv_nsec / NSEC_PER_USEC) - (int64_t)MonoClockNow();
+}
+
+/* both words in one store, so a crash never leaves half a record */
+static void StoreRecord(fr_record_t* record, uint64_t time_us, uint64_t info)
+{
+#ifdef __GNUC__
+    record_store_t value;
+
+    value[0] = time_us;
+    value[1] = info;
+    *(record_store_t*)record = value;
+#else
+    record->time_us = time_us;
+    record->info = info;
+#endif
+}
+
+static int MapFile(flight_recorder_t* recorder, int fd)
+{
+    struct stat file_stat;
+    void* map = NULL;
+
+    if (0 != fstat(fd, &file_stat))
+    {
+        return 1;
+    }
+
+    if (((size_t)file_stat.st_size != recorder->map_size) &&
+        (0 != ftruncate(fd, (off_t)recorder->map_size)))
+    {
+        return 1;
+    }
+
+    map = mmap(NULL, recorder->map_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                fd, 0);
+
+    if (MAP_FAILED == map)
+    {
+        return 1;
+    }
+
+    recorder->header = (fr_file_header_t*)map;
+    recorder->records = (fr_record_t*)(recorder->header + 1);
+
+    if (!IsSameLayout(recorder->header, recorder->capacity))
+    {
+        ResetFile(recorder);
+    }
+
+    recorder->header->mono_to_real_us = MonoToRealOffset();
+
+    return 0;
+}
+
+/*--------------------------------API functions-------------------------------*/
+flight_recorder_t* FlightRecorderCreate(const char* path, size_t capacity)
+{
+    int fd = -1;
+    int result = 0;
+    flight_recorder_t* recorder = NULL;
+
+    assert(path);
+    assert(capacity > 0);
+
+    recorder = (flight_recorder_t*)malloc(sizeof(flight_recorder_t));
+
+    if (NULL == recorder)
+    {
+        return NULL;
+    }
+
+    recorder->capacity = capacity;
+    recorder->map_size = sizeof(fr_file_header_t) +
+                            capacity * sizeof(fr_record_t);
+    recorder->pid = (uint64_t)getpid();
+
+    fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, FILE_MODE);
+
+    if ((-1 == fd) || (0 != LockFile(fd, F_WRLCK)))
+    {
+        if (-1 != fd)
+        {
+            close(fd);
+        }
+
+        free(recorder);
+        return NULL;
+    }
+
+    result = MapFile(recorder, fd);
+
+    /* the mapping outlives the descriptor, and closing it drops the lock */
+    close(fd);
+
+    if (0 != result)
+    {
+        free(recorder);
+        return NULL;
+    }
+
+    return recorder;
+}
+
+void FlightRecorderDestroy(flight_recorder_t* recorder)
+{
+    if (NULL == recorder)
+    {
+        return;
+    }
+
+    munmap(recorder->header, recorder->map_size);
+    free(recorder);
+}
+
+void FlightRecorderRecord(flight_recorder_t* recorder, unsigned int event,
+                            unsigned int counter)
+{
+    uint64_t slot = 0;
+    uint64_t info = 0;
+
+    /* no assert, it isn't async signal safe */
+    info = recorder->pid | ((uint64_t)(event & EVENT_MASK) << 32) |
+            ((uint64_t)(counter & COUNTER_MASK) << 48);
+
+    /* the header is plain for decoders, the add is atomic all the same */
+    slot = atomic_fetch_add_explicit(
+                (atomic_uint_least64_t*)&recorder->header->next, 1,
+                memory_order_relaxed) % recorder->capacity;
+
+    StoreRecord(&recorder->records[slot], MonoClockNow(), info);
+}
@@ -15,100 +15,142 @@
 /*-----------------------------------macros-----------------------------------*/
 #define VECTOR_CAPACITY 10
 #define UNUSED(x) ((void)x)
-#define PARENT_IDX(i) ((i - 1) / 2)
-#define LEFT_CHILD_IDX(i) (2 * i + 1)
-#define RIGHT_CHILD_IDX(i) (2 * i + 2)
+#define PARENT_IDX(i, d) (((i) - 1) / (d))
+#define FIRST_CHILD_IDX(i, d) ((d) * (i) + 1)
 
 /*-----------------------------typdefs & Structures---------------------------*/
 struct heap
 {
     compare_func_t compare_func;
+    set_index_t set_index;
+    size_t arity;
     dvector_t* vector;
 };
 
 /*------------------------------static functions------------------------------*/
-static void SwapElements(dvector_t* vector, size_t idx1, size_t idx2)
+/* the vector stores void* elements contiguously, sift through them directly */
+static void** Elements(const heap_t* heap)
 {
-    void* data1 = NULL;
-    void* data2 = NULL;
+    return (void**)DvectorData(heap->vector);
+}
 
-    DvectorGetElement(vector, idx1, &data1);
-    DvectorGetElement(vector, idx2, &data2);
+static void SetElement(heap_t* heap, void** elements, size_t idx, void* data)
+{
+    elements[idx] = data;
 
-    DvectorSetElement(vector, idx1, &data2);
-    DvectorSetElement(vector, idx2, &data1);
+    if (NULL != heap->set_index)
+    {
+        heap->set_index(data, idx);
+    }
 }
 
+/* moves a hole up from @idx and writes the sifted element once at the end */
 static void HeapifyUp(heap_t* heap, size_t idx)
 {
-    void* current = NULL;
-    void* parent = NULL;
+    void** elements = Elements(heap);
+    void* moving = elements[idx];
+    size_t start_idx = idx;
 
-    if (0 == idx)
+    while (0 != idx)
     {
-        return;
-    }
+        void* parent = elements[PARENT_IDX(idx, heap->arity)];
 
-    DvectorGetElement(heap->vector, idx, &current);
-    DvectorGetElement(heap->vector, PARENT_IDX(idx), &parent);
+        if (heap->compare_func(moving, parent) >= 0)
+        {
+            break;
+        }
+
+        SetElement(heap, elements, idx, parent);
+        idx = PARENT_IDX(idx, heap->arity);
+    }
 
-    if (heap->compare_func(current, parent) < 0)
+    if (idx != start_idx)
     {
-        SwapElements(heap->vector, idx, PARENT_IDX(idx));
-        HeapifyUp(heap, PARENT_IDX(idx));
+        SetElement(heap, elements, idx, moving);
     }
 }
 
+/* moves a hole down from @idx and writes the sifted element once at the end */
 static void HeapifyDown(heap_t* heap, size_t idx)
 {
-    void* current = NULL;
-    void* left_child = NULL;
-    void* right_child = NULL;
-
-    size_t current_idx = idx;
+    void** elements = Elements(heap);
+    void* moving = elements[idx];
+    size_t start_idx = idx;
     size_t heap_size = HeapSize(heap);
-    size_t left_idx = LEFT_CHILD_IDX(idx);
-    size_t right_idx = RIGHT_CHILD_IDX(idx);
+    size_t first_idx = FIRST_CHILD_IDX(idx, heap->arity);
 
-    if (left_idx >= heap_size)
+    while (first_idx < heap_size)
     {
-        return;
-    }
+        size_t child_idx = first_idx;
+        size_t runner = first_idx + 1;
+        size_t end_idx = first_idx + heap->arity;
 
-    DvectorGetElement(heap->vector, current_idx, &current);
-    DvectorGetElement(heap->vector, left_idx, &left_child);
+        if (end_idx > heap_size)
+        {
+            end_idx = heap_size;
+        }
 
-    if (right_idx >= heap_size)
-    {
-        if (heap->compare_func(left_child, current) < 0)
+        /* smallest child; the children of a node are contiguous */
+        for (; runner < end_idx; ++runner)
         {
-            SwapElements(heap->vector, left_idx, current_idx);
+            if (heap->compare_func(elements[runner], elements[child_idx]) < 0)
+            {
+                child_idx = runner;
+            }
         }
 
-        return;
+        if (heap->compare_func(elements[child_idx], moving) >= 0)
+        {
+            break;
+        }
+
+        SetElement(heap, elements, idx, elements[child_idx]);
+        idx = child_idx;
+        first_idx = FIRST_CHILD_IDX(idx, heap->arity);
     }
 
-    DvectorGetElement(heap->vector, right_idx, &right_child);
+    if (idx != start_idx)
+    {
+        SetElement(heap, elements, idx, moving);
+    }
+}
 
-    if ((heap->compare_func(left_child, right_child)) < 0 &&
-        (heap->compare_func(left_child, current) < 0))
+/* restores heap order around @idx whichever direction its key moved */
+static void Resift(heap_t* heap, size_t idx)
+{
+    void** elements = Elements(heap);
+
+    if ((0 != idx) && (heap->compare_func(elements[idx],
+                        elements[PARENT_IDX(idx, heap->arity)]) < 0))
     {
-        SwapElements(heap->vector, left_idx, current_idx);
-        HeapifyDown(heap, left_idx);
+        HeapifyUp(heap, idx);
+        return;
     }
-    else if (heap->compare_func(right_child, current) < 0)
+
+    HeapifyDown(heap, idx);
+}
+
+/* bottom-up heapify, the last node with children first */
+static void HeapifyAll(heap_t* heap)
+{
+    size_t heap_size = HeapSize(heap);
+    size_t idx = (heap_size > 1) ? PARENT_IDX(heap_size - 1, heap->arity) + 1 :
+                                    0;
+
+    while (idx-- > 0)
     {
-        SwapElements(heap->vector, right_idx, current_idx);
-        HeapifyDown(heap, right_idx);
+        HeapifyDown(heap, idx);
     }
 }
 
 /*--------------------------------API functions-------------------------------*/
-heap_t* HeapCreate(compare_func_t compare_func)
+heap_t* HeapCreate(compare_func_t compare_func, set_index_t set_index,
+                    size_t arity)
 {
     heap_t* heap = NULL;
 
     assert(compare_func);
+    assert(arity >= 2);
 
     heap = (heap_t*)malloc(sizeof(heap_t));
 
@@ -126,6 +168,8 @@ heap_t* HeapCreate(compare_func_t compare_func)
     }
 
     heap->compare_func = compare_func;
+    heap->set_index = set_index;
+    heap->arity = arity;
 
     return heap;
 }
@@ -140,20 +184,66 @@ void HeapDestroy(heap_t* heap)
 
 int HeapPush(heap_t* heap, void* data)
 {
-    int push_result = 0;
+    void** slot = NULL;
 
     assert(heap);
 
-    push_result = DvectorPushBack(heap->vector, &data);
+    slot = (void**)DvectorEmplaceBack(heap->vector);
+
+    if (NULL == slot)
+    {
+        return 1;
+    }
+
+    *slot = data;
 
-    if (0 != push_result)
+    if (NULL != heap->set_index)
     {
-        return push_result;
+        heap->set_index(data, HeapSize(heap) - 1);
     }
 
     HeapifyUp(heap, HeapSize(heap) - 1);
 
-    return push_result;
+    return 0;
+}
+
+int HeapBuild(heap_t* heap, void* const* elements, size_t count)
+{
+    size_t i = 0;
+    size_t old_size = 0;
+
+    assert(heap);
+    assert(elements || (0 == count));
+
+    old_size = HeapSize(heap);
+
+    if (0 != DvectorAppendRange(heap->vector, elements, count))
+    {
+        return 1;
+    }
+
+    if (NULL != heap->set_index)
+    {
+        for (i = 0; i < count; ++i)
+        {
+            heap->set_index(elements[i], old_size + i);
+        }
+    }
+
+    /* a rebuild is O(size), sifting the new ones up O(count * log(size)) */
+    if (count < old_size)
+    {
+        for (i = old_size; i < old_size + count; ++i)
+        {
+            HeapifyUp(heap, i);
+        }
+    }
+    else
+    {
+        HeapifyAll(heap);
+    }
+
+    return 0;
 }
 
 int HeapPop(heap_t* heap)
@@ -166,8 +256,7 @@ int HeapPop(heap_t* heap)
     assert(0 == HeapIsEmpty(heap));
 
     heap_size = DvectorSize(heap->vector);
-
-    DvectorGetElement(heap->vector, heap_size - 1, &last_element);
+    last_element = Elements(heap)[heap_size - 1];
 
     pop_result = DvectorPopBack(heap->vector);
 
@@ -176,9 +265,10 @@ int HeapPop(heap_t* heap)
         return pop_result;
     }
 
+    /* popping may have shrunk the vector, fetch the array again */
     if (!HeapIsEmpty(heap))
     {
-        DvectorSetElement(heap->vector, 0, &last_element);
+        SetElement(heap, Elements(heap), 0, last_element);
         HeapifyDown(heap, 0);
     }
 
@@ -187,14 +277,10 @@ int HeapPop(heap_t* heap)
 
 void* HeapPeek(const heap_t* heap)
 {
-    void* data = NULL;
-
     assert(heap);
     assert(0 == HeapIsEmpty(heap));
 
-    DvectorGetElement(heap->vector, 0, &data);
-
-    return data;
+    return Elements(heap)[0];
 }
 
 size_t HeapSize(const heap_t* heap)
@@ -215,15 +301,12 @@ static ssize_t FindIndex(dvector_t* vector, void* param,
                         is_match_t is_match)
 {
     ssize_t i = 0;
-    void* runner = NULL;
+    void** elements = (void**)DvectorData(vector);
     size_t vector_size = DvectorSize(vector);
 
-
     for (; i < (ssize_t)vector_size; ++i)
     {
-        DvectorGetElement(vector, i, &runner);
-
-        if (1 == is_match(runner, param))
+        if (1 == is_match(elements[i], param))
         {
             return i;
         }
@@ -232,12 +315,30 @@ static ssize_t FindIndex(dvector_t* vector, void* param,
     return -1;
 }
 
-void* HeapRemove(heap_t* heap, void* param, is_match_t is_match)
+static void* RemoveAtIndex(heap_t* heap, size_t remove_idx)
 {
-    ssize_t remove_idx = 0;
     void* data_removed = NULL;
+    void* last_element = NULL;
     size_t heap_size = DvectorSize(heap->vector);
 
+    data_removed = Elements(heap)[remove_idx];
+    last_element = Elements(heap)[heap_size - 1];
+    DvectorPopBack(heap->vector);
+
+    /* the former last element may belong above or below the hole */
+    if (remove_idx < heap_size - 1)
+    {
+        SetElement(heap, Elements(heap), remove_idx, last_element);
+        Resift(heap, remove_idx);
+    }
+
+    return data_removed;
+}
+
+void* HeapRemove(heap_t* heap, void* param, is_match_t is_match)
+{
+    ssize_t remove_idx = 0;
+
     assert(heap);
 
     remove_idx = FindIndex(heap->vector, param, is_match);
@@ -247,10 +348,21 @@ void* HeapRemove(heap_t* heap, void* param, is_match_t is_match)
         return NULL;
     }
 
-    DvectorGetElement(heap->vector, (size_t)remove_idx, &data_removed);
-    SwapElements(heap->vector, (size_t)remove_idx, heap_size - 1);
-    DvectorPopBack(heap->vector);
-    HeapifyDown(heap, (size_t)remove_idx);
+    return RemoveAtIndex(heap, (size_t)remove_idx);
+}
 
-    return data_removed;
+void* HeapRemoveAt(heap_t* heap, size_t index)
+{
+    assert(heap);
+    assert(index < HeapSize(heap));
+
+    return RemoveAtIndex(heap, index);
+}
+
+void HeapUpdate(heap_t* heap, size_t index)
+{
+    assert(heap);
+    assert(index < HeapSize(heap));
+
+    Resift(heap, index);
 }
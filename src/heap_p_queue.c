@@ -13,7 +13,9 @@ struct heap_pq
     heap_t* heap;
 };
 
-heap_pq_t* HeapPQCreate(int (*compare_func)(const void*, const void*))
+heap_pq_t* HeapPQCreate(int (*compare_func)(const void*, const void*),
+                        void (*set_index)(void* data, size_t index),
+                        size_t arity)
 {
     heap_pq_t* heap_pq = NULL;
 
@@ -26,7 +28,7 @@ heap_pq_t* HeapPQCreate(int (*compare_func)(const void*, const void*))
         return NULL;
     }
 
-    heap_pq->heap = HeapCreate(compare_func);
+    heap_pq->heap = HeapCreate(compare_func, set_index, arity);
 
     if (NULL == heap_pq->heap)
     {
@@ -52,6 +54,13 @@ int HeapPQEnqueue(heap_pq_t* heap_pq, void* data)
     return HeapPush(heap_pq->heap, data);
 }
 
+int HeapPQEnqueueMany(heap_pq_t* heap_pq, void* const* data, size_t count)
+{
+    assert(heap_pq);
+
+    return HeapBuild(heap_pq->heap, data, count);
+}
+
 void* HeapPQDequeue(heap_pq_t* heap_pq)
 {
     void* removed_data = NULL;
@@ -106,3 +115,17 @@ void* HeapPQErase(heap_pq_t* heap_pq,
 
     return HeapRemove(heap_pq->heap, (void*)param, is_match);
 }
+
+void* HeapPQEraseAt(heap_pq_t* heap_pq, size_t index)
+{
+    assert(heap_pq);
+
+    return HeapRemoveAt(heap_pq->heap, index);
+}
+
+void HeapPQUpdate(heap_pq_t* heap_pq, size_t index)
+{
+    assert(heap_pq);
+
+    HeapUpdate(heap_pq->heap, index);
+}
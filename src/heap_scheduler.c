@@ -1,14 +1,26 @@
 /* heap_scheduler.c */
 
+#define _POSIX_C_SOURCE (200809L)   /* pthread_condattr_setclock */
+
 #include <assert.h>			    /* assert */
-#include <unistd.h>			    /* sleep */
+#include <errno.h>			    /* ETIMEDOUT */
+#include <pthread.h>		    /* pthread_mutex_t, pthread_cond_t */
 #include <stdlib.h>			    /* free */
-#include <time.h>			    /* time_t, time */
 
 #include "task.h"			    /* task functions */
-#include "heap_p_queue.h"       /* heap_pq_t */
+#include "mono_clock.h"         /* MonoClockNow */
+#include "deadline_heap.h"      /* deadline_heap_t */
+#include "timing_wheel.h"       /* timing_wheel_t */
+#include "uid_map.h"            /* uid_map_t */
+#include "slab_pool.h"          /* slab_pool_t */
+#include "worker_pool.h"        /* worker_pool_t */
+#include "fd_poller.h"          /* fd_poller_t */
+#include "dvector.h"            /* dvector_t */
 #include "heap_scheduler.h"
 
+#define WHEEL_TICK_US (MONO_USEC_PER_MSEC)
+#define MAX_FD_EVENTS (16)
+#define MIN_WATCHES (4)
 
 typedef enum signal
 {
@@ -18,71 +30,571 @@ typedef enum signal
 	CONTINUE = 3
 } signal_t;
 
+/* operations every queue backend provides to the scheduler */
+typedef struct queue_ops
+{
+	int (*push)(void* queue, task_t* task);
+	int (*push_many)(void* queue, task_t* const* tasks, size_t count);
+	void (*erase)(void* queue, task_t* task);
+	void (*update)(void* queue, task_t* task);
+	task_t* (*pop_due)(void* queue, mono_time_t now);
+	task_t* (*pop_any)(void* queue);
+	mono_time_t (*next_time)(const void* queue);
+	size_t (*size)(const void* queue);
+	void (*destroy)(void* queue);
+} queue_ops_t;
+
+/* a descriptor registered with @HeapSchedulerWatchFd */
+typedef struct watch
+{
+	int fd;
+	uint64_t key;				/* unique, unlike fd numbers which get reused */
+	void (*on_ready)(int fd, unsigned int events, void* params);
+	void* params;
+} watch_t;
+
+/* one run of a task, handed to a worker */
+typedef struct job
+{
+	heap_scheduler_t* scheduler;
+	task_t* task;
+	mono_time_t deadline;		/* the deadline this run was due at */
+} job_t;
+
 struct heap_scheduler
 {
-    heap_pq_t* heap_pq;
+    void* queue;
+    const queue_ops_t* ops;
+    uid_map_t* task_map;        /* uid -> task, for O(1) lookup on remove */
+    slab_pool_t* task_pool;     /* every task of the scheduler lives here */
+    worker_pool_t* workers;     /* NULL - actions run on the Run thread */
+    slab_pool_t* job_pool;      /* job_t of the runs handed to workers */
+    size_t num_of_running;      /* tasks out of the queue, running */
+    int is_kept_alive;          /* Run waits for tasks instead of returning */
+    fd_poller_t* poller;        /* NULL until a descriptor is watched */
+    dvector_t* watches;         /* watch_t, created with the poller */
+    uint64_t next_watch_key;
+    mono_time_t slack_us;       /* how late a wakeup may be to batch tasks */
     status_t status;
     signal_t signal;
+    pthread_mutex_t lock;       /* guards everything above */
+    pthread_cond_t wakeup;      /* monotonic, wakes the run loop early */
 };
 
 
 /*------------------------------static functions------------------------------*/
-static int CompareFunc(const void* data, const void* param);
-static int IsMatch(const void* task, const void* uid_to_compare);
-static void SleepUntilTaskExecution(heap_scheduler_t* scheduler);
-static void EventLoopHandler(heap_scheduler_t* scheduler);
+static int HeapQueuePush(void* queue, task_t* task);
+static int HeapQueuePushMany(void* queue, task_t* const* tasks, size_t count);
+static void HeapQueueErase(void* queue, task_t* task);
+static void HeapQueueUpdate(void* queue, task_t* task);
+static task_t* HeapQueuePopDue(void* queue, mono_time_t now);
+static task_t* HeapQueuePopAny(void* queue);
+static mono_time_t HeapQueueNextTime(const void* queue);
+static size_t HeapQueueSize(const void* queue);
+static void HeapQueueDestroy(void* queue);
+static int WheelQueuePush(void* queue, task_t* task);
+static int WheelQueuePushMany(void* queue, task_t* const* tasks, size_t count);
+static void WheelQueueErase(void* queue, task_t* task);
+static void WheelQueueUpdate(void* queue, task_t* task);
+static task_t* WheelQueuePopDue(void* queue, mono_time_t now);
+static task_t* WheelQueuePopAny(void* queue);
+static mono_time_t WheelQueueNextTime(const void* queue);
+static size_t WheelQueueSize(const void* queue);
+static void WheelQueueDestroy(void* queue);
+static void DestroyTask(heap_scheduler_t* scheduler, task_t* task);
+static void DestroyTasks(heap_scheduler_t* scheduler, task_t** tasks,
+							size_t count);
+static mono_time_t SleepUntilTaskExecution(heap_scheduler_t* scheduler);
+static mono_time_t WaitUntil(heap_scheduler_t* scheduler,
+								mono_time_t wake_time);
+static mono_time_t PollUntil(heap_scheduler_t* scheduler,
+								mono_time_t wake_time);
+static void DispatchFdEvent(heap_scheduler_t* scheduler,
+							const fd_poller_event_t* event);
+static long FindWatch(const heap_scheduler_t* scheduler, int fd,
+						uint64_t key);
+static void WakeLoop(heap_scheduler_t* scheduler);
+static int HasWork(const heap_scheduler_t* scheduler);
+static void RunTask(heap_scheduler_t* scheduler, task_t* task_to_run,
+						mono_time_t now);
+static void RunJob(void* params);
+static void RecordStart(task_t* task, mono_time_t deadline);
+static void FinishTask(heap_scheduler_t* scheduler, task_t* task,
+						int run_result);
+static void EventLoopHandler(heap_scheduler_t* scheduler, mono_time_t now);
 static status_t SignalHandler(heap_scheduler_t* scheduler);
+static void FreeScheduler(heap_scheduler_t* scheduler);
+static int InitSync(heap_scheduler_t* scheduler);
+static uid_t AddTask(heap_scheduler_t* scheduler, uid_t uid,
+						int (*action_func)(void* params), void* params,
+						size_t interval_us);
+static int AddTasks(heap_scheduler_t* scheduler, const sched_task_t* tasks,
+					size_t count, uid_t* uids);
+static int RemoveTask(heap_scheduler_t* scheduler, uid_t identifier);
+static int RescheduleTask(heap_scheduler_t* scheduler, uid_t identifier,
+							mono_time_t new_time);
+static void ClearTasks(heap_scheduler_t* scheduler);
+static task_t* GetRunningTask(void);
+static void SetRunningTask(task_t* task);
+
+/* the task whose action runs on this thread, tells a self-removal apart */
+#ifdef __GNUC__
+static __thread task_t* g_running_task = NULL;
+#else
+static pthread_key_t g_running_task_key;
+static pthread_once_t g_running_task_once = PTHREAD_ONCE_INIT;
+
+static void CreateRunningTaskKey(void)
+{
+	pthread_key_create(&g_running_task_key, NULL);
+}
+#endif
+
+static const queue_ops_t heap_queue_ops =
+{
+	HeapQueuePush,
+	HeapQueuePushMany,
+	HeapQueueErase,
+	HeapQueueUpdate,
+	HeapQueuePopDue,
+	HeapQueuePopAny,
+	HeapQueueNextTime,
+	HeapQueueSize,
+	HeapQueueDestroy
+};
+
+static const queue_ops_t wheel_queue_ops =
+{
+	WheelQueuePush,
+	WheelQueuePushMany,
+	WheelQueueErase,
+	WheelQueueUpdate,
+	WheelQueuePopDue,
+	WheelQueuePopAny,
+	WheelQueueNextTime,
+	WheelQueueSize,
+	WheelQueueDestroy
+};
 
 
 /*------------------------static functions implementations--------------------*/
-static int CompareFunc(const void* data, const void* param)
+static int HeapQueuePush(void* queue, task_t* task)
+{
+	return DeadlineHeapPush((deadline_heap_t*)queue, task);
+}
+
+static int HeapQueuePushMany(void* queue, task_t* const* tasks, size_t count)
 {
-	return (*((time_t*)data) - *((time_t*)param));
+	return DeadlineHeapPushMany((deadline_heap_t*)queue, tasks, count);
 }
 
-static int IsMatch(const void* task, const void* uid_to_compare)
+static void HeapQueueErase(void* queue, task_t* task)
 {
-	uid_t task_uid = TaskGetUID((task_t*)task);
+	DeadlineHeapRemoveAt((deadline_heap_t*)queue, TaskGetQueueIndex(task));
+}
 
-	return UIDIsSame(task_uid, *((uid_t*)uid_to_compare));
+static void HeapQueueUpdate(void* queue, task_t* task)
+{
+	DeadlineHeapUpdate((deadline_heap_t*)queue, TaskGetQueueIndex(task));
 }
 
-static void SleepUntilTaskExecution(heap_scheduler_t* scheduler)
+static task_t* HeapQueuePopDue(void* queue, mono_time_t now)
 {
-	time_t time_to_wait = 0;
-	time_t next_time = 0;
-	task_t* task_to_run = NULL;
+	deadline_heap_t* heap = (deadline_heap_t*)queue;
+
+	if (DeadlineHeapIsEmpty(heap) || (DeadlineHeapPeekTime(heap) > now))
+	{
+		return NULL;
+	}
+
+	return DeadlineHeapPop(heap);
+}
+
+static task_t* HeapQueuePopAny(void* queue)
+{
+	return DeadlineHeapPop((deadline_heap_t*)queue);
+}
+
+static mono_time_t HeapQueueNextTime(const void* queue)
+{
+	return DeadlineHeapPeekTime((const deadline_heap_t*)queue);
+}
+
+static size_t HeapQueueSize(const void* queue)
+{
+	return DeadlineHeapSize((const deadline_heap_t*)queue);
+}
+
+static void HeapQueueDestroy(void* queue)
+{
+	DeadlineHeapDestroy((deadline_heap_t*)queue);
+}
+
+static int WheelQueuePush(void* queue, task_t* task)
+{
+	return TimingWheelAdd((timing_wheel_t*)queue, task);
+}
+
+/* adding to the wheel is O(1) already, only all-or-nothing is needed */
+static int WheelQueuePushMany(void* queue, task_t* const* tasks, size_t count)
+{
+	size_t i = 0;
+
+	for (i = 0; i < count; ++i)
+	{
+		if (0 != TimingWheelAdd((timing_wheel_t*)queue, tasks[i]))
+		{
+			while (i-- > 0)
+			{
+				TimingWheelRemove((timing_wheel_t*)queue, tasks[i]);
+			}
 
-	task_to_run = HeapPQPeek(scheduler->heap_pq);
-	next_time = (time_t)TaskGetScheduledTime(task_to_run);
-	time_to_wait = (time(NULL) <= next_time) ? next_time - time(NULL) : 0;
+			return 1;
+		}
+	}
 
-	sleep(time_to_wait);
+	return 0;
 }
 
-static void EventLoopHandler(heap_scheduler_t* scheduler)
+static void WheelQueueErase(void* queue, task_t* task)
+{
+	TimingWheelRemove((timing_wheel_t*)queue, task);
+}
+
+static void WheelQueueUpdate(void* queue, task_t* task)
+{
+	TimingWheelUpdate((timing_wheel_t*)queue, task);
+}
+
+static task_t* WheelQueuePopDue(void* queue, mono_time_t now)
+{
+	return TimingWheelPopExpired((timing_wheel_t*)queue, now);
+}
+
+static task_t* WheelQueuePopAny(void* queue)
+{
+	return TimingWheelPopAny((timing_wheel_t*)queue);
+}
+
+static mono_time_t WheelQueueNextTime(const void* queue)
+{
+	return TimingWheelNextExpiry((const timing_wheel_t*)queue);
+}
+
+static size_t WheelQueueSize(const void* queue)
+{
+	return TimingWheelSize((const timing_wheel_t*)queue);
+}
+
+static void WheelQueueDestroy(void* queue)
+{
+	TimingWheelDestroy((timing_wheel_t*)queue);
+}
+
+static void DestroyTask(heap_scheduler_t* scheduler, task_t* task)
+{
+	UIDMapRemove(scheduler->task_map, TaskGetUID(task));
+	TaskDestroy(task);
+}
+
+static void DestroyTasks(heap_scheduler_t* scheduler, task_t** tasks,
+							size_t count)
+{
+	size_t i = 0;
+
+	for (i = 0; i < count; ++i)
+	{
+		DestroyTask(scheduler, tasks[i]);
+	}
+}
+
+/*
+* waits, unlocked, until the next task is due or another thread changes the
+* scheduler, and returns the time to run tasks up to. Once descriptors are
+* watched, the wait is an epoll wait that also serves them. Called and
+* returns with the lock held
+*/
+static mono_time_t SleepUntilTaskExecution(heap_scheduler_t* scheduler)
+{
+	mono_time_t now = MonoClockNow();
+	/* every task is on a worker, or none left - wait for one to come */
+	mono_time_t wake_time = FD_POLLER_NO_DEADLINE;
+
+	if (0 != scheduler->ops->size(scheduler->queue))
+	{
+		/* with slack, the wakeup waits so tasks due shortly after run too */
+		wake_time = scheduler->ops->next_time(scheduler->queue) +
+					scheduler->slack_us;
+
+		if (wake_time <= now)
+		{
+			return now;
+		}
+	}
+
+	if (NULL != scheduler->poller)
+	{
+		return PollUntil(scheduler, wake_time);
+	}
+
+	return WaitUntil(scheduler, wake_time);
+}
+
+/*
+* a timed out wait guarantees its deadline passed, so only an early wakeup
+* reads the clock again
+*/
+static mono_time_t WaitUntil(heap_scheduler_t* scheduler,
+								mono_time_t wake_time)
+{
+	struct timespec wake_ts;
+
+	if (FD_POLLER_NO_DEADLINE == wake_time)
+	{
+		pthread_cond_wait(&scheduler->wakeup, &scheduler->lock);
+		return MonoClockNow();
+	}
+
+	MonoClockToTimespec(wake_time, &wake_ts);
+
+	if (ETIMEDOUT == pthread_cond_timedwait(&scheduler->wakeup,
+											&scheduler->lock, &wake_ts))
+	{
+		return wake_time;
+	}
+
+	/* woken by Add / Remove / Stop ... - the caller re-evaluates */
+	return MonoClockNow();
+}
+
+static mono_time_t PollUntil(heap_scheduler_t* scheduler,
+								mono_time_t wake_time)
+{
+	int i = 0;
+	int num_of_events = 0;
+	fd_poller_event_t events[MAX_FD_EVENTS];
+
+	pthread_mutex_unlock(&scheduler->lock);
+	num_of_events = FdPollerWait(scheduler->poller, wake_time, events,
+									MAX_FD_EVENTS);
+	pthread_mutex_lock(&scheduler->lock);
+
+	if (-1 == num_of_events)
+	{
+		scheduler->signal = ERR;
+	}
+
+	/* level triggered - whatever is left is reported again next time */
+	for (i = 0; (i < num_of_events) && (CONTINUE == scheduler->signal); ++i)
+	{
+		DispatchFdEvent(scheduler, &events[i]);
+	}
+
+	return MonoClockNow();
+}
+
+/* calls the watch's callback unlocked, unless it was unwatched meanwhile */
+static void DispatchFdEvent(heap_scheduler_t* scheduler,
+							const fd_poller_event_t* event)
+{
+	watch_t watch;
+	long index = FindWatch(scheduler, -1, event->key);
+
+	if (-1 == index)
+	{
+		return;
+	}
+
+	DvectorGetElement(scheduler->watches, (size_t)index, &watch);
+
+	pthread_mutex_unlock(&scheduler->lock);
+	watch.on_ready(watch.fd, event->events, watch.params);
+	pthread_mutex_lock(&scheduler->lock);
+}
+
+/* index of the watch of @fd, or with @key if @fd is -1. -1 if not found */
+static long FindWatch(const heap_scheduler_t* scheduler, int fd,
+						uint64_t key)
+{
+	size_t i = 0;
+	const watch_t* watches = NULL;
+
+	if (NULL == scheduler->watches)
+	{
+		return -1;
+	}
+
+	watches = (const watch_t*)DvectorData(scheduler->watches);
+
+	for (i = 0; i < DvectorSize(scheduler->watches); ++i)
+	{
+		if ((-1 == fd) ? (key == watches[i].key) : (fd == watches[i].fd))
+		{
+			return (long)i;
+		}
+	}
+
+	return -1;
+}
+
+/* called with the lock held after anything the run loop must re-evaluate */
+static void WakeLoop(heap_scheduler_t* scheduler)
+{
+	pthread_cond_signal(&scheduler->wakeup);
+
+	if (NULL != scheduler->poller)
+	{
+		FdPollerWake(scheduler->poller);
+	}
+}
+
+/* whether Run has anything left to wait for */
+static int HasWork(const heap_scheduler_t* scheduler)
+{
+	return ((0 != scheduler->ops->size(scheduler->queue)) ||
+			(0 != scheduler->num_of_running) || scheduler->is_kept_alive ||
+			((NULL != scheduler->watches) &&
+			(0 != DvectorSize(scheduler->watches))));
+}
+
+static void RunTask(heap_scheduler_t* scheduler, task_t* task_to_run,
+						mono_time_t now)
 {
 	int run_result = 0;
-	task_t* task_to_run = NULL;
+	job_t* job = NULL;
+	job_t inline_job;
+	task_t* outer_task = NULL;		/* an action may run a nested scheduler */
 
-	assert(scheduler);
+	inline_job.scheduler = scheduler;
+	inline_job.task = task_to_run;
+	inline_job.deadline = TaskGetScheduledTime(task_to_run);
+
+	TaskAdvance(task_to_run, now);
+	TaskSetRunning(task_to_run, 1);
+	++(scheduler->num_of_running);
+
+	if (NULL != scheduler->workers)
+	{
+		job = (job_t*)SlabPoolAlloc(scheduler->job_pool);
+
+		if (NULL != job)
+		{
+			*job = inline_job;
+
+			if (0 == WorkerPoolSubmit(scheduler->workers, RunJob, job))
+			{
+				return;
+			}
+
+			SlabPoolFree(scheduler->job_pool, job);
+		}
+
+		/* couldn't hand it over, run it here rather than drop it */
+	}
+
+	RecordStart(task_to_run, inline_job.deadline);
+
+	/* the action may call back into the scheduler, run it unlocked */
+	pthread_mutex_unlock(&scheduler->lock);
+	outer_task = GetRunningTask();
+	SetRunningTask(task_to_run);
+	run_result = TaskExecute(task_to_run);
+	SetRunningTask(outer_task);
+	pthread_mutex_lock(&scheduler->lock);
+
+	FinishTask(scheduler, task_to_run, run_result);
+}
+
+/* worker side of @RunTask */
+static void RunJob(void* params)
+{
+	job_t* job = (job_t*)params;
+	heap_scheduler_t* scheduler = job->scheduler;
+	task_t* task = job->task;
+	int run_result = 0;
+
+	pthread_mutex_lock(&scheduler->lock);
+	RecordStart(task, job->deadline);
+	SlabPoolFree(scheduler->job_pool, job);
+	pthread_mutex_unlock(&scheduler->lock);
+
+	SetRunningTask(task);
+	run_result = TaskExecute(task);
+	SetRunningTask(NULL);
+
+	pthread_mutex_lock(&scheduler->lock);
+	FinishTask(scheduler, task, run_result);
+	/* the task may now be the earliest one, or the last one to finish */
+	WakeLoop(scheduler);
+	pthread_mutex_unlock(&scheduler->lock);
+}
+
+static task_t* GetRunningTask(void)
+{
+#ifdef __GNUC__
+	return g_running_task;
+#else
+	pthread_once(&g_running_task_once, CreateRunningTaskKey);
+
+	return (task_t*)pthread_getspecific(g_running_task_key);
+#endif
+}
+
+static void SetRunningTask(task_t* task)
+{
+#ifdef __GNUC__
+	g_running_task = task;
+#else
+	pthread_once(&g_running_task_once, CreateRunningTaskKey);
+	pthread_setspecific(g_running_task_key, task);
+#endif
+}
 
-	task_to_run = HeapPQDequeue(scheduler->heap_pq);
+/* called with the lock held, right before the action is called */
+static void RecordStart(task_t* task, mono_time_t deadline)
+{
+	mono_time_t start = MonoClockNow();
+
+	TaskRecordLateness(task, (start > deadline) ? (start - deadline) : 0);
+}
 
-	run_result = TaskRun(task_to_run);
+/* puts a task back after its run, or drops it if its action returned
+nonzero or it was removed while running. Called with the lock held */
+static void FinishTask(heap_scheduler_t* scheduler, task_t* task,
+						int run_result)
+{
+	TaskSetRunning(task, 0);
+	--(scheduler->num_of_running);
 
-	if (0 == run_result)
+	if ((0 == run_result) && !TaskIsRemoved(task))
 	{
-		if (0 != HeapPQEnqueue(scheduler->heap_pq, task_to_run))
+		if (0 != scheduler->ops->push(scheduler->queue, task))
 		{
-			TaskDestroy(task_to_run);
+			DestroyTask(scheduler, task);
 			scheduler->signal = ERR;
 		}
 	}
 
 	else	/* params = 0 */
 	{
-		TaskDestroy(task_to_run);
+		DestroyTask(scheduler, task);
+	}
+}
+
+/* runs every task due by @now as one batch. The heap runs it in deadline
+order; the wheel in tick order, tasks that share a tick in insertion order */
+static void EventLoopHandler(heap_scheduler_t* scheduler, mono_time_t now)
+{
+	task_t* task_to_run = NULL;
+
+	assert(scheduler);
+
+	/* a NULL first pop is a wakeup for an internal event of the queue */
+	while ((CONTINUE == scheduler->signal) &&
+			(NULL != (task_to_run = scheduler->ops->pop_due(scheduler->queue,
+															now))))
+	{
+		RunTask(scheduler, task_to_run, now);
 	}
 }
 
@@ -91,9 +603,9 @@ static status_t SignalHandler(heap_scheduler_t* scheduler)
 	switch (scheduler->signal)
 	{
 		case DESTROY:
+			/* freed by the caller, once the lock is released */
 			scheduler->status = DESTROYED;
-			HeapSchedulerDestroy(scheduler);
-			return DESTROYED;
+			break;
 
 		case STOP:
 			scheduler->status = STOPPED;
@@ -111,7 +623,220 @@ static status_t SignalHandler(heap_scheduler_t* scheduler)
 	return scheduler->status;
 }
 
+static void FreeScheduler(heap_scheduler_t* scheduler)
+{
+	/* first, so no worker is left finishing a run of this scheduler */
+	WorkerPoolDestroy(scheduler->workers);
+	SlabPoolDestroy(scheduler->job_pool);
+	FdPollerDestroy(scheduler->poller);
+	DvectorDestroy(scheduler->watches);
+	/* the tasks hold nothing but pool memory, drop them all at once */
+	scheduler->ops->destroy(scheduler->queue);
+	UIDMapDestroy(scheduler->task_map);
+	SlabPoolDestroy(scheduler->task_pool);
+	pthread_cond_destroy(&scheduler->wakeup);
+	pthread_mutex_destroy(&scheduler->lock);
+	free(scheduler);
+}
+
+static int InitSync(heap_scheduler_t* scheduler)
+{
+	pthread_condattr_t attr;
+
+	if (0 != pthread_mutex_init(&scheduler->lock, NULL))
+	{
+		return 1;
+	}
+
+	if (0 != pthread_condattr_init(&attr))
+	{
+		pthread_mutex_destroy(&scheduler->lock);
+		return 1;
+	}
+
+	/* timed waits use absolute monotonic deadlines, like the tasks */
+	if ((0 != pthread_condattr_setclock(&attr, CLOCK_MONOTONIC)) ||
+		(0 != pthread_cond_init(&scheduler->wakeup, &attr)))
+	{
+		pthread_condattr_destroy(&attr);
+		pthread_mutex_destroy(&scheduler->lock);
+		return 1;
+	}
+
+	pthread_condattr_destroy(&attr);
+
+	return 0;
+}
+
+static uid_t AddTask(heap_scheduler_t* scheduler, uid_t uid,
+						int (*action_func)(void* params), void* params,
+						size_t interval_us)
+{
+	int result_enqueue = 0;
+	task_t* task_to_add = NULL;
+
+	/* a uid given by the caller might already be taken */
+	if (UIDIsSame(bad_uid, uid) ||
+		(NULL != UIDMapFind(scheduler->task_map, uid)))
+	{
+		return bad_uid;
+	}
+
+	task_to_add = TaskCreateFromPoolWithUID(scheduler->task_pool, uid,
+											action_func, params, interval_us);
+
+	if (NULL == task_to_add)
+	{
+		return bad_uid;
+	}
+
+	if (0 != UIDMapInsert(scheduler->task_map, TaskGetUID(task_to_add),
+							task_to_add))
+	{
+		TaskDestroy(task_to_add);
+		return bad_uid;
+	}
+
+	result_enqueue = scheduler->ops->push(scheduler->queue, task_to_add);
+
+	if (0 != result_enqueue)
+	{
+		DestroyTask(scheduler, task_to_add);
+		return bad_uid;
+	}
+
+	return TaskGetUID(task_to_add);
+}
+
+static int AddTasks(heap_scheduler_t* scheduler, const sched_task_t* tasks,
+					size_t count, uid_t* uids)
+{
+	size_t i = 0;
+	task_t** batch = NULL;
+
+	if (0 == count)
+	{
+		return 0;
+	}
+
+	/* after these, creating and indexing the tasks can't allocate */
+	if ((0 != SlabPoolReserve(scheduler->task_pool, count)) ||
+		(0 != UIDMapReserve(scheduler->task_map, count)))
+	{
+		return 1;
+	}
+
+	batch = (task_t**)malloc(count * sizeof(task_t*));
+
+	if (NULL == batch)
+	{
+		return 1;
+	}
+
+	for (i = 0; i < count; ++i)
+	{
+		assert(tasks[i].action_func);
+
+		batch[i] = TaskCreateFromPool(scheduler->task_pool,
+						tasks[i].action_func, tasks[i].params,
+						tasks[i].interval_us);
+
+		if ((NULL == batch[i]) ||
+			(0 != UIDMapInsert(scheduler->task_map, TaskGetUID(batch[i]),
+								batch[i])))
+		{
+			TaskDestroy(batch[i]);
+			DestroyTasks(scheduler, batch, i);
+			free(batch);
+			return 1;
+		}
+	}
+
+	if (0 != scheduler->ops->push_many(scheduler->queue, batch, count))
+	{
+		DestroyTasks(scheduler, batch, count);
+		free(batch);
+		return 1;
+	}
+
+	if (NULL != uids)
+	{
+		for (i = 0; i < count; ++i)
+		{
+			uids[i] = TaskGetUID(batch[i]);
+		}
+	}
+
+	free(batch);
+
+	return 0;
+}
+
+static int RemoveTask(heap_scheduler_t* scheduler, uid_t identifier)
+{
+	task_t* task_to_remove = NULL;
+
+	task_to_remove = UIDMapFind(scheduler->task_map, identifier);
+
+	/* a task removing itself is not found, see the API documentation */
+	if ((NULL == task_to_remove) || (GetRunningTask() == task_to_remove) ||
+		TaskIsRemoved(task_to_remove))
+	{
+		return 1;
+	}
+
+	/* running elsewhere, out of the queue; dropped once its action returns */
+	if (TaskIsRunning(task_to_remove))
+	{
+		TaskSetRemoved(task_to_remove);
+
+		return 0;
+	}
+
+	scheduler->ops->erase(scheduler->queue, task_to_remove);
+	DestroyTask(scheduler, task_to_remove);
+
+	return 0;
+}
+
+static int RescheduleTask(heap_scheduler_t* scheduler, uid_t identifier,
+							mono_time_t new_time)
+{
+	task_t* task = NULL;
+
+	task = UIDMapFind(scheduler->task_map, identifier);
+
+	if ((NULL == task) || TaskIsRemoved(task))
+	{
+		return 1;
+	}
+
+	TaskSetScheduledTime(task, new_time);
+
+	/* a running task is re-enqueued with its new time once it returns */
+	if (!TaskIsRunning(task))
+	{
+		scheduler->ops->update(scheduler->queue, task);
+	}
+
+	return 0;
+}
+
+static void ClearTasks(heap_scheduler_t* scheduler)
+{
+	while (0 != scheduler->ops->size(scheduler->queue))
+	{
+		DestroyTask(scheduler, scheduler->ops->pop_any(scheduler->queue));
+	}
+}
+
 heap_scheduler_t* HeapSchedulerCreate()
+{
+	return HeapSchedulerCreateEx(SCHED_BACKEND_HEAP, 0);
+}
+
+heap_scheduler_t* HeapSchedulerCreateEx(sched_backend_t backend,
+										size_t capacity_hint)
 {
 	heap_scheduler_t* scheduler = (heap_scheduler_t*)malloc(
                                     sizeof(heap_scheduler_t));
@@ -121,14 +846,48 @@ heap_scheduler_t* HeapSchedulerCreate()
 		return NULL;
 	}
 
-	scheduler->heap_pq = HeapPQCreate(CompareFunc);
+	switch (backend)
+	{
+		case SCHED_BACKEND_TIMING_WHEEL:
+			scheduler->queue = TimingWheelCreate(WHEEL_TICK_US,
+													MonoClockNow());
+			scheduler->ops = &wheel_queue_ops;
+			break;
+
+		default:
+			scheduler->queue = DeadlineHeapCreate(capacity_hint);
+			scheduler->ops = &heap_queue_ops;
+			break;
+	}
+
+	if (NULL == scheduler->queue)
+	{
+		free(scheduler);
+		return NULL;
+	}
+
+	scheduler->task_map = UIDMapCreate(capacity_hint);
+	scheduler->task_pool = TaskPoolCreate(capacity_hint);
+	scheduler->job_pool = SlabPoolCreate(sizeof(job_t), 0);
 
-	if (NULL == scheduler->heap_pq)
+	if ((NULL == scheduler->task_map) || (NULL == scheduler->task_pool) ||
+		(NULL == scheduler->job_pool) || (0 != InitSync(scheduler)))
 	{
+		SlabPoolDestroy(scheduler->job_pool);
+		SlabPoolDestroy(scheduler->task_pool);
+		UIDMapDestroy(scheduler->task_map);
+		scheduler->ops->destroy(scheduler->queue);
 		free(scheduler);
 		return NULL;
 	}
 
+	scheduler->workers = NULL;
+	scheduler->num_of_running = 0;
+	scheduler->is_kept_alive = 0;
+	scheduler->poller = NULL;
+	scheduler->watches = NULL;
+	scheduler->next_watch_key = 0;
+	scheduler->slack_us = 0;
 	scheduler->status = SUCCESS;
 	scheduler->signal = CONTINUE;
 
@@ -139,117 +898,389 @@ void HeapSchedulerDestroy(heap_scheduler_t* scheduler)
 {
 	assert(scheduler);
 
+	pthread_mutex_lock(&scheduler->lock);
+
 	if (RUNNING == scheduler->status)
 	{
 		scheduler->signal = DESTROY;
+		WakeLoop(scheduler);
+		pthread_mutex_unlock(&scheduler->lock);
 		return;
 	}
 
-	HeapSchedulerClear(scheduler);
-	HeapPQDestroy(scheduler->heap_pq);
-	free(scheduler);
+	pthread_mutex_unlock(&scheduler->lock);
+	FreeScheduler(scheduler);
 }
 
 uid_t HeapSchedulerAdd(heap_scheduler_t* scheduler,
 					   int (*action_func)(void* params),
 					   void* params,
-					   size_t interval_sec)
+					   size_t interval_us)
 {
-	int result_enqueue = 0;
-	task_t* task_to_add = NULL;
+	uid_t uid;
 
 	assert(scheduler);
 	assert(action_func);
 
-	task_to_add = TaskCreate(action_func, params, interval_sec);
+	pthread_mutex_lock(&scheduler->lock);
+	uid = AddTask(scheduler, UIDCreate(), action_func, params, interval_us);
+	/* the new task may be due before the deadline the loop waits for */
+	WakeLoop(scheduler);
+	pthread_mutex_unlock(&scheduler->lock);
 
-	if (NULL == task_to_add)
+	return uid;
+}
+
+uid_t HeapSchedulerAddWithUID(heap_scheduler_t* scheduler, uid_t uid,
+								int (*action_func)(void* params),
+								void* params, size_t interval_us)
+{
+	assert(scheduler);
+	assert(action_func);
+
+	pthread_mutex_lock(&scheduler->lock);
+	uid = AddTask(scheduler, uid, action_func, params, interval_us);
+	WakeLoop(scheduler);
+	pthread_mutex_unlock(&scheduler->lock);
+
+	return uid;
+}
+
+int HeapSchedulerAddBatch(heap_scheduler_t* scheduler,
+							const sched_task_t* tasks, size_t count,
+							uid_t* uids)
+{
+	int result = 0;
+
+	assert(scheduler);
+	assert(tasks || (0 == count));
+
+	pthread_mutex_lock(&scheduler->lock);
+	result = AddTasks(scheduler, tasks, count, uids);
+	WakeLoop(scheduler);
+	pthread_mutex_unlock(&scheduler->lock);
+
+	return result;
+}
+
+int HeapSchedulerRemove(heap_scheduler_t* scheduler, uid_t identifier)
+{
+	int result = 0;
+
+	assert(scheduler);
+
+	pthread_mutex_lock(&scheduler->lock);
+	result = RemoveTask(scheduler, identifier);
+	/* the loop may be waiting for the removed task, or have none left */
+	WakeLoop(scheduler);
+	pthread_mutex_unlock(&scheduler->lock);
+
+	return result;
+}
+
+int HeapSchedulerReschedule(heap_scheduler_t* scheduler, uid_t identifier,
+							mono_time_t new_time)
+{
+	int result = 0;
+
+	assert(scheduler);
+
+	pthread_mutex_lock(&scheduler->lock);
+	result = RescheduleTask(scheduler, identifier, new_time);
+	WakeLoop(scheduler);
+	pthread_mutex_unlock(&scheduler->lock);
+
+	return result;
+}
+
+status_t HeapSchedulerRun(heap_scheduler_t* scheduler)
+{
+	status_t status = SUCCESS;
+
+	assert(scheduler);
+
+	pthread_mutex_lock(&scheduler->lock);
+
+	if (RUNNING == scheduler->status)
 	{
-		return bad_uid;
+		pthread_mutex_unlock(&scheduler->lock);
+		return RUNNING;
 	}
 
-	result_enqueue = HeapPQEnqueue(scheduler->heap_pq, task_to_add);
+	scheduler->status = RUNNING;
 
-	if (0 != result_enqueue)
+	/* a stop sent before the run started still stops it */
+	if (STOP != scheduler->signal)
 	{
-		TaskDestroy(task_to_add);
-		return bad_uid;
+		scheduler->signal = CONTINUE;
 	}
 
-	return TaskGetUID(task_to_add);
+	/* "Event" loop - running */
+	while ((CONTINUE == scheduler->signal) && HasWork(scheduler))
+	{
+		EventLoopHandler(scheduler, SleepUntilTaskExecution(scheduler));
+	}
+
+	status = SignalHandler(scheduler);
+
+	/* this run consumed the stop, the next one starts clean */
+	if (STOPPED == status)
+	{
+		scheduler->signal = CONTINUE;
+	}
+
+	pthread_mutex_unlock(&scheduler->lock);
+
+	if (DESTROYED == status)
+	{
+		FreeScheduler(scheduler);
+	}
+
+	return status;
 }
 
-int HeapSchedulerRemove(heap_scheduler_t* scheduler, uid_t identifier)
+void HeapSchedulerSetSlack(heap_scheduler_t* scheduler, size_t slack_us)
 {
-	task_t* task_to_remove = NULL;
+	assert(scheduler);
+
+	pthread_mutex_lock(&scheduler->lock);
+	scheduler->slack_us = (mono_time_t)slack_us;
+	pthread_mutex_unlock(&scheduler->lock);
+}
+
+int HeapSchedulerSetWorkers(heap_scheduler_t* scheduler,
+							size_t num_of_workers)
+{
+	worker_pool_t* old_workers = NULL;
+	worker_pool_t* new_workers = NULL;
 
 	assert(scheduler);
 
-	task_to_remove = HeapPQErase(scheduler->heap_pq, IsMatch, &identifier);
+	if (0 != num_of_workers)
+	{
+		new_workers = WorkerPoolCreate(num_of_workers);
+
+		if (NULL == new_workers)
+		{
+			return 1;
+		}
+	}
+
+	pthread_mutex_lock(&scheduler->lock);
+	assert(RUNNING != scheduler->status);
+	old_workers = scheduler->workers;
+	scheduler->workers = new_workers;
+	pthread_mutex_unlock(&scheduler->lock);
+
+	/* unlocked - the runs it still has need the lock to finish */
+	WorkerPoolDestroy(old_workers);
+
+	return 0;
+}
+
+int HeapSchedulerGetTaskStats(const heap_scheduler_t* scheduler,
+								uid_t identifier, sched_task_stats_t* stats)
+{
+	task_t* task = NULL;
+	task_stats_t task_stats;
+	/* taking the lock doesn't change the scheduler's state */
+	heap_scheduler_t* locked = (heap_scheduler_t*)scheduler;
+
+	assert(scheduler);
+	assert(stats);
+
+	pthread_mutex_lock(&locked->lock);
+	task = UIDMapFind(scheduler->task_map, identifier);
+
+	if (NULL != task)
+	{
+		TaskGetStats(task, &task_stats);
+	}
+
+	pthread_mutex_unlock(&locked->lock);
 
-	if (NULL == task_to_remove)
+	if (NULL == task)
 	{
 		return 1;
 	}
 
-	TaskDestroy(task_to_remove);
+	stats->num_of_runs = task_stats.num_of_runs;
+	stats->num_of_missed = task_stats.num_of_missed;
+	stats->last_lateness_us = task_stats.last_lateness_us;
+	stats->max_lateness_us = task_stats.max_lateness_us;
+	stats->mean_lateness_us = (0 == task_stats.num_of_runs) ? 0 :
+						task_stats.total_lateness_us / task_stats.num_of_runs;
+
 	return 0;
 }
 
-status_t HeapSchedulerRun(heap_scheduler_t* scheduler)
+void HeapSchedulerSetKeepAlive(heap_scheduler_t* scheduler, int keep_alive)
 {
 	assert(scheduler);
 
-	if (RUNNING == scheduler->status)
+	pthread_mutex_lock(&scheduler->lock);
+	scheduler->is_kept_alive = keep_alive;
+	/* a run waiting on an empty queue may have to return now */
+	WakeLoop(scheduler);
+	pthread_mutex_unlock(&scheduler->lock);
+}
+
+int HeapSchedulerSetMissPolicy(heap_scheduler_t* scheduler, uid_t identifier,
+								sched_miss_policy_t policy)
+{
+	task_t* task = NULL;
+	task_miss_policy_t task_policy = TASK_MISS_CATCH_UP;
+
+	assert(scheduler);
+
+	switch (policy)
 	{
-		return RUNNING;
+		case SCHED_MISS_SKIP:
+			task_policy = TASK_MISS_SKIP;
+			break;
+
+		case SCHED_MISS_REALIGN:
+			task_policy = TASK_MISS_REALIGN;
+			break;
+
+		default:
+			task_policy = TASK_MISS_CATCH_UP;
+			break;
 	}
 
-	scheduler->status = RUNNING;
-	scheduler->signal = CONTINUE;
+	pthread_mutex_lock(&scheduler->lock);
+	task = UIDMapFind(scheduler->task_map, identifier);
 
-	/* "Event" loop - running */
-	while ((CONTINUE == scheduler->signal) &&
-            (!HeapPQIsEmpty(scheduler->heap_pq)))
+	if (NULL != task)
 	{
-		SleepUntilTaskExecution(scheduler);
+		TaskSetMissPolicy(task, task_policy);
+	}
+
+	pthread_mutex_unlock(&scheduler->lock);
+
+	return (NULL == task);
+}
+
+int HeapSchedulerWatchFd(heap_scheduler_t* scheduler, int fd,
+							unsigned int events,
+							void (*on_ready)(int fd, unsigned int events,
+												void* params),
+							void* params)
+{
+	watch_t watch;
+	int result = 1;
+
+	assert(scheduler);
+	assert(on_ready);
+
+	watch.fd = fd;
+	watch.on_ready = on_ready;
+	watch.params = params;
+
+	pthread_mutex_lock(&scheduler->lock);
 
-		EventLoopHandler(scheduler);
+	/* the poller replaces the condition variable from the next wait on */
+	if (NULL == scheduler->poller)
+	{
+		scheduler->watches = DvectorCreate(MIN_WATCHES, sizeof(watch_t));
+		scheduler->poller = (NULL == scheduler->watches) ? NULL :
+															FdPollerCreate();
+
+		if (NULL == scheduler->poller)
+		{
+			DvectorDestroy(scheduler->watches);
+			scheduler->watches = NULL;
+			pthread_mutex_unlock(&scheduler->lock);
+			return 1;
+		}
 	}
 
-	return SignalHandler(scheduler);
+	watch.key = scheduler->next_watch_key++;
+
+	if ((-1 == FindWatch(scheduler, fd, 0)) &&
+		(0 == DvectorPushBack(scheduler->watches, &watch)))
+	{
+		result = FdPollerAdd(scheduler->poller, fd, events, watch.key);
+
+		if (0 != result)
+		{
+			DvectorPopBack(scheduler->watches);
+		}
+	}
+
+	WakeLoop(scheduler);
+	pthread_mutex_unlock(&scheduler->lock);
+
+	return result;
+}
+
+int HeapSchedulerUnwatchFd(heap_scheduler_t* scheduler, int fd)
+{
+	long index = -1;
+
+	assert(scheduler);
+
+	pthread_mutex_lock(&scheduler->lock);
+	index = FindWatch(scheduler, fd, 0);
+
+	if (-1 != index)
+	{
+		FdPollerRemove(scheduler->poller, fd);
+		DvectorSwap(scheduler->watches, (size_t)index,
+					DvectorSize(scheduler->watches) - 1);
+		DvectorPopBack(scheduler->watches);
+		/* the loop may have been waiting for this descriptor only */
+		WakeLoop(scheduler);
+	}
+
+	pthread_mutex_unlock(&scheduler->lock);
+
+	return (-1 == index);
 }
 
 void HeapSchedulerStop(heap_scheduler_t* scheduler)
 {
 	assert(scheduler);
 
+	pthread_mutex_lock(&scheduler->lock);
+
 	if (DESTROY != scheduler->signal)
 	{
 		scheduler->signal = STOP;
+		WakeLoop(scheduler);
 	}
+
+	pthread_mutex_unlock(&scheduler->lock);
 }
 
 size_t HeapSchedulerSize(const heap_scheduler_t* scheduler)
 {
+	size_t size = 0;
+	/* taking the lock doesn't change the scheduler's state */
+	heap_scheduler_t* locked = (heap_scheduler_t*)scheduler;
+
 	assert(scheduler);
 
-	return HeapPQSize(scheduler->heap_pq);
+	pthread_mutex_lock(&locked->lock);
+	size = scheduler->ops->size(scheduler->queue);
+	pthread_mutex_unlock(&locked->lock);
+
+	return size;
 }
 
 int HeapSchedulerIsEmpty(const heap_scheduler_t* scheduler)
 {
 	assert(scheduler);
 
-	return HeapPQIsEmpty(scheduler->heap_pq);
+	return (0 == HeapSchedulerSize(scheduler));
 }
 
 void HeapSchedulerClear(heap_scheduler_t* scheduler)
 {
 	assert(scheduler);
 
-	while (!HeapSchedulerIsEmpty(scheduler))
-	{
-		TaskDestroy(HeapPQDequeue(scheduler->heap_pq));
-	}
+	pthread_mutex_lock(&scheduler->lock);
+	ClearTasks(scheduler);
+	WakeLoop(scheduler);
+	pthread_mutex_unlock(&scheduler->lock);
 }
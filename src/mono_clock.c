@@ -0,0 +1,38 @@
+/******************************************************************************
+ * File name: mono_clock.c
+ * Owner: Ofir Nahshoni
+ ******************************************************************************/
+
+#define _POSIX_C_SOURCE (200809L)   /* clock_gettime, clock_nanosleep */
+
+#include <time.h>           /* clock_gettime, clock_nanosleep */
+
+#include "mono_clock.h"
+
+#define NSEC_PER_USEC (1000)
+
+mono_time_t MonoClockNow(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return ((mono_time_t)now.tv_sec * MONO_USEC_PER_SEC) +
+            ((mono_time_t)now.tv_nsec / NSEC_PER_USEC);
+}
+
+int MonoClockSleepUntil(mono_time_t deadline)
+{
+    struct timespec wake_time;
+
+    MonoClockToTimespec(deadline, &wake_time);
+
+    return (0 != clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME,
+                                    &wake_time, NULL));
+}
+
+void MonoClockToTimespec(mono_time_t time, struct timespec* ts)
+{
+    ts->tv_sec = (time_t)(time / MONO_USEC_PER_SEC);
+    ts->tv_nsec = (long)(time % MONO_USEC_PER_SEC) * NSEC_PER_USEC;
+}
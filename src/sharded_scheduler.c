@@ -0,0 +1,247 @@
+/******************************************************************************
+ * File name: sharded_scheduler.c
+ * Owner: Ofir Nahshoni
+ ******************************************************************************/
+
+#define _GNU_SOURCE             /* pthread_setaffinity_np, CPU_SET */
+
+#include <assert.h>             /* assert */
+#include <pthread.h>            /* pthread_create, pthread_join */
+#include <sched.h>              /* cpu_set_t */
+#include <stdlib.h>             /* malloc, free */
+#include <unistd.h>             /* sysconf */
+
+#include "sharded_scheduler.h"
+
+/*-----------------------------typdefs & Structures---------------------------*/
+typedef struct shard
+{
+    heap_scheduler_t* scheduler;
+    pthread_t thread;
+    size_t cpu;
+    status_t status;            /* what the shard's run returned */
+} shard_t;
+
+struct sharded_scheduler
+{
+    shard_t* shards;
+    size_t num_of_shards;
+    int is_started;
+};
+
+/*------------------------------static functions------------------------------*/
+static size_t ShardIndex(const sharded_scheduler_t* sharded, uid_t uid)
+{
+    /*
+    * the high half of the hash - each shard's uid map indexes its slots
+    * with the low bits, which would otherwise be alike for all its tasks
+    */
+    return (size_t)((UIDHash(uid) >> 32) % sharded->num_of_shards);
+}
+
+static void PinToCPU(size_t cpu)
+{
+    cpu_set_t cpus;
+
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu, &cpus);
+
+    /* best effort: a restricted cpuset only costs locality, not function */
+    pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+}
+
+static void* ShardRoutine(void* params)
+{
+    shard_t* shard = (shard_t*)params;
+
+    PinToCPU(shard->cpu);
+    shard->status = HeapSchedulerRun(shard->scheduler);
+
+    return NULL;
+}
+
+static int StopShards(sharded_scheduler_t* sharded, size_t num_of_started)
+{
+    size_t i = 0;
+    int result = 0;
+
+    /* a shard whose run hasn't started yet keeps the stop pending */
+    for (i = 0; i < num_of_started; ++i)
+    {
+        HeapSchedulerStop(sharded->shards[i].scheduler);
+    }
+
+    for (i = 0; i < num_of_started; ++i)
+    {
+        shard_t* shard = &sharded->shards[i];
+
+        pthread_join(shard->thread, NULL);
+        result |= (STOPPED != shard->status);
+    }
+
+    return result;
+}
+
+/*--------------------------------API functions-------------------------------*/
+sharded_scheduler_t* ShardedSchedulerCreate(size_t num_of_shards,
+                                            sched_backend_t backend)
+{
+    size_t i = 0;
+    sharded_scheduler_t* sharded = NULL;
+
+    assert(num_of_shards > 0);
+
+    sharded = (sharded_scheduler_t*)malloc(sizeof(sharded_scheduler_t));
+
+    if (NULL == sharded)
+    {
+        return NULL;
+    }
+
+    sharded->shards = (shard_t*)malloc(num_of_shards * sizeof(shard_t));
+
+    if (NULL == sharded->shards)
+    {
+        free(sharded);
+        return NULL;
+    }
+
+    for (i = 0; i < num_of_shards; ++i)
+    {
+        sharded->shards[i].scheduler = HeapSchedulerCreateEx(backend, 0);
+
+        if (NULL == sharded->shards[i].scheduler)
+        {
+            while (i-- > 0)
+            {
+                HeapSchedulerDestroy(sharded->shards[i].scheduler);
+            }
+
+            free(sharded->shards);
+            free(sharded);
+            return NULL;
+        }
+
+        HeapSchedulerSetKeepAlive(sharded->shards[i].scheduler, 1);
+        sharded->shards[i].status = SUCCESS;
+    }
+
+    sharded->num_of_shards = num_of_shards;
+    sharded->is_started = 0;
+
+    return sharded;
+}
+
+void ShardedSchedulerDestroy(sharded_scheduler_t* sharded)
+{
+    size_t i = 0;
+
+    if (NULL == sharded)
+    {
+        return;
+    }
+
+    ShardedSchedulerStop(sharded);
+
+    for (i = 0; i < sharded->num_of_shards; ++i)
+    {
+        HeapSchedulerDestroy(sharded->shards[i].scheduler);
+    }
+
+    free(sharded->shards);
+    free(sharded);
+}
+
+int ShardedSchedulerStart(sharded_scheduler_t* sharded)
+{
+    size_t i = 0;
+    long num_of_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+    assert(sharded);
+    assert(!sharded->is_started);
+
+    if (num_of_cpus < 1)
+    {
+        num_of_cpus = 1;
+    }
+
+    for (i = 0; i < sharded->num_of_shards; ++i)
+    {
+        shard_t* shard = &sharded->shards[i];
+
+        shard->cpu = i % (size_t)num_of_cpus;
+
+        if (0 != pthread_create(&shard->thread, NULL, ShardRoutine, shard))
+        {
+            StopShards(sharded, i);
+            return 1;
+        }
+    }
+
+    sharded->is_started = 1;
+
+    return 0;
+}
+
+int ShardedSchedulerStop(sharded_scheduler_t* sharded)
+{
+    assert(sharded);
+
+    if (!sharded->is_started)
+    {
+        return 0;
+    }
+
+    sharded->is_started = 0;
+
+    return StopShards(sharded, sharded->num_of_shards);
+}
+
+uid_t ShardedSchedulerAdd(sharded_scheduler_t* sharded,
+                            int (*action_func)(void* params), void* params,
+                            size_t interval_us)
+{
+    uid_t uid = UIDCreate();
+
+    assert(sharded);
+    assert(action_func);
+
+    if (UIDIsSame(bad_uid, uid))
+    {
+        return bad_uid;
+    }
+
+    return HeapSchedulerAddWithUID(ShardedSchedulerShardOf(sharded, uid), uid,
+                                    action_func, params, interval_us);
+}
+
+int ShardedSchedulerRemove(sharded_scheduler_t* sharded, uid_t identifier)
+{
+    assert(sharded);
+
+    return HeapSchedulerRemove(ShardedSchedulerShardOf(sharded, identifier),
+                                identifier);
+}
+
+size_t ShardedSchedulerSize(const sharded_scheduler_t* sharded)
+{
+    size_t i = 0;
+    size_t size = 0;
+
+    assert(sharded);
+
+    for (i = 0; i < sharded->num_of_shards; ++i)
+    {
+        size += HeapSchedulerSize(sharded->shards[i].scheduler);
+    }
+
+    return size;
+}
+
+heap_scheduler_t* ShardedSchedulerShardOf(const sharded_scheduler_t* sharded,
+                                          uid_t identifier)
+{
+    assert(sharded);
+
+    return sharded->shards[ShardIndex(sharded, identifier)].scheduler;
+}
@@ -0,0 +1,177 @@
+/******************************************************************************
+ * File name: shm_heartbeat.c
+ * Owner: Ofir Nahshoni
+ ******************************************************************************/
+
+#define _GNU_SOURCE             /* memfd_create */
+
+#include <assert.h>             /* assert */
+#include <fcntl.h>              /* O_CREAT */
+#include <stdatomic.h>          /* atomic_uint_least64_t */
+#include <stdio.h>              /* sprintf */
+#include <stdlib.h>             /* malloc, free */
+#include <unistd.h>             /* ftruncate, close, getpid */
+#include <sys/mman.h>           /* mmap, memfd_create, shm_open */
+#include <sys/stat.h>           /* fstat */
+
+#include "shm_heartbeat.h"
+
+/*-----------------------------------macros-----------------------------------*/
+#define MAGIC (UINT64_C(0x5441454254524548))   /* "HERTBEAT" */
+#define CACHE_LINE (64)
+#define NUM_OF_SIDES (2)
+#define SHM_NAME_SIZE (64)
+#define FILE_MODE (0600)
+
+/*-----------------------------typdefs & Structures---------------------------*/
+/* each counter on its own line, so a beat never invalidates the other */
+typedef struct slot
+{
+    atomic_uint_least64_t beats;
+    char pad[CACHE_LINE - sizeof(atomic_uint_least64_t)];
+} slot_t;
+
+typedef struct page
+{
+    uint64_t magic;
+    char pad[CACHE_LINE - sizeof(uint64_t)];
+    slot_t sides[NUM_OF_SIDES];
+} page_t;
+
+struct shm_heartbeat
+{
+    page_t* page;
+    atomic_uint_least64_t* own;
+    const atomic_uint_least64_t* peer;
+    uint64_t num_of_beats;      /* own counter, only this process writes it */
+};
+
+/*------------------------------static functions------------------------------*/
+/* memfd first, a shm object unlinked at once where there is no memfd */
+static int OpenMemoryFile(void)
+{
+    int fd = memfd_create("wd_heartbeat", 0);
+    char name[SHM_NAME_SIZE];
+
+    if (-1 != fd)
+    {
+        return fd;
+    }
+
+    sprintf(name, "/wd_heartbeat_%d", getpid());
+    fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, FILE_MODE);
+
+    if (-1 != fd)
+    {
+        shm_unlink(name);
+    }
+
+    return fd;
+}
+
+/*--------------------------------API functions-------------------------------*/
+int ShmHeartbeatCreateFd(void)
+{
+    size_t i = 0;
+    page_t* page = NULL;
+    int fd = OpenMemoryFile();
+
+    if (-1 == fd)
+    {
+        return -1;
+    }
+
+    if (0 != ftruncate(fd, sizeof(page_t)))
+    {
+        close(fd);
+        return -1;
+    }
+
+    page = (page_t*)mmap(NULL, sizeof(page_t), PROT_READ | PROT_WRITE,
+                            MAP_SHARED, fd, 0);
+
+    if (MAP_FAILED == page)
+    {
+        close(fd);
+        return -1;
+    }
+
+    for (i = 0; i < NUM_OF_SIDES; ++i)
+    {
+        atomic_init(&page->sides[i].beats, 0);
+    }
+
+    page->magic = MAGIC;
+    munmap(page, sizeof(page_t));
+
+    return fd;
+}
+
+shm_heartbeat_t* ShmHeartbeatCreate(int fd, shm_heartbeat_side_t side)
+{
+    struct stat file_stat;
+    shm_heartbeat_t* heartbeat = NULL;
+    page_t* page = NULL;
+
+    assert(side < NUM_OF_SIDES);
+
+    /* an inherited number may name anything, check before mapping */
+    if ((0 != fstat(fd, &file_stat)) ||
+        ((size_t)file_stat.st_size < sizeof(page_t)))
+    {
+        return NULL;
+    }
+
+    page = (page_t*)mmap(NULL, sizeof(page_t), PROT_READ | PROT_WRITE,
+                            MAP_SHARED, fd, 0);
+
+    if (MAP_FAILED == page)
+    {
+        return NULL;
+    }
+
+    heartbeat = (shm_heartbeat_t*)malloc(sizeof(shm_heartbeat_t));
+
+    if ((MAGIC != page->magic) || (NULL == heartbeat))
+    {
+        free(heartbeat);
+        munmap(page, sizeof(page_t));
+        return NULL;
+    }
+
+    heartbeat->page = page;
+    heartbeat->own = &page->sides[side].beats;
+    heartbeat->peer = &page->sides[NUM_OF_SIDES - 1 - side].beats;
+    /* a restarted process continues the count of the one it replaces */
+    heartbeat->num_of_beats = atomic_load(heartbeat->own);
+
+    return heartbeat;
+}
+
+void ShmHeartbeatDestroy(shm_heartbeat_t* heartbeat)
+{
+    if (NULL == heartbeat)
+    {
+        return;
+    }
+
+    munmap(heartbeat->page, sizeof(page_t));
+    free(heartbeat);
+}
+
+void ShmHeartbeatBeat(shm_heartbeat_t* heartbeat)
+{
+    assert(heartbeat);
+
+    /* only progress matters, no other data is published with it */
+    atomic_store_explicit(heartbeat->own, ++(heartbeat->num_of_beats),
+                            memory_order_relaxed);
+}
+
+uint64_t ShmHeartbeatPeer(const shm_heartbeat_t* heartbeat)
+{
+    assert(heartbeat);
+
+    return atomic_load_explicit((atomic_uint_least64_t*)heartbeat->peer,
+                                memory_order_relaxed);
+}
@@ -0,0 +1,183 @@
+/******************************************************************************
+ * File name: slab_pool.c
+ * Owner: Ofir Nahshoni
+ ******************************************************************************/
+
+#include <assert.h>         /* assert */
+#include <stdlib.h>         /* malloc, free */
+
+#include "slab_pool.h"
+
+/*-----------------------------------macros-----------------------------------*/
+#define MIN_SLAB_ELEMS (16)
+#define GROWTH_FACTOR (2)
+#define ROUND_UP(size, align) ((((size) + (align) - 1) / (align)) * (align))
+
+/*-----------------------------typdefs & Structures---------------------------*/
+/* strictest alignment any pooled object may need */
+typedef union align
+{
+    void* ptr;
+    long num;
+    double real;
+    long double long_real;
+} align_t;
+
+#define ELEM_ALIGN (sizeof(align_t))
+
+typedef struct slab
+{
+    struct slab* next;
+} slab_t;
+
+#define SLAB_HEADER_SIZE (ROUND_UP(sizeof(slab_t), ELEM_ALIGN))
+
+/* a free object holds the link to the next free object */
+typedef struct free_elem
+{
+    struct free_elem* next;
+} free_elem_t;
+
+struct slab_pool
+{
+    size_t elem_size;
+    size_t capacity;        /* objects in all slabs together */
+    size_t num_of_free;
+    slab_t* slabs;
+    free_elem_t* free_list;
+};
+
+/*------------------------------static functions------------------------------*/
+static int AddSlab(slab_pool_t* pool, size_t num_of_elems)
+{
+    size_t i = 0;
+    char* elems = NULL;
+    slab_t* slab = (slab_t*)malloc(SLAB_HEADER_SIZE +
+                                    num_of_elems * pool->elem_size);
+
+    if (NULL == slab)
+    {
+        return 1;
+    }
+
+    slab->next = pool->slabs;
+    pool->slabs = slab;
+
+    /* thread the new objects in address order in front of the free list */
+    elems = (char*)slab + SLAB_HEADER_SIZE;
+
+    for (i = num_of_elems; i > 0; --i)
+    {
+        free_elem_t* elem = (free_elem_t*)(elems + (i - 1) * pool->elem_size);
+
+        elem->next = pool->free_list;
+        pool->free_list = elem;
+    }
+
+    pool->capacity += num_of_elems;
+    pool->num_of_free += num_of_elems;
+
+    return 0;
+}
+
+/*--------------------------------API functions-------------------------------*/
+slab_pool_t* SlabPoolCreate(size_t elem_size, size_t capacity_hint)
+{
+    slab_pool_t* pool = NULL;
+
+    assert(0 != elem_size);
+
+    pool = (slab_pool_t*)malloc(sizeof(slab_pool_t));
+
+    if (NULL == pool)
+    {
+        return NULL;
+    }
+
+    if (elem_size < sizeof(free_elem_t))
+    {
+        elem_size = sizeof(free_elem_t);
+    }
+
+    pool->elem_size = ROUND_UP(elem_size, ELEM_ALIGN);
+    pool->capacity = 0;
+    pool->num_of_free = 0;
+    pool->slabs = NULL;
+    pool->free_list = NULL;
+
+    if ((0 != capacity_hint) && (0 != AddSlab(pool, capacity_hint)))
+    {
+        free(pool);
+        return NULL;
+    }
+
+    return pool;
+}
+
+void SlabPoolDestroy(slab_pool_t* pool)
+{
+    if (NULL == pool)
+    {
+        return;
+    }
+
+    while (NULL != pool->slabs)
+    {
+        slab_t* next = pool->slabs->next;
+
+        free(pool->slabs);
+        pool->slabs = next;
+    }
+
+    free(pool);
+}
+
+void* SlabPoolAlloc(slab_pool_t* pool)
+{
+    free_elem_t* elem = NULL;
+
+    assert(pool);
+
+    if (NULL == pool->free_list)
+    {
+        size_t num_of_elems = pool->capacity * (GROWTH_FACTOR - 1);
+
+        if (num_of_elems < MIN_SLAB_ELEMS)
+        {
+            num_of_elems = MIN_SLAB_ELEMS;
+        }
+
+        if (0 != AddSlab(pool, num_of_elems))
+        {
+            return NULL;
+        }
+    }
+
+    elem = pool->free_list;
+    pool->free_list = elem->next;
+    --(pool->num_of_free);
+
+    return elem;
+}
+
+void SlabPoolFree(slab_pool_t* pool, void* elem)
+{
+    assert(pool);
+    assert(elem);
+
+    ((free_elem_t*)elem)->next = pool->free_list;
+    pool->free_list = (free_elem_t*)elem;
+    ++(pool->num_of_free);
+}
+
+int SlabPoolReserve(slab_pool_t* pool, size_t count)
+{
+    assert(pool);
+
+    if (count <= pool->num_of_free)
+    {
+        return 0;
+    }
+
+    return AddSlab(pool, count - pool->num_of_free);
+}
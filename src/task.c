@@ -6,7 +6,6 @@
  ******************************************************************************/
 
 #include <assert.h>		/* assert */
-#include <time.h>		/* time */
 #include <stdlib.h>		/* malloc, free */
 
 #include "task.h"
@@ -16,12 +15,48 @@ struct task
     uid_t uid;
     int (*action_func)(void* params);
     void* params;
-    size_t interval_sec;
-    time_t time_to_run;
+    size_t interval_us;
+    mono_time_t time_to_run;
+    size_t queue_index;
+    int is_running;
+    int is_removed;             /* drop once the running action returns */
+    task_miss_policy_t miss_policy;
+    task_stats_t stats;
+    slab_pool_t* pool;          /* NULL if the task was malloc'ed */
 };
 
+/* @task->pool must already be set, so a failure can release @task */
+static task_t* InitTask(task_t* task, uid_t uid,
+                        int (*action_func)(void* params), void* params,
+                        size_t interval_us)
+{
+    task->uid = uid;
+
+    if (UIDIsSame(bad_uid, task->uid))
+    {
+        TaskDestroy(task);
+        return NULL;
+    }
+
+    task->action_func = action_func;
+    task->params = params;
+    task->interval_us = interval_us;
+    task->time_to_run = MonoClockNow() + (mono_time_t)interval_us;
+    task->queue_index = 0;
+    task->is_running = 0;
+    task->is_removed = 0;
+    task->miss_policy = TASK_MISS_CATCH_UP;
+    task->stats.num_of_runs = 0;
+    task->stats.last_lateness_us = 0;
+    task->stats.max_lateness_us = 0;
+    task->stats.total_lateness_us = 0;
+    task->stats.num_of_missed = 0;
+
+    return task;
+}
+
 task_t* TaskCreate(int (*action_func)(void* params), void* params,
-                    size_t interval_sec)
+                    size_t interval_us)
 {
     task_t* new_task = NULL;
     assert(action_func);
@@ -33,36 +68,157 @@ task_t* TaskCreate(int (*action_func)(void* params), void* params,
         return NULL;
     }
 
-    new_task->uid = UIDCreate();
+    new_task->pool = NULL;
+
+    return InitTask(new_task, UIDCreate(), action_func, params, interval_us);
+}
 
-    if (UIDIsSame(bad_uid, new_task->uid))
+task_t* TaskCreateFromPool(slab_pool_t* pool,
+                            int (*action_func)(void* params), void* params,
+                            size_t interval_us)
+{
+    return TaskCreateFromPoolWithUID(pool, UIDCreate(), action_func, params,
+                                        interval_us);
+}
+
+task_t* TaskCreateFromPoolWithUID(slab_pool_t* pool, uid_t uid,
+                                    int (*action_func)(void* params),
+                                    void* params, size_t interval_us)
+{
+    task_t* new_task = NULL;
+    assert(pool);
+    assert(action_func);
+
+    new_task = (task_t*)SlabPoolAlloc(pool);
+
+    if (NULL == new_task)
     {
-        free(new_task);
         return NULL;
     }
 
-    new_task->action_func = action_func;
-    new_task->params = params;
-    new_task->interval_sec = interval_sec;
-    new_task->time_to_run = time(NULL) + (time_t)interval_sec;
+    new_task->pool = pool;
+
+    return InitTask(new_task, uid, action_func, params, interval_us);
+}
 
-    return new_task;
+slab_pool_t* TaskPoolCreate(size_t capacity_hint)
+{
+    return SlabPoolCreate(sizeof(task_t), capacity_hint);
 }
 
 void TaskDestroy(task_t* task)
 {
+    if ((NULL != task) && (NULL != task->pool))
+    {
+        SlabPoolFree(task->pool, task);
+        return;
+    }
+
     free(task);
 }
 
 int TaskRun(task_t* task)
+{
+    TaskAdvance(task, MonoClockNow());
+
+    return TaskExecute(task);
+}
+
+void TaskAdvance(task_t* task, mono_time_t now)
+{
+    mono_time_t interval = 0;
+    mono_time_t num_of_missed = 0;
+
+    assert(task);
+
+    interval = (mono_time_t)(task->interval_us);
+    task->time_to_run += interval;
+
+    if ((task->time_to_run > now) || (0 == interval) ||
+        (TASK_MISS_CATCH_UP == task->miss_policy))
+    {
+        return;
+    }
+
+    /* every deadline from the new one up to @now was missed */
+    num_of_missed = (now - task->time_to_run) / interval + 1;
+    task->stats.num_of_missed += (size_t)num_of_missed;
+
+    if (TASK_MISS_SKIP == task->miss_policy)
+    {
+        task->time_to_run += num_of_missed * interval;
+    }
+    else
+    {
+        task->time_to_run = now + interval;
+    }
+}
+
+void TaskSetMissPolicy(task_t* task, task_miss_policy_t policy)
 {
     assert(task);
 
-    task->time_to_run += (time_t)(task->interval_sec);
+    task->miss_policy = policy;
+}
+
+int TaskExecute(const task_t* task)
+{
+    assert(task);
 
     return task->action_func(task->params);
 }
 
+void TaskRecordLateness(task_t* task, mono_time_t lateness_us)
+{
+    assert(task);
+
+    ++(task->stats.num_of_runs);
+    task->stats.last_lateness_us = lateness_us;
+    task->stats.total_lateness_us += lateness_us;
+
+    if (lateness_us > task->stats.max_lateness_us)
+    {
+        task->stats.max_lateness_us = lateness_us;
+    }
+}
+
+void TaskGetStats(const task_t* task, task_stats_t* stats)
+{
+    assert(task);
+    assert(stats);
+
+    *stats = task->stats;
+}
+
+void TaskSetRunning(task_t* task, int is_running)
+{
+    assert(task);
+
+    task->is_running = is_running;
+}
+
+int TaskIsRunning(const task_t* task)
+{
+    assert(task);
+
+    return task->is_running;
+}
+
+void TaskSetRemoved(task_t* task)
+{
+    assert(task);
+    assert(task->is_running);
+
+    task->is_removed = 1;
+}
+
+int TaskIsRemoved(const task_t* task)
+{
+    assert(task);
+
+    return task->is_removed;
+}
+
 uid_t TaskGetUID(const task_t* task)
 {
     assert(task);
@@ -70,11 +226,18 @@ uid_t TaskGetUID(const task_t* task)
     return task->uid;
 }
 
-size_t TaskGetScheduledTime(const task_t* task)
+mono_time_t TaskGetScheduledTime(const task_t* task)
+{
+    assert(task);
+
+    return task->time_to_run;
+}
+
+void TaskSetScheduledTime(task_t* task, mono_time_t time_to_run)
 {
     assert(task);
 
-    return (size_t)(task->time_to_run);
+    task->time_to_run = time_to_run;
 }
 
 int TaskIsEqual(const task_t* task1, const task_t* task2)
@@ -84,3 +247,17 @@ int TaskIsEqual(const task_t* task1, const task_t* task2)
 
     return UIDIsSame(task1->uid, task2->uid);
 }
+
+void TaskSetQueueIndex(task_t* task, size_t index)
+{
+    assert(task);
+
+    task->queue_index = index;
+}
+
+size_t TaskGetQueueIndex(const task_t* task)
+{
+    assert(task);
+
+    return task->queue_index;
+}
@@ -0,0 +1,479 @@
+/******************************************************************************
+ * File name: timing_wheel.c
+ * Owner: Ofir Nahshoni
+ ******************************************************************************/
+
+#include <assert.h>         /* assert */
+#include <stdlib.h>         /* malloc, realloc, free */
+#include <stdint.h>         /* uint64_t, SIZE_MAX */
+
+#include "timing_wheel.h"
+
+/*-----------------------------------macros-----------------------------------*/
+#define LEVELS (5)
+#define SLOT_BITS (6)
+#define SLOTS (1 << SLOT_BITS)
+#define SLOT_MASK (SLOTS - 1)
+#define WHEEL_BITS (LEVELS * SLOT_BITS)
+
+/* lists: one per slot, then the expired list and the overflow list */
+#define EXPIRED_LIST (LEVELS * SLOTS)
+#define OVERFLOW_LIST (EXPIRED_LIST + 1)
+#define NUM_OF_LISTS (OVERFLOW_LIST + 1)
+
+#define NIL (SIZE_MAX)
+#define NO_EVENT (UINT64_MAX)
+#define MIN_NODES (16)
+#define GROWTH_FACTOR (2)
+
+#define LEVEL_SHIFT(level) ((level) * SLOT_BITS)
+#define DIGIT(tick, level) ((size_t)((tick) >> LEVEL_SHIFT(level)) & SLOT_MASK)
+#define LIST_ID(level, slot) ((level) * SLOTS + (slot))
+
+/*-----------------------------typdefs & Structures---------------------------*/
+typedef struct node
+{
+    task_t* task;
+    uint64_t tick;
+    size_t prev;
+    size_t next;            /* next free node while on the free list */
+    size_t list;
+} node_t;
+
+struct timing_wheel
+{
+    mono_time_t tick_us;
+    uint64_t current;       /* every tick <= current was already processed */
+    size_t size;
+    node_t* nodes;
+    size_t num_of_nodes;
+    size_t free_head;
+    size_t heads[NUM_OF_LISTS];
+    size_t expired_tail;    /* expired nodes are appended, popped in order */
+    uint64_t occupied[LEVELS];  /* bit per non-empty slot */
+};
+
+/*------------------------------static functions------------------------------*/
+static size_t LowestBit(uint64_t bits)
+{
+#ifdef __GNUC__
+    return (size_t)__builtin_ctzll(bits);
+#else
+    size_t bit = 0;
+
+    while (0 == (bits & 1))
+    {
+        bits >>= 1;
+        ++bit;
+    }
+
+    return bit;
+#endif
+}
+
+static void PushToList(timing_wheel_t* wheel, size_t node_idx, size_t list)
+{
+    node_t* node = &wheel->nodes[node_idx];
+
+    node->list = list;
+    node->prev = NIL;
+    node->next = wheel->heads[list];
+
+    if (NIL != node->next)
+    {
+        wheel->nodes[node->next].prev = node_idx;
+    }
+
+    wheel->heads[list] = node_idx;
+
+    if (list < EXPIRED_LIST)
+    {
+        wheel->occupied[list / SLOTS] |= (uint64_t)1 << (list % SLOTS);
+    }
+}
+
+/* ticks expire in increasing order, the list keeps them in that order */
+static void AppendToExpired(timing_wheel_t* wheel, size_t node_idx)
+{
+    node_t* node = &wheel->nodes[node_idx];
+
+    node->list = EXPIRED_LIST;
+    node->prev = wheel->expired_tail;
+    node->next = NIL;
+
+    if (NIL != node->prev)
+    {
+        wheel->nodes[node->prev].next = node_idx;
+    }
+    else
+    {
+        wheel->heads[EXPIRED_LIST] = node_idx;
+    }
+
+    wheel->expired_tail = node_idx;
+}
+
+static void Unlink(timing_wheel_t* wheel, size_t node_idx)
+{
+    node_t* node = &wheel->nodes[node_idx];
+
+    if (NIL != node->prev)
+    {
+        wheel->nodes[node->prev].next = node->next;
+    }
+    else
+    {
+        wheel->heads[node->list] = node->next;
+    }
+
+    if (NIL != node->next)
+    {
+        wheel->nodes[node->next].prev = node->prev;
+    }
+    else if (EXPIRED_LIST == node->list)
+    {
+        wheel->expired_tail = node->prev;
+    }
+
+    if ((node->list < EXPIRED_LIST) && (NIL == wheel->heads[node->list]))
+    {
+        wheel->occupied[node->list / SLOTS] &=
+                                    ~((uint64_t)1 << (node->list % SLOTS));
+    }
+}
+
+/* the level is the most significant digit in which tick and current differ */
+static void Place(timing_wheel_t* wheel, size_t node_idx)
+{
+    uint64_t tick = wheel->nodes[node_idx].tick;
+    size_t level = 0;
+
+    if (tick <= wheel->current)
+    {
+        AppendToExpired(wheel, node_idx);
+        return;
+    }
+
+    while ((level < LEVELS) &&
+            ((tick >> LEVEL_SHIFT(level + 1)) !=
+            (wheel->current >> LEVEL_SHIFT(level + 1))))
+    {
+        ++level;
+    }
+
+    if (LEVELS == level)
+    {
+        PushToList(wheel, node_idx, OVERFLOW_LIST);
+        return;
+    }
+
+    PushToList(wheel, node_idx, LIST_ID(level, DIGIT(tick, level)));
+}
+
+/* re-places every node of @list relative to the current tick */
+static void Cascade(timing_wheel_t* wheel, size_t list)
+{
+    size_t runner = wheel->heads[list];
+
+    wheel->heads[list] = NIL;
+
+    if (list < EXPIRED_LIST)
+    {
+        wheel->occupied[list / SLOTS] &= ~((uint64_t)1 << (list % SLOTS));
+    }
+
+    while (NIL != runner)
+    {
+        size_t next = wheel->nodes[runner].next;
+
+        Place(wheel, runner);
+        runner = next;
+    }
+}
+
+/* first tick after current at which a non-empty slot must be processed */
+static uint64_t NextEventTick(const timing_wheel_t* wheel)
+{
+    size_t level = 0;
+    uint64_t next_tick = NO_EVENT;
+
+    for (level = 0; level < LEVELS; ++level)
+    {
+        size_t digit = DIGIT(wheel->current, level);
+        uint64_t ahead = wheel->occupied[level] &
+                            ~(((uint64_t)2 << digit) - 1);
+
+        if (0 != ahead)
+        {
+            uint64_t block = wheel->current >> LEVEL_SHIFT(level + 1);
+            uint64_t start = (block << LEVEL_SHIFT(level + 1)) |
+                        ((uint64_t)LowestBit(ahead) << LEVEL_SHIFT(level));
+
+            if (start < next_tick)
+            {
+                next_tick = start;
+            }
+        }
+    }
+
+    if (NIL != wheel->heads[OVERFLOW_LIST])
+    {
+        uint64_t boundary = ((wheel->current >> WHEEL_BITS) + 1) << WHEEL_BITS;
+
+        if (boundary < next_tick)
+        {
+            next_tick = boundary;
+        }
+    }
+
+    return next_tick;
+}
+
+/* handles every slot that starts exactly at the current tick */
+static void ProcessCurrentTick(timing_wheel_t* wheel)
+{
+    size_t level = LEVELS;
+    uint64_t current = wheel->current;
+
+    if (0 == (current & (((uint64_t)1 << WHEEL_BITS) - 1)))
+    {
+        Cascade(wheel, OVERFLOW_LIST);
+    }
+
+    /* higher levels first, their nodes may land in lower levels */
+    while (level-- > 1)
+    {
+        if (0 == (current & (((uint64_t)1 << LEVEL_SHIFT(level)) - 1)))
+        {
+            Cascade(wheel, LIST_ID(level, DIGIT(current, level)));
+        }
+    }
+
+    Cascade(wheel, LIST_ID(0, DIGIT(current, 0)));
+}
+
+static void Advance(timing_wheel_t* wheel, uint64_t target)
+{
+    while (wheel->current < target)
+    {
+        uint64_t next_tick = NextEventTick(wheel);
+
+        if (next_tick > target)
+        {
+            wheel->current = target;
+            break;
+        }
+
+        wheel->current = next_tick;
+        ProcessCurrentTick(wheel);
+    }
+}
+
+static int GrowNodes(timing_wheel_t* wheel)
+{
+    size_t i = 0;
+    size_t new_count = wheel->num_of_nodes * GROWTH_FACTOR;
+    node_t* new_nodes = (node_t*)realloc(wheel->nodes,
+                                            new_count * sizeof(node_t));
+
+    if (NULL == new_nodes)
+    {
+        return 1;
+    }
+
+    for (i = wheel->num_of_nodes; i < new_count; ++i)
+    {
+        new_nodes[i].next = (i + 1 < new_count) ? i + 1 : NIL;
+    }
+
+    wheel->free_head = wheel->num_of_nodes;
+    wheel->nodes = new_nodes;
+    wheel->num_of_nodes = new_count;
+
+    return 0;
+}
+
+static uint64_t DeadlineToTick(const timing_wheel_t* wheel,
+                                mono_time_t deadline)
+{
+    /* round up: a task must not expire before its deadline */
+    return (deadline + wheel->tick_us - 1) / wheel->tick_us;
+}
+
+static task_t* DetachNode(timing_wheel_t* wheel, size_t node_idx)
+{
+    task_t* task = wheel->nodes[node_idx].task;
+
+    Unlink(wheel, node_idx);
+
+    wheel->nodes[node_idx].next = wheel->free_head;
+    wheel->free_head = node_idx;
+    --(wheel->size);
+
+    return task;
+}
+
+/*--------------------------------API functions-------------------------------*/
+timing_wheel_t* TimingWheelCreate(mono_time_t tick_us, mono_time_t now)
+{
+    size_t i = 0;
+    timing_wheel_t* wheel = NULL;
+
+    assert(tick_us > 0);
+
+    wheel = (timing_wheel_t*)malloc(sizeof(timing_wheel_t));
+
+    if (NULL == wheel)
+    {
+        return NULL;
+    }
+
+    wheel->nodes = (node_t*)malloc(MIN_NODES * sizeof(node_t));
+
+    if (NULL == wheel->nodes)
+    {
+        free(wheel);
+        return NULL;
+    }
+
+    for (i = 0; i < MIN_NODES; ++i)
+    {
+        wheel->nodes[i].next = (i + 1 < MIN_NODES) ? i + 1 : NIL;
+    }
+
+    for (i = 0; i < NUM_OF_LISTS; ++i)
+    {
+        wheel->heads[i] = NIL;
+    }
+
+    for (i = 0; i < LEVELS; ++i)
+    {
+        wheel->occupied[i] = 0;
+    }
+
+    wheel->expired_tail = NIL;
+
+    wheel->tick_us = tick_us;
+    wheel->current = now / tick_us;
+    wheel->size = 0;
+    wheel->num_of_nodes = MIN_NODES;
+    wheel->free_head = 0;
+
+    return wheel;
+}
+
+void TimingWheelDestroy(timing_wheel_t* wheel)
+{
+    if (NULL != wheel)
+    {
+        free(wheel->nodes);
+        free(wheel);
+    }
+}
+
+int TimingWheelAdd(timing_wheel_t* wheel, task_t* task)
+{
+    size_t node_idx = 0;
+
+    assert(wheel);
+    assert(task);
+
+    if ((NIL == wheel->free_head) && (0 != GrowNodes(wheel)))
+    {
+        return 1;
+    }
+
+    node_idx = wheel->free_head;
+    wheel->free_head = wheel->nodes[node_idx].next;
+
+    wheel->nodes[node_idx].task = task;
+    wheel->nodes[node_idx].tick = DeadlineToTick(wheel,
+                                                TaskGetScheduledTime(task));
+    TaskSetQueueIndex(task, node_idx);
+    Place(wheel, node_idx);
+    ++(wheel->size);
+
+    return 0;
+}
+
+void TimingWheelRemove(timing_wheel_t* wheel, task_t* task)
+{
+    size_t node_idx = 0;
+
+    assert(wheel);
+    assert(task);
+
+    node_idx = TaskGetQueueIndex(task);
+    assert(task == wheel->nodes[node_idx].task);
+
+    DetachNode(wheel, node_idx);
+}
+
+void TimingWheelUpdate(timing_wheel_t* wheel, task_t* task)
+{
+    size_t node_idx = 0;
+
+    assert(wheel);
+    assert(task);
+
+    node_idx = TaskGetQueueIndex(task);
+    assert(task == wheel->nodes[node_idx].task);
+
+    Unlink(wheel, node_idx);
+    wheel->nodes[node_idx].tick = DeadlineToTick(wheel,
+                                                TaskGetScheduledTime(task));
+    Place(wheel, node_idx);
+}
+
+task_t* TimingWheelPopExpired(timing_wheel_t* wheel, mono_time_t now)
+{
+    assert(wheel);
+
+    Advance(wheel, now / wheel->tick_us);
+
+    if (NIL == wheel->heads[EXPIRED_LIST])
+    {
+        return NULL;
+    }
+
+    return DetachNode(wheel, wheel->heads[EXPIRED_LIST]);
+}
+
+task_t* TimingWheelPopAny(timing_wheel_t* wheel)
+{
+    size_t i = 0;
+
+    assert(wheel);
+    assert(0 != wheel->size);
+
+    /* a used node is never on the free list, find one through the lists */
+    for (i = 0; NIL == wheel->heads[i]; ++i)
+    {
+    }
+
+    return DetachNode(wheel, wheel->heads[i]);
+}
+
+mono_time_t TimingWheelNextExpiry(const timing_wheel_t* wheel)
+{
+    uint64_t next_tick = 0;
+
+    assert(wheel);
+    assert(0 != wheel->size);
+
+    if (NIL != wheel->heads[EXPIRED_LIST])
+    {
+        return wheel->current * wheel->tick_us;
+    }
+
+    next_tick = NextEventTick(wheel);
+
+    return next_tick * wheel->tick_us;
+}
+
+size_t TimingWheelSize(const timing_wheel_t* wheel)
+{
+    assert(wheel);
+
+    return wheel->size;
+}
@@ -6,43 +6,239 @@
  ******************************************************************************/
 
 #include <unistd.h>		/* getpid */
-#include <stdio.h>      /* fprintf */
-#include <pthread.h>    /* mutex_t */
+#include <time.h>       /* time */
+#include <pthread.h>    /* pthread_once, pthread_atfork */
 #include <stdatomic.h>  /* fetch_and_add */
-#include <string.h>		/* memcpy, memcmp */
 #include <ifaddrs.h>	/* getifaddrs, freeifaddrs */
 
 #include "uid.h"
 
+#define FNV_OFFSET_BASIS (2166136261u)
+#define FNV_PRIME (16777619u)
+#define LOW_32_BITS (0xFFFFFFFFu)
+#define ADDR_SIZE (14)
+#define HEX_DIGITS_PER_WORD (16)
+
 const uid_t bad_uid = { 0 };
 
-uid_t UIDCreate(void)
+/* node identity, resolved once per process instead of once per UID */
+typedef struct node_identity
+{
+    uint32_t node;
+    uint64_t hi;
+    int is_valid;
+} node_identity_t;
+
+static node_identity_t g_node = { 0 };
+static pthread_once_t g_node_once = PTHREAD_ONCE_INIT;
+static atomic_uint g_counter = 0;
+
+
+/*------------------------------static functions------------------------------*/
+static uint32_t FoldAddress(const unsigned char* addr)
+{
+    size_t i = 0;
+    uint32_t hash = FNV_OFFSET_BASIS;
+
+    for (i = 0; i < ADDR_SIZE; ++i)
+    {
+        hash = (hash ^ addr[i]) * FNV_PRIME;
+    }
+
+    return hash;
+}
+
+static void LoadNodeAddress(void)
 {
-    uid_t uid;
-    static atomic_int count = 0;
     struct ifaddrs* addr_struct = NULL;
+    struct ifaddrs* runner = NULL;
 
-    uid.time = time(NULL);
-    uid.pid = getpid();
+    g_node.is_valid = 0;
 
     if (0 != getifaddrs(&addr_struct))
     {
-        return bad_uid;
+        return;
     }
 
-    memcpy(uid.ip, addr_struct->ifa_addr->sa_data, sizeof(uid.ip));
-
-    uid.counter = atomic_fetch_add(&count, 1);
+    for (runner = addr_struct; NULL != runner; runner = runner->ifa_next)
+    {
+        if (NULL != runner->ifa_addr)
+        {
+            g_node.node = FoldAddress(
+                            (const unsigned char*)runner->ifa_addr->sa_data);
+            g_node.is_valid = 1;
+            break;
+        }
+    }
 
     freeifaddrs(addr_struct);
+}
+
+/* the child has a single thread here, no synchronization needed */
+static void RefreshAfterFork(void)
+{
+    g_node.hi = ((uint64_t)g_node.node << 32) | (uint32_t)getpid();
+}
+
+static void InitNodeIdentity(void)
+{
+    LoadNodeAddress();
+    RefreshAfterFork();
+
+    pthread_atfork(NULL, NULL, RefreshAfterFork);
+}
+
+/* finalizer of splitmix64 */
+static uint64_t Mix64(uint64_t x)
+{
+    x ^= x >> 30;
+    x *= UINT64_C(0xBF58476D1CE4E5B9);
+    x ^= x >> 27;
+    x *= UINT64_C(0x94D049BB133111EB);
+    x ^= x >> 31;
+
+    return x;
+}
+
+static void WordToHex(uint64_t word, char* dest)
+{
+    static const char digits[] = "0123456789abcdef";
+    int i = 0;
+
+    for (i = HEX_DIGITS_PER_WORD - 1; i >= 0; --i)
+    {
+        dest[i] = digits[word & 0xF];
+        word >>= 4;
+    }
+}
+
+static int HexToWord(const char* str, uint64_t* word)
+{
+    int i = 0;
+    uint64_t result = 0;
+
+    for (i = 0; i < HEX_DIGITS_PER_WORD; ++i)
+    {
+        char c = str[i];
+        unsigned int digit = 0;
+
+        if ((c >= '0') && (c <= '9'))
+        {
+            digit = (unsigned int)(c - '0');
+        }
+        else if ((c >= 'a') && (c <= 'f'))
+        {
+            digit = (unsigned int)(c - 'a' + 10);
+        }
+        else if ((c >= 'A') && (c <= 'F'))
+        {
+            digit = (unsigned int)(c - 'A' + 10);
+        }
+        else
+        {
+            return 1;
+        }
+
+        result = (result << 4) | digit;
+    }
+
+    *word = result;
+
+    return 0;
+}
+
+static void WordToBytes(uint64_t word, unsigned char* dest)
+{
+    int i = 0;
+
+    for (i = 7; i >= 0; --i)
+    {
+        dest[i] = (unsigned char)(word & 0xFF);
+        word >>= 8;
+    }
+}
+
+static uint64_t BytesToWord(const unsigned char* src)
+{
+    int i = 0;
+    uint64_t word = 0;
+
+    for (i = 0; i < 8; ++i)
+    {
+        word = (word << 8) | src[i];
+    }
+
+    return word;
+}
+
+
+/*--------------------------------API functions-------------------------------*/
+uid_t UIDCreate(void)
+{
+    uid_t uid;
+    uint32_t counter = 0;
+
+    pthread_once(&g_node_once, InitNodeIdentity);
+
+    if (!g_node.is_valid)
+    {
+        return bad_uid;
+    }
+
+    counter = atomic_fetch_add_explicit(&g_counter, 1, memory_order_relaxed);
+
+    uid.hi = g_node.hi;
+    uid.lo = ((uint64_t)((uint32_t)time(NULL)) << 32) |
+                (counter & LOW_32_BITS);
 
     return uid;
 }
 
 int UIDIsSame(uid_t uid1, uid_t uid2)
 {
-    return ((uid1.time == uid2.time) &&
-           (uid1.counter == uid2.counter) &&
-           (uid1.pid == uid2.pid) &&
-           (0 == memcmp(uid1.ip, uid2.ip, sizeof(uid1.ip))));
+    return (0 == ((uid1.hi ^ uid2.hi) | (uid1.lo ^ uid2.lo)));
+}
+
+uint64_t UIDHash(uid_t uid)
+{
+    return Mix64(uid.hi ^ Mix64(uid.lo));
+}
+
+void UIDToString(uid_t uid, char* dest)
+{
+    WordToHex(uid.hi, dest);
+    WordToHex(uid.lo, dest + HEX_DIGITS_PER_WORD);
+    dest[UID_STR_SIZE - 1] = '\0';
+}
+
+int UIDFromString(const char* str, uid_t* uid)
+{
+    uid_t result;
+
+    if ((0 != HexToWord(str, &result.hi)) ||
+        (0 != HexToWord(str + HEX_DIGITS_PER_WORD, &result.lo)) ||
+        ('\0' != str[UID_STR_SIZE - 1]))
+    {
+        return 1;
+    }
+
+    *uid = result;
+
+    return 0;
+}
+
+void UIDToBytes(uid_t uid, unsigned char* dest)
+{
+    WordToBytes(uid.hi, dest);
+    WordToBytes(uid.lo, dest + (UID_BIN_SIZE / 2));
+}
+
+uid_t UIDFromBytes(const unsigned char* src)
+{
+    uid_t uid;
+
+    uid.hi = BytesToWord(src);
+    uid.lo = BytesToWord(src + (UID_BIN_SIZE / 2));
+
+    return uid;
 }
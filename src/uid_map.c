@@ -0,0 +1,228 @@
+/******************************************************************************
+ * File name: uid_map.c
+ * Owner: Ofir Nahshoni
+ ******************************************************************************/
+
+#include <assert.h>         /* assert */
+#include <stdlib.h>         /* malloc, calloc, free */
+#include <string.h>         /* memset */
+
+#include "uid_map.h"
+
+/*-----------------------------------macros-----------------------------------*/
+#define MIN_CAPACITY (16)
+#define GROWTH_FACTOR (2)
+/* keep the load factor at or below 3/4 */
+#define IS_OVERLOADED(size, capacity) (4 * (size) > 3 * (capacity))
+
+/*-----------------------------typdefs & Structures---------------------------*/
+typedef struct slot
+{
+    uid_t key;
+    void* value;        /* NULL marks an empty slot */
+} slot_t;
+
+struct uid_map
+{
+    size_t size;
+    size_t mask;        /* capacity - 1, capacity is a power of two */
+    slot_t* slots;
+};
+
+/*------------------------------static functions------------------------------*/
+static size_t HomeSlot(const uid_map_t* map, uid_t key)
+{
+    return (size_t)UIDHash(key) & map->mask;
+}
+
+static size_t FindSlot(const uid_map_t* map, uid_t key)
+{
+    size_t idx = HomeSlot(map, key);
+
+    while ((NULL != map->slots[idx].value) &&
+            !UIDIsSame(map->slots[idx].key, key))
+    {
+        idx = (idx + 1) & map->mask;
+    }
+
+    return idx;
+}
+
+static int Rehash(uid_map_t* map, size_t new_capacity)
+{
+    size_t i = 0;
+    size_t old_capacity = map->mask + 1;
+    slot_t* old_slots = map->slots;
+
+    map->slots = (slot_t*)calloc(new_capacity, sizeof(slot_t));
+
+    if (NULL == map->slots)
+    {
+        map->slots = old_slots;
+        return 1;
+    }
+
+    map->mask = new_capacity - 1;
+
+    for (i = 0; i < old_capacity; ++i)
+    {
+        if (NULL != old_slots[i].value)
+        {
+            map->slots[FindSlot(map, old_slots[i].key)] = old_slots[i];
+        }
+    }
+
+    free(old_slots);
+
+    return 0;
+}
+
+/*--------------------------------API functions-------------------------------*/
+uid_map_t* UIDMapCreate(size_t capacity_hint)
+{
+    size_t capacity = MIN_CAPACITY;
+    uid_map_t* map = NULL;
+
+    while (IS_OVERLOADED(capacity_hint, capacity))
+    {
+        capacity *= GROWTH_FACTOR;
+    }
+
+    map = (uid_map_t*)malloc(sizeof(uid_map_t));
+
+    if (NULL == map)
+    {
+        return NULL;
+    }
+
+    map->slots = (slot_t*)calloc(capacity, sizeof(slot_t));
+
+    if (NULL == map->slots)
+    {
+        free(map);
+        return NULL;
+    }
+
+    map->size = 0;
+    map->mask = capacity - 1;
+
+    return map;
+}
+
+int UIDMapReserve(uid_map_t* map, size_t count)
+{
+    size_t capacity = 0;
+
+    assert(map);
+
+    capacity = map->mask + 1;
+
+    while (IS_OVERLOADED(map->size + count, capacity))
+    {
+        capacity *= GROWTH_FACTOR;
+    }
+
+    if (capacity == map->mask + 1)
+    {
+        return 0;
+    }
+
+    return Rehash(map, capacity);
+}
+
+void UIDMapDestroy(uid_map_t* map)
+{
+    if (NULL != map)
+    {
+        free(map->slots);
+        free(map);
+    }
+}
+
+int UIDMapInsert(uid_map_t* map, uid_t key, void* value)
+{
+    size_t idx = 0;
+
+    assert(map);
+    assert(value);
+
+    if (IS_OVERLOADED(map->size + 1, map->mask + 1))
+    {
+        if (0 != Rehash(map, (map->mask + 1) * GROWTH_FACTOR))
+        {
+            return 1;
+        }
+    }
+
+    idx = FindSlot(map, key);
+
+    if (NULL == map->slots[idx].value)
+    {
+        ++(map->size);
+    }
+
+    map->slots[idx].key = key;
+    map->slots[idx].value = value;
+
+    return 0;
+}
+
+void* UIDMapFind(const uid_map_t* map, uid_t key)
+{
+    assert(map);
+
+    return map->slots[FindSlot(map, key)].value;
+}
+
+void* UIDMapRemove(uid_map_t* map, uid_t key)
+{
+    size_t hole = 0;
+    size_t runner = 0;
+    void* removed = NULL;
+
+    assert(map);
+
+    hole = FindSlot(map, key);
+    removed = map->slots[hole].value;
+
+    if (NULL == removed)
+    {
+        return NULL;
+    }
+
+    /* backward-shift deletion: pull up entries whose probe passed the hole */
+    runner = (hole + 1) & map->mask;
+
+    while (NULL != map->slots[runner].value)
+    {
+        size_t home = HomeSlot(map, map->slots[runner].key);
+
+        if (((runner - home) & map->mask) >= ((runner - hole) & map->mask))
+        {
+            map->slots[hole] = map->slots[runner];
+            hole = runner;
+        }
+
+        runner = (runner + 1) & map->mask;
+    }
+
+    map->slots[hole].value = NULL;
+    --(map->size);
+
+    return removed;
+}
+
+size_t UIDMapSize(const uid_map_t* map)
+{
+    assert(map);
+
+    return map->size;
+}
+
+void UIDMapClear(uid_map_t* map)
+{
+    assert(map);
+
+    memset(map->slots, 0, (map->mask + 1) * sizeof(slot_t));
+    map->size = 0;
+}
@@ -10,26 +10,52 @@
 *******************************************************************************/
 
 
-#define _POSIX_C_SOURCE (200809L)   /* remove setenv warning */
+#define _GNU_SOURCE                 /* setenv, syscall */
 
 #include <unistd.h>
 #include <sys/stat.h>
 #include <sys/wait.h>               /* waitpid */
 #include <assert.h>                 /* assert */
-#include <string.h>                 /* strcmp */
+#include <string.h>                 /* strcmp, strlen */
 #include <fcntl.h>                  /* O_CREAT */
 #include <stdio.h>                  /* fprintf */
-#include <signal.h>                 /* sigaction */
+#include <signal.h>                 /* sigaction, sigqueue, pthread_sigmask */
 #include <stdatomic.h>              /* atomic_uint */
-#include <stdlib.h>                 /* setenv */
+#include <stdlib.h>                 /* setenv, strtoul, atexit */
+#include <pthread.h>                /* pthread_once */
+#include <sys/epoll.h>              /* EPOLLIN */
+#include <sys/signalfd.h>           /* signalfd */
+#include <sys/syscall.h>            /* SYS_pidfd_open */
+#include <spawn.h>                  /* posix_spawnp */
+#include <dirent.h>                 /* opendir, without spawn closefrom */
 
 #include "watch_dog.h"
+#include "wd.h"                     /* WD_FLAG_SIGNALFD */
+#include "async_log.h"              /* async_log_t */
+#include "flight_recorder.h"        /* flight_recorder_t */
+#include "shm_heartbeat.h"          /* shm_heartbeat_t */
+#include "mono_clock.h"             /* MONO_USEC_PER_MSEC */
 
 
 /*-----------------------------------macros-----------------------------------*/
 #define LOGFILE_PATH ("./log.txt")
+#define LOG_ENV_VAR_NAME ("WD_LOG_PATH")
+#define LOG_MAX_FILE_SIZE (4 * 1024 * 1024)
+#define LOG_PID_SUFFIX_SIZE (16)    /* ".<pid>" and the terminator */
+#define RECORDER_PATH ("./wd_flight.bin")
+#define RECORDER_ENV_VAR_NAME ("WD_FLIGHT_PATH")
+#define RECORDER_CAPACITY (4096)    /* 64 KiB of 16 byte records */
 #define WD_ENV_VAR_NAME ("WD_PID")
 #define EXEC_WD_PATH ("./wd_exec.out")
+#define SPAWN_SHM_FD (3)            /* the heartbeat descriptor in the child */
+#define FD_DIR_PATH ("/proc/self/fd")
+
+/* glibc 2.34 added closing every other inherited descriptor at spawn */
+#ifdef __GLIBC__
+#if (__GLIBC__ > 2) || ((__GLIBC__ == 2) && (__GLIBC_MINOR__ >= 34))
+#define HAS_SPAWN_CLOSEFROM
+#endif
+#endif
 
 
 /*---------------------------static global variables--------------------------*/
@@ -38,6 +64,18 @@ static atomic_uint signal_counter = 0;
 static params_obj_t g_params = { 0 };
 static char buffer_interval[STR_SIZE];
 static char buffer_threshold[STR_SIZE];
+static unsigned int g_flags = 0;
+static int g_signal_fd = -1;
+static unsigned int g_beats_sent = 0;
+static unsigned int g_last_beat = 0;   /* payload of the last beat received */
+static pthread_once_t g_log_once = PTHREAD_ONCE_INIT;
+static async_log_t* g_log = NULL;
+static pid_t g_log_pid = 0;         /* the process whose writer thread runs */
+static flight_recorder_t* g_recorder = NULL;
+static shm_heartbeat_t* g_heartbeat = NULL;
+static uint64_t g_last_peer_beats = 0;
+static int g_peer_fd = -1;          /* pidfd of pid_other */
+static unsigned int g_num_of_restarts = 0;
 
 
 /*------------------------------static functions------------------------------*/
@@ -48,50 +86,57 @@ static int TaskToExecute(void* args);
 static void PulseSignal(int signum);
 static void StopSignal(int signum);
 static int InitSignalsDispositions(struct sigaction* act);
+static void InitSignalSet(sigset_t* set);
+static int InitSignalFd(void);
+static void ConsumeSignals(int fd, unsigned int events, void* params);
+static void CloseSignalFd(void);
+static void SendBeat(void);
+static int InitHeartbeat(int is_user);
+static void PollPeerBeats(void);
+static void WatchPeer(void);
+static void UnwatchPeer(void);
+static void ClosePeerFd(void);
+static void PeerExited(int fd, unsigned int events, void* params);
+static void InitLog(void);
+static void FlushLog(void);
+static void InitRecorder(void);
+static void RecordEvent(wd_event_t event, unsigned int counter);
 static int CreateWatchDog(params_obj_t* params);
+static char** CopyEnvironment(char* shm_fd_entry);
+static int InitSpawnActions(posix_spawn_file_actions_t* actions);
+static int AddCloseFrom(posix_spawn_file_actions_t* actions, int first_closed);
+static int InitSpawnAttributes(posix_spawnattr_t* attr);
 
 
 /*----------------------static functions implementations----------------------*/
 static int ResetWatchDog()
 {
     sem_t* sem;
-    pid_t fork_pid;
+    pid_t wd_pid;
     char buffer[STR_SIZE];
 
     kill(g_params.pid_other, SIGUSR2);
     waitpid(g_params.pid_other, NULL, 0);
 
-    fork_pid = fork();
+    wd_pid = SpawnWatchDog();
 
-    if (-1 == fork_pid)
+    if (-1 == wd_pid)
     {
-#ifndef NDEBUG
-    AppendText("Re-execution fork of WD process failed\n");
-#endif
+        AppendText("Re-execution spawn of WD process failed\n");
         return 1;
     }
 
-    else if (0 == fork_pid)
-    {
-        if (0 != ExecWatchDog())
-        {
-            return 1;
-        }
-        FreeAllocatedResources();
-    }
-
-    g_params.pid_other = fork_pid;
+    g_params.pid_other = wd_pid;
     g_params.is_user = 1;
+    RecordEvent(WD_EV_RESTART_WATCHDOG, ++g_num_of_restarts);
 
-    sprintf(buffer, "%d", fork_pid);
+    sprintf(buffer, "%d", wd_pid);
     setenv(WD_ENV_VAR_NAME, buffer, 1);
 
     sem = sem_open(SEM_NAME, O_CREAT, (S_IRUSR | S_IWUSR), 0);
     if (SEM_FAILED == sem)
     {
-#ifndef NDEBUG
-    AppendText("sem_open failed - ResetIsolated\n");
-#endif
+        AppendText("sem_open failed - ResetIsolated\n");
         return 1;
     }
 
@@ -111,11 +156,13 @@ static int ResetUser()
     }
     g_params.argv_wd[i] = NULL;
 
+    RecordEvent(WD_EV_RESTART_USER, ++g_num_of_restarts);
+    /* exec skips the atexit flush, the queued lines would be lost with it */
+    FlushLog();
+
     if (-1 == execvp(g_params.argv_wd[0], g_params.argv_wd))
     {
-#ifndef NDEBUG
-    AppendText("Re-execution of User process failed\n");
-#endif
+        AppendText("Re-execution of User process failed\n");
         return 1;
     }
 
@@ -125,6 +172,8 @@ static int ResetUser()
 static int ResetIsolated()
 {
     atomic_store(&signal_counter, 0);
+    /* the old peer's handle, whether it died or hung */
+    UnwatchPeer();
 
     if (g_params.is_user)
     {
@@ -147,6 +196,9 @@ static int ResetIsolated()
         }
     }
 
+    /* only a restarted watchdog gets here, a restarted user is exec'd */
+    WatchPeer();
+
     return 0;
 }
 
@@ -158,6 +210,7 @@ static int TaskToExecute(void* args)
 
     if (1 == atomic_load(&flag_stop))
     {
+        RecordEvent(WD_EV_STOP, 0);
         HeapSchedulerDestroy(g_params.sched);
         return 0;
     }
@@ -167,7 +220,9 @@ static int TaskToExecute(void* args)
     AppendText(log_buffer);
 #endif
 
-    kill(g_params.pid_other, SIGUSR1);
+    PollPeerBeats();
+    SendBeat();
+    RecordEvent(WD_EV_BEAT_SENT, atomic_load(&signal_counter));
 
 #ifndef NDEBUG
     sprintf(log_buffer, "sent signal %d (SIGUSR1) to pid=%d\n", SIGUSR1,
@@ -179,12 +234,12 @@ static int TaskToExecute(void* args)
 
     if (atomic_load(&signal_counter) > g_params.threshold)
     {
+        RecordEvent(WD_EV_THRESHOLD, atomic_load(&signal_counter));
         HeapSchedulerStop(g_params.sched);
-#ifndef NDEBUG
-    sprintf(log_buffer, "sent signal %d (SIGUSR2) pid=%d -> pid=%d\n", SIGUSR2,
-            getpid(), g_params.pid_other);
-    AppendText(log_buffer);
-#endif
+        /* the restart itself happens once the scheduler's run returns */
+        sprintf(log_buffer, "no beat from pid=%d in %u ticks, restarting it\n",
+                g_params.pid_other, atomic_load(&signal_counter));
+        AppendText(log_buffer);
     }
 
     return 0;
@@ -194,12 +249,14 @@ static void PulseSignal(int signum)
 {
     UNUSED(signum);
     atomic_store(&signal_counter, 0);
+    RecordEvent(WD_EV_BEAT_RECEIVED, 0);
 }
 
 static void StopSignal(int signum)
 {
     UNUSED(signum);
     atomic_store(&flag_stop, 1);
+    RecordEvent(WD_EV_STOP_REQUESTED, 0);
 }
 
 static int InitSignalsDispositions(struct sigaction* act)
@@ -221,15 +278,297 @@ static int InitSignalsDispositions(struct sigaction* act)
     return 0;
 }
 
-static int CreateWatchDog(params_obj_t* params)
+static void InitSignalSet(sigset_t* set)
 {
-    struct sigaction s_act = { 0 };
+    sigemptyset(set);
+    sigaddset(set, SIGUSR1);
+    sigaddset(set, SIGUSR2);
+}
+
+static int InitSignalFd(void)
+{
+    sigset_t set;
+
+    InitSignalSet(&set);
+    g_signal_fd = signalfd(-1, &set, SFD_NONBLOCK | SFD_CLOEXEC);
+
+    if (-1 == g_signal_fd)
+    {
+        return 1;
+    }
 
-    if (0 != InitSignalsDispositions(&s_act))
+    if (0 != HeapSchedulerWatchFd(g_params.sched, g_signal_fd, EPOLLIN,
+                                    ConsumeSignals, NULL))
     {
+        close(g_signal_fd);
+        g_signal_fd = -1;
+        return 1;
+    }
+
+    return 0;
+}
+
+/* runs on the scheduler's thread, between beats - no async-signal rules */
+static void ConsumeSignals(int fd, unsigned int events, void* params)
+{
+    struct signalfd_siginfo info;
 #ifndef NDEBUG
-    AppendText("setenv of WD_ENV_VAR_NAME failed\n");
+    char log_buffer[STR_SIZE];
+#endif
+
+    UNUSED(events);
+    UNUSED(params);
+
+    while (sizeof(info) == read(fd, &info, sizeof(info)))
+    {
+        if (SIGUSR2 == info.ssi_signo)
+        {
+            atomic_store(&flag_stop, 1);
+            RecordEvent(WD_EV_STOP_REQUESTED, 0);
+            continue;
+        }
+
+        /* beats from the peer are numbered, a gap means some were lost */
+        if (SI_QUEUE == info.ssi_code)
+        {
+#ifndef NDEBUG
+            if ((unsigned int)info.ssi_int != g_last_beat + 1)
+            {
+                sprintf(log_buffer, "beat %u after %u from pid=%u\n",
+                        (unsigned int)info.ssi_int, g_last_beat,
+                        info.ssi_pid);
+                AppendText(log_buffer);
+            }
 #endif
+
+            g_last_beat = (unsigned int)info.ssi_int;
+        }
+
+        atomic_store(&signal_counter, 0);
+        RecordEvent(WD_EV_BEAT_RECEIVED, g_last_beat);
+    }
+}
+
+static void CloseSignalFd(void)
+{
+    if (-1 != g_signal_fd)
+    {
+        close(g_signal_fd);
+        g_signal_fd = -1;
+    }
+}
+
+static int InitHeartbeat(int is_user)
+{
+    const char* fd_as_str = getenv(WD_SHM_FD_ENV_VAR_NAME);
+
+    if (NULL == fd_as_str)
+    {
+        return 1;
+    }
+
+    g_heartbeat = ShmHeartbeatCreate(atoi(fd_as_str), is_user ?
+                                SHM_HEARTBEAT_SIDE_A : SHM_HEARTBEAT_SIDE_B);
+
+    if (NULL == g_heartbeat)
+    {
+        return 1;
+    }
+
+    g_last_peer_beats = ShmHeartbeatPeer(g_heartbeat);
+
+    return 0;
+}
+
+/* shared memory mode: what PulseSignal does per signal, once per tick */
+static void PollPeerBeats(void)
+{
+    uint64_t peer_beats = 0;
+
+    if (NULL == g_heartbeat)
+    {
+        return;
+    }
+
+    peer_beats = ShmHeartbeatPeer(g_heartbeat);
+
+    if (peer_beats != g_last_peer_beats)
+    {
+        g_last_peer_beats = peer_beats;
+        atomic_store(&signal_counter, 0);
+        RecordEvent(WD_EV_BEAT_RECEIVED, (unsigned int)peer_beats);
+    }
+}
+
+/*
+* a dead peer is found as soon as it exits instead of after threshold
+* missed beats, which remain for a peer that hangs. Without pidfd (before
+* Linux 5.3) only the beats are left
+*/
+static void WatchPeer(void)
+{
+#ifdef SYS_pidfd_open
+    g_peer_fd = (int)syscall(SYS_pidfd_open, g_params.pid_other, 0);
+#endif
+
+    if (-1 == g_peer_fd)
+    {
+        AppendText("pidfd_open failed, only missed beats detect a crash\n");
+        return;
+    }
+
+    if (0 != HeapSchedulerWatchFd(g_params.sched, g_peer_fd, EPOLLIN,
+                                    PeerExited, NULL))
+    {
+        close(g_peer_fd);
+        g_peer_fd = -1;
+    }
+}
+
+static void UnwatchPeer(void)
+{
+    if (-1 != g_peer_fd)
+    {
+        HeapSchedulerUnwatchFd(g_params.sched, g_peer_fd);
+        ClosePeerFd();
+    }
+}
+
+static void ClosePeerFd(void)
+{
+    if (-1 != g_peer_fd)
+    {
+        close(g_peer_fd);
+        g_peer_fd = -1;
+    }
+}
+
+/* the pidfd turns readable once the peer has exited */
+static void PeerExited(int fd, unsigned int events, void* params)
+{
+    UNUSED(fd);
+    UNUSED(events);
+    UNUSED(params);
+
+    /* WDStop signals this side before the peer, see to it first */
+    if (-1 != g_signal_fd)
+    {
+        ConsumeSignals(g_signal_fd, EPOLLIN, NULL);
+    }
+
+    /* a stopped peer exits by design, the next tick stops this side too */
+    if (1 == atomic_load(&flag_stop))
+    {
+        UnwatchPeer();
+        return;
+    }
+
+    RecordEvent(WD_EV_PEER_EXITED, atomic_load(&signal_counter));
+    AppendText("peer exited, restarting it\n");
+    HeapSchedulerStop(g_params.sched);
+}
+
+static void SendBeat(void)
+{
+    union sigval beat;
+
+    if (NULL != g_heartbeat)
+    {
+        ShmHeartbeatBeat(g_heartbeat);
+        return;
+    }
+
+    if (0 == (g_flags & WD_FLAG_SIGNALFD))
+    {
+        kill(g_params.pid_other, SIGUSR1);
+        return;
+    }
+
+    beat.sival_int = (int)++g_beats_sent;
+    sigqueue(g_params.pid_other, SIGUSR1, beat);
+}
+
+/*
+* one file per process: each log rotates by its own count of bytes, so two
+* processes sharing a file would rename each other's lines away. A user
+* restarted by exec keeps the pid, and the file, of the watchdog it replaces
+*/
+static void InitLog(void)
+{
+    const char* base_path = getenv(LOG_ENV_VAR_NAME);
+    char* path = NULL;
+
+    base_path = (NULL != base_path) ? base_path : LOGFILE_PATH;
+    path = (char*)malloc(strlen(base_path) + LOG_PID_SUFFIX_SIZE);
+
+    if (NULL == path)
+    {
+        return;
+    }
+
+    sprintf(path, "%s.%d", base_path, getpid());
+    g_log = AsyncLogCreate(path, LOG_MAX_FILE_SIZE);
+    free(path);
+
+    if (NULL != g_log)
+    {
+        g_log_pid = getpid();
+        atexit(FlushLog);
+    }
+}
+
+/*
+* only flushed, never destroyed - other threads may still log while the
+* process exits. A forked child has no writer thread to wait for
+*/
+static void FlushLog(void)
+{
+    if (getpid() == g_log_pid)
+    {
+        AsyncLogFlush(g_log);
+    }
+}
+
+static void InitRecorder(void)
+{
+    const char* path = getenv(RECORDER_ENV_VAR_NAME);
+
+    /* kept for the life of the process, signal handlers may record */
+    if (NULL == g_recorder)
+    {
+        g_recorder = FlightRecorderCreate((NULL != path) ? path :
+                                            RECORDER_PATH, RECORDER_CAPACITY);
+    }
+}
+
+/* async signal safe */
+static void RecordEvent(wd_event_t event, unsigned int counter)
+{
+    if (NULL != g_recorder)
+    {
+        FlightRecorderRecord(g_recorder, event, counter);
+    }
+}
+
+static int CreateWatchDog(params_obj_t* params)
+{
+    struct sigaction s_act = { 0 };
+    uid_t task_uid;
+
+    InitRecorder();
+    RecordEvent(WD_EV_START, params->is_user);
+
+    g_flags = GetFlags();
+
+    if (0 != SetSignalMask(g_flags))
+    {
+        return 1;
+    }
+
+    if ((0 == (g_flags & WD_FLAG_SIGNALFD)) &&
+        (0 != InitSignalsDispositions(&s_act)))
+    {
+        AppendText("setenv of WD_ENV_VAR_NAME failed\n");
         return 1;
     }
 
@@ -250,8 +589,173 @@ static int CreateWatchDog(params_obj_t* params)
         return 1;
     }
 
-    HeapSchedulerAdd(g_params.sched, TaskToExecute, &g_params,
-                        g_params.interval);
+    task_uid = HeapSchedulerAdd(g_params.sched, TaskToExecute, &g_params,
+                                g_params.interval * MONO_USEC_PER_MSEC);
+
+    /*
+    * after a stall, one beat and not a burst of them: a burst would count
+    * several misses at once here and flood the other side with SIGUSR1
+    */
+    HeapSchedulerSetMissPolicy(g_params.sched, task_uid, SCHED_MISS_SKIP);
+
+    if ((0 != (g_flags & WD_FLAG_SIGNALFD)) && (0 != InitSignalFd()))
+    {
+        HeapSchedulerDestroy(g_params.sched);
+        return 1;
+    }
+
+    if ((0 != (g_flags & WD_FLAG_SHM_HEARTBEAT)) &&
+        (0 != InitHeartbeat(params->is_user)))
+    {
+        AppendText("joining the heartbeat page failed\n");
+        HeapSchedulerDestroy(g_params.sched);
+        CloseSignalFd();
+        return 1;
+    }
+
+    WatchPeer();
+
+    return 0;
+}
+
+/* environ, with the heartbeat descriptor renamed to where the child finds it */
+static char** CopyEnvironment(char* shm_fd_entry)
+{
+    size_t i = 0;
+    size_t count = 0;
+    size_t name_len = strlen(WD_SHM_FD_ENV_VAR_NAME);
+    char** env = NULL;
+
+    while (NULL != environ[count])
+    {
+        ++count;
+    }
+
+    env = (char**)malloc((count + 1) * sizeof(char*));
+
+    if (NULL == env)
+    {
+        return NULL;
+    }
+
+    for (i = 0; i < count; ++i)
+    {
+        env[i] = environ[i];
+
+        if ((0 == strncmp(environ[i], WD_SHM_FD_ENV_VAR_NAME, name_len)) &&
+            ('=' == environ[i][name_len]))
+        {
+            env[i] = shm_fd_entry;
+        }
+    }
+
+    env[count] = NULL;
+
+    return env;
+}
+
+/*
+* the child keeps stdio and the heartbeat page only: sockets and files of a
+* large service are not the watchdog's to hold open
+*/
+static int InitSpawnActions(posix_spawn_file_actions_t* actions)
+{
+    int status = 0;
+    int first_closed = STDERR_FILENO + 1;
+    const char* fd_as_str = getenv(WD_SHM_FD_ENV_VAR_NAME);
+
+    if (0 != posix_spawn_file_actions_init(actions))
+    {
+        return 1;
+    }
+
+    if (NULL != fd_as_str)
+    {
+        status = posix_spawn_file_actions_adddup2(actions, atoi(fd_as_str),
+                                                    SPAWN_SHM_FD);
+        first_closed = SPAWN_SHM_FD + 1;
+    }
+
+    status = status || AddCloseFrom(actions, first_closed);
+
+    if (0 != status)
+    {
+        posix_spawn_file_actions_destroy(actions);
+        return 1;
+    }
+
+    return 0;
+}
+
+/*
+* closes every descriptor from @first_closed on in the child. Before glibc
+* 2.34, one close per descriptor open now: one opened by another thread
+* in between stays open, unless it is O_CLOEXEC
+*/
+static int AddCloseFrom(posix_spawn_file_actions_t* actions, int first_closed)
+{
+#ifdef HAS_SPAWN_CLOSEFROM
+    return posix_spawn_file_actions_addclosefrom_np(actions, first_closed);
+#else
+    int fd = -1;
+    int status = 0;
+    DIR* dir = opendir(FD_DIR_PATH);
+    struct dirent* entry = NULL;
+
+    /* no /proc mounted, only the O_CLOEXEC descriptors get closed */
+    if (NULL == dir)
+    {
+        return 0;
+    }
+
+    while ((0 == status) && (NULL != (entry = readdir(dir))))
+    {
+        /* "." and ".." read as 0 */
+        fd = atoi(entry->d_name);
+
+        if ((fd >= first_closed) && (fd != dirfd(dir)))
+        {
+            status = posix_spawn_file_actions_addclose(actions, fd);
+        }
+    }
+
+    closedir(dir);
+
+    return status;
+#endif
+}
+
+/*
+* exec resets handled signals but keeps ignored ones, and the mask is the
+* spawning thread's: start from the mask the watchdog's mode expects
+*/
+static int InitSpawnAttributes(posix_spawnattr_t* attr)
+{
+    int status = 0;
+    sigset_t set;
+
+    if (0 != posix_spawnattr_init(attr))
+    {
+        return 1;
+    }
+
+    InitSignalSet(&set);
+    status = posix_spawnattr_setsigdefault(attr, &set);
+
+    if (0 == (GetFlags() & WD_FLAG_SIGNALFD))
+    {
+        sigemptyset(&set);
+    }
+
+    status = status || posix_spawnattr_setsigmask(attr, &set) ||
+                posix_spawnattr_setflags(attr, POSIX_SPAWN_SETSIGMASK |
+                                                POSIX_SPAWN_SETSIGDEF);
+
+    if (0 != status)
+    {
+        posix_spawnattr_destroy(attr);
+        return 1;
+    }
 
     return 0;
 }
@@ -260,9 +764,12 @@ static int CreateWatchDog(params_obj_t* params)
 /*-------------------------API functions implementations----------------------*/
 void AppendText(const char* str_input)
 {
-	FILE* fp = fopen(LOGFILE_PATH, "a");
-	fputs(str_input, fp);
-	fclose(fp);
+    pthread_once(&g_log_once, InitLog);
+
+    if (NULL != g_log)
+    {
+        AsyncLogWrite(g_log, str_input);
+    }
 }
 
 int InitParams(size_t threshold, size_t interval, int argc, char** argv)
@@ -298,31 +805,104 @@ int InitParams(size_t threshold, size_t interval, int argc, char** argv)
     return 0;
 }
 
-int ExecWatchDog()
+unsigned int GetFlags(void)
+{
+    const char* flags_as_str = getenv(WD_FLAGS_ENV_VAR_NAME);
+
+    if (NULL == flags_as_str)
+    {
+        return WD_FLAG_NONE;
+    }
+
+    return (unsigned int)strtoul(flags_as_str, NULL, 0);
+}
+
+int SetSignalMask(unsigned int flags)
+{
+    sigset_t set;
+
+    InitSignalSet(&set);
+
+    return (0 != pthread_sigmask((flags & WD_FLAG_SIGNALFD) ? SIG_BLOCK :
+                                    SIG_UNBLOCK, &set, NULL));
+}
+
+int InitHeartbeatChannel(void)
 {
+    int fd = -1;
     char buffer[STR_SIZE];
+    shm_heartbeat_t* heartbeat = NULL;
+    const char* fd_as_str = getenv(WD_SHM_FD_ENV_VAR_NAME);
 
-    sprintf(buffer, "%d", getpid());
-    if (-1 == setenv(WD_ENV_VAR_NAME, buffer, 1))
+    /* a restarted process keeps the channel of the one it replaces */
+    if (NULL != fd_as_str)
+    {
+        heartbeat = ShmHeartbeatCreate(atoi(fd_as_str), SHM_HEARTBEAT_SIDE_A);
+
+        if (NULL != heartbeat)
+        {
+            ShmHeartbeatDestroy(heartbeat);
+            return 0;
+        }
+    }
+
+    fd = ShmHeartbeatCreateFd();
+
+    if (-1 == fd)
     {
-#ifndef NDEBUG
-    AppendText("setenv of WD_ENV_VAR_NAME failed\n");
-#endif
-        FreeAllocatedResources();
         return 1;
     }
 
-    if (-1 == execvp(EXEC_WD_PATH, g_params.argv_wd))
+    sprintf(buffer, "%d", fd);
+
+    if (-1 == setenv(WD_SHM_FD_ENV_VAR_NAME, buffer, 1))
     {
-#ifndef NDEBUG
-    AppendText("Initial execution of WD process failed\n");
-#endif
-        FreeAllocatedResources();
+        close(fd);
         return 1;
     }
 
-    FreeAllocatedResources();
-    return 1;
+    return 0;
+}
+
+pid_t SpawnWatchDog(void)
+{
+    pid_t wd_pid = -1;
+    int status = 0;
+    char** env = NULL;
+    char shm_fd_entry[STR_SIZE];
+    posix_spawnattr_t attr;
+    posix_spawn_file_actions_t actions;
+
+    sprintf(shm_fd_entry, "%s=%d", WD_SHM_FD_ENV_VAR_NAME, SPAWN_SHM_FD);
+    env = CopyEnvironment(shm_fd_entry);
+
+    if (NULL == env)
+    {
+        return -1;
+    }
+
+    if (0 != InitSpawnActions(&actions))
+    {
+        free(env);
+        return -1;
+    }
+
+    if (0 != InitSpawnAttributes(&attr))
+    {
+        posix_spawn_file_actions_destroy(&actions);
+        free(env);
+        return -1;
+    }
+
+    /* no copy of the page tables: the child runs on this memory until exec */
+    status = posix_spawnp(&wd_pid, EXEC_WD_PATH, &actions, &attr,
+                            g_params.argv_wd, env);
+
+    posix_spawnattr_destroy(&attr);
+    posix_spawn_file_actions_destroy(&actions);
+    free(env);
+
+    return (0 == status) ? wd_pid : -1;
 }
 
 int RunWatchDog(params_obj_t* params)
@@ -339,6 +919,9 @@ int RunWatchDog(params_obj_t* params)
     if (SEM_FAILED == sem)
     {
         HeapSchedulerDestroy(g_params.sched);
+        CloseSignalFd();
+        ClosePeerFd();
+
         return 1;
     }
 
@@ -353,6 +936,11 @@ int RunWatchDog(params_obj_t* params)
     }
 
     sem_close(sem);
+
+    /* the scheduler that watched them is gone by now */
+    CloseSignalFd();
+    ClosePeerFd();
+
     return 0;
 }
 
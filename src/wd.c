@@ -15,7 +15,7 @@
 
 #include <fcntl.h>                  /* O_CREAT */
 #include <sys/stat.h>               /* 0_* constants */
-#include <unistd.h>                 /* fork, execv */
+#include <unistd.h>                 /* getpid */
 #include <pthread.h>                /* pid_t */
 #include <assert.h>                 /* assert */
 #include <string.h>                 /* strcpy */
@@ -32,6 +32,7 @@
 /*-----------------------------------macros-----------------------------------*/
 #define ADDITIONAL_ARGS (4)
 #define WD_ENV_VAR_NAME ("WD_PID")
+#define MSEC_PER_SEC (1000)
 
 
 /*------------------------------global variables------------------------------*/
@@ -52,69 +53,78 @@ static void* ThreadHandler(void* arg)
 
 /*-------------------------API functions implementations----------------------*/
 wd_status_t WDStart(size_t threshold, size_t interval, int argc, char** argv)
+{
+    return WDStartMs(threshold, interval * MSEC_PER_SEC, argc, argv);
+}
+
+wd_status_t WDStartMs(size_t threshold, size_t interval_ms, int argc,
+                        char** argv)
+{
+    return WDStartEx(threshold, interval_ms, GetFlags(), argc, argv);
+}
+
+wd_status_t WDStartEx(size_t threshold, size_t interval_ms, unsigned int flags,
+                        int argc, char** argv)
 {
     sem_t* sem;
-    pid_t fork_pid;
+    pid_t wd_pid;
     pthread_attr_t attr;
     char buffer[STR_SIZE];
 
-    if (0 != InitParams(threshold, interval, argc, argv))
+    /* before the spawn and the watchdog thread, both inherit mask and env */
+    sprintf(buffer, "%u", flags);
+    if ((0 != SetSignalMask(flags)) ||
+        (-1 == setenv(WD_FLAGS_ENV_VAR_NAME, buffer, 1)))
     {
-#ifndef NDEBUG
-    AppendText("allocation and extend of argv failed\n");
-#endif
+        AppendText("setting up the signal mode failed\n");
         return WD_FAILURE;
     }
 
-    sem = sem_open(SEM_NAME, O_CREAT, (S_IRUSR | S_IWUSR), 0);
+    if ((0 != (flags & WD_FLAG_SHM_HEARTBEAT)) &&
+        (0 != InitHeartbeatChannel()))
+    {
+        AppendText("creating the heartbeat page failed\n");
+        return WD_FAILURE;
+    }
 
-    if (SEM_FAILED == sem)
+    if (0 != InitParams(threshold, interval_ms, argc, argv))
     {
-#ifndef NDEBUG
-    AppendText("open semaphore failed\n");
-#endif
+        AppendText("allocation and extend of argv failed\n");
         return WD_FAILURE;
     }
 
-    fork_pid = fork();
+    sem = sem_open(SEM_NAME, O_CREAT, (S_IRUSR | S_IWUSR), 0);
 
-    if (-1 == fork_pid)
+    if (SEM_FAILED == sem)
     {
-#ifndef NDEBUG
-    AppendText("Initial fork failed\n");
-#endif
+        AppendText("open semaphore failed\n");
         return WD_FAILURE;
     }
 
-    else if (0 == fork_pid)
+    wd_pid = SpawnWatchDog();
+
+    if (-1 == wd_pid)
     {
-        if (0 != ExecWatchDog())
-        {
-            return WD_FAILURE;
-        }
-        FreeAllocatedResources();
+        AppendText("Initial spawn of WD process failed\n");
+        sem_close(sem);
+        return WD_FAILURE;
     }
 
-    else
+    params.pid_other = wd_pid;
+    params.is_user = 1;
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
+
+    sem_wait(sem);
+    pthread_create(&wd_thread, &attr, ThreadHandler, NULL);
+    sem_wait(sem);
+
+    sprintf(buffer, "%d", wd_pid);
+    if (-1 == setenv(WD_ENV_VAR_NAME, buffer, 1))
     {
-        params.pid_other = fork_pid;
-        params.is_user = 1;
-
-        pthread_attr_init(&attr);
-        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-
-        sem_wait(sem);
-        pthread_create(&wd_thread, &attr, ThreadHandler, NULL);
-        sem_wait(sem);
-
-        sprintf(buffer, "%d", fork_pid);
-        if (-1 == setenv(WD_ENV_VAR_NAME, buffer, 1))
-        {
-#ifndef NDEBUG
-    AppendText("setenv of WD_ENV_VAR_NAME failed\n");
-#endif
-            return WD_FAILURE;
-        }
+        AppendText("setenv of WD_ENV_VAR_NAME failed\n");
+        return WD_FAILURE;
     }
 
     return WD_SUCCESS;
@@ -125,14 +135,17 @@ void WDStop(void)
     char log_buffer[STR_SIZE];
     char* pid_wd_as_str = getenv(WD_ENV_VAR_NAME);
 
-#ifndef NDEBUG
     AppendText("In Stop function:\n");
     sprintf(log_buffer, "pid wd: %s\n", pid_wd_as_str);
     AppendText(log_buffer);
-#endif
 
+    /*
+    * to the process, a signalfd only sees those or its own thread's. And
+    * first, so it is pending by the time the watchdog exits and this side
+    * sees it die
+    */
+    kill(getpid(), SIGUSR2);
     kill((pid_t)atoi(pid_wd_as_str), SIGUSR2);
-    raise(SIGUSR2);
 
     FreeAllocatedResources();
     pthread_join(wd_thread, NULL);
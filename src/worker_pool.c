@@ -0,0 +1,381 @@
+/******************************************************************************
+ * File name: worker_pool.c
+ * Owner: Ofir Nahshoni
+ ******************************************************************************/
+
+#define _POSIX_C_SOURCE (200809L)
+
+#include <assert.h>         /* assert */
+#include <pthread.h>        /* pthread_create, pthread_mutex_t */
+#include <stdlib.h>         /* malloc, free */
+
+#include "worker_pool.h"
+
+/*-----------------------------------macros-----------------------------------*/
+#define MIN_JOBS (16)
+#define GROWTH_FACTOR (2)
+
+/*-----------------------------typdefs & Structures---------------------------*/
+typedef struct job
+{
+    void (*job_func)(void* params);
+    void* params;
+} job_t;
+
+/* ring of jobs: the owner takes from the head, thieves from the tail */
+typedef struct deque
+{
+    pthread_mutex_t lock;
+    job_t* jobs;
+    size_t capacity;
+    size_t head;
+    size_t size;
+} deque_t;
+
+typedef struct worker
+{
+    worker_pool_t* pool;
+    size_t id;
+    pthread_t thread;
+    deque_t deque;
+} worker_t;
+
+struct worker_pool
+{
+    worker_t* workers;
+    size_t num_of_workers;
+    size_t next_worker;         /* round robin position for submissions */
+    size_t num_of_pending;      /* submitted and not taken yet */
+    int is_stopping;
+    pthread_mutex_t lock;       /* guards the counters and the flag above */
+    pthread_cond_t has_work;
+};
+
+/*------------------------------static functions------------------------------*/
+static int DequeInit(deque_t* deque)
+{
+    deque->jobs = (job_t*)malloc(MIN_JOBS * sizeof(job_t));
+
+    if (NULL == deque->jobs)
+    {
+        return 1;
+    }
+
+    if (0 != pthread_mutex_init(&deque->lock, NULL))
+    {
+        free(deque->jobs);
+        return 1;
+    }
+
+    deque->capacity = MIN_JOBS;
+    deque->head = 0;
+    deque->size = 0;
+
+    return 0;
+}
+
+static void DequeDestroy(deque_t* deque)
+{
+    pthread_mutex_destroy(&deque->lock);
+    free(deque->jobs);
+}
+
+/* unrolls the ring into a larger array, called with the deque locked */
+static int DequeGrow(deque_t* deque)
+{
+    size_t i = 0;
+    size_t new_capacity = deque->capacity * GROWTH_FACTOR;
+    job_t* new_jobs = (job_t*)malloc(new_capacity * sizeof(job_t));
+
+    if (NULL == new_jobs)
+    {
+        return 1;
+    }
+
+    for (i = 0; i < deque->size; ++i)
+    {
+        new_jobs[i] = deque->jobs[(deque->head + i) % deque->capacity];
+    }
+
+    free(deque->jobs);
+    deque->jobs = new_jobs;
+    deque->capacity = new_capacity;
+    deque->head = 0;
+
+    return 0;
+}
+
+static int DequePushBack(deque_t* deque, const job_t* job)
+{
+    int result = 0;
+
+    pthread_mutex_lock(&deque->lock);
+
+    if ((deque->size == deque->capacity) && (0 != DequeGrow(deque)))
+    {
+        result = 1;
+    }
+    else
+    {
+        deque->jobs[(deque->head + deque->size) % deque->capacity] = *job;
+        ++(deque->size);
+    }
+
+    pthread_mutex_unlock(&deque->lock);
+
+    return result;
+}
+
+/* the oldest job - jobs are submitted in the order they should start */
+static int DequePopFront(deque_t* deque, job_t* job)
+{
+    int result = 1;
+
+    pthread_mutex_lock(&deque->lock);
+
+    if (0 != deque->size)
+    {
+        *job = deque->jobs[deque->head];
+        deque->head = (deque->head + 1) % deque->capacity;
+        --(deque->size);
+        result = 0;
+    }
+
+    pthread_mutex_unlock(&deque->lock);
+
+    return result;
+}
+
+/* thieves take the newest job, the one the owner would reach last */
+static int DequePopBack(deque_t* deque, job_t* job)
+{
+    int result = 1;
+
+    pthread_mutex_lock(&deque->lock);
+
+    if (0 != deque->size)
+    {
+        --(deque->size);
+        *job = deque->jobs[(deque->head + deque->size) % deque->capacity];
+        result = 0;
+    }
+
+    pthread_mutex_unlock(&deque->lock);
+
+    return result;
+}
+
+/* own deque first, then steal from the others */
+static int TakeJob(worker_t* worker, job_t* job)
+{
+    size_t i = 0;
+    worker_pool_t* pool = worker->pool;
+
+    if (0 == DequePopFront(&worker->deque, job))
+    {
+        return 0;
+    }
+
+    for (i = 1; i < pool->num_of_workers; ++i)
+    {
+        worker_t* victim = &pool->workers[(worker->id + i) %
+                                            pool->num_of_workers];
+
+        if (0 == DequePopBack(&victim->deque, job))
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+static void* WorkerRoutine(void* params)
+{
+    worker_t* worker = (worker_t*)params;
+    worker_pool_t* pool = worker->pool;
+    job_t job;
+
+    for (;;)
+    {
+        if (0 == TakeJob(worker, &job))
+        {
+            pthread_mutex_lock(&pool->lock);
+            --(pool->num_of_pending);
+            pthread_mutex_unlock(&pool->lock);
+
+            job.job_func(job.params);
+            continue;
+        }
+
+        pthread_mutex_lock(&pool->lock);
+
+        while ((0 == pool->num_of_pending) && !pool->is_stopping)
+        {
+            pthread_cond_wait(&pool->has_work, &pool->lock);
+        }
+
+        /* a stopping pool still runs whatever was submitted before */
+        if (0 == pool->num_of_pending)
+        {
+            pthread_mutex_unlock(&pool->lock);
+            break;
+        }
+
+        pthread_mutex_unlock(&pool->lock);
+    }
+
+    return NULL;
+}
+
+static void StopWorkers(worker_pool_t* pool, size_t num_of_started)
+{
+    size_t i = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->is_stopping = 1;
+    pthread_cond_broadcast(&pool->has_work);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (i = 0; i < num_of_started; ++i)
+    {
+        pthread_join(pool->workers[i].thread, NULL);
+    }
+}
+
+static void FreePool(worker_pool_t* pool, size_t num_of_deques)
+{
+    size_t i = 0;
+
+    for (i = 0; i < num_of_deques; ++i)
+    {
+        DequeDestroy(&pool->workers[i].deque);
+    }
+
+    pthread_cond_destroy(&pool->has_work);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->workers);
+    free(pool);
+}
+
+/*--------------------------------API functions-------------------------------*/
+worker_pool_t* WorkerPoolCreate(size_t num_of_workers)
+{
+    size_t i = 0;
+    worker_pool_t* pool = NULL;
+
+    assert(num_of_workers > 0);
+
+    pool = (worker_pool_t*)malloc(sizeof(worker_pool_t));
+
+    if (NULL == pool)
+    {
+        return NULL;
+    }
+
+    pool->workers = (worker_t*)malloc(num_of_workers * sizeof(worker_t));
+
+    if (NULL == pool->workers)
+    {
+        free(pool);
+        return NULL;
+    }
+
+    if (0 != pthread_mutex_init(&pool->lock, NULL))
+    {
+        free(pool->workers);
+        free(pool);
+        return NULL;
+    }
+
+    if (0 != pthread_cond_init(&pool->has_work, NULL))
+    {
+        pthread_mutex_destroy(&pool->lock);
+        free(pool->workers);
+        free(pool);
+        return NULL;
+    }
+
+    pool->num_of_workers = num_of_workers;
+    pool->next_worker = 0;
+    pool->num_of_pending = 0;
+    pool->is_stopping = 0;
+
+    for (i = 0; i < num_of_workers; ++i)
+    {
+        pool->workers[i].pool = pool;
+        pool->workers[i].id = i;
+
+        if (0 != DequeInit(&pool->workers[i].deque))
+        {
+            FreePool(pool, i);
+            return NULL;
+        }
+    }
+
+    /* every deque exists before any worker may try to steal from it */
+    for (i = 0; i < num_of_workers; ++i)
+    {
+        if (0 != pthread_create(&pool->workers[i].thread, NULL, WorkerRoutine,
+                                &pool->workers[i]))
+        {
+            StopWorkers(pool, i);
+            FreePool(pool, num_of_workers);
+            return NULL;
+        }
+    }
+
+    return pool;
+}
+
+void WorkerPoolDestroy(worker_pool_t* pool)
+{
+    if (NULL == pool)
+    {
+        return;
+    }
+
+    StopWorkers(pool, pool->num_of_workers);
+    FreePool(pool, pool->num_of_workers);
+}
+
+int WorkerPoolSubmit(worker_pool_t* pool, void (*job_func)(void* params),
+                        void* params)
+{
+    size_t target = 0;
+    job_t job;
+
+    assert(pool);
+    assert(job_func);
+
+    job.job_func = job_func;
+    job.params = params;
+
+    /* counted before it is visible, so a worker never takes it uncounted */
+    pthread_mutex_lock(&pool->lock);
+    target = pool->next_worker;
+    pool->next_worker = (target + 1) % pool->num_of_workers;
+    ++(pool->num_of_pending);
+    pthread_mutex_unlock(&pool->lock);
+
+    if (0 != DequePushBack(&pool->workers[target].deque, &job))
+    {
+        pthread_mutex_lock(&pool->lock);
+        --(pool->num_of_pending);
+        pthread_mutex_unlock(&pool->lock);
+        return 1;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pthread_cond_signal(&pool->has_work);
+    pthread_mutex_unlock(&pool->lock);
+
+    return 0;
+}
+
+size_t WorkerPoolSize(const worker_pool_t* pool)
+{
+    assert(pool);
+
+    return pool->num_of_workers;
+}
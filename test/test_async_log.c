@@ -0,0 +1,182 @@
+/*
+* File name: test_async_log.c
+* Description: Tests for the async log. Several producer threads each write
+*              numbered lines, many times the size of their ring, while the
+*              file rotates once. The file and its backup together must hold
+*              every line that was queued, each one whole, and the lines of
+*              every thread in the order they were written.
+*/
+
+#define _POSIX_C_SOURCE (200809L)
+
+#include <pthread.h>        /* pthread_create, pthread_join */
+#include <stdio.h>          /* printf, sprintf, sscanf, fopen, fgets */
+#include <stdlib.h>         /* mkdtemp */
+#include <string.h>         /* memset, strcmp, strncmp, strlen */
+#include <unistd.h>         /* unlink, rmdir */
+
+#include "async_log.h"
+#include "mono_clock.h"
+
+#define NUM_OF_PRODUCERS (4)
+#define LINES_PER_PRODUCER (4000)   /* a ring holds far fewer */
+#define LINE_SIZE (48)              /* with the newline */
+#define PATH_SIZE (64)
+#define DROP_NOTE ("async_log: ")
+/* a single rotation: the first file takes more than half the lines */
+#define MAX_FILE_SIZE (NUM_OF_PRODUCERS * LINES_PER_PRODUCER * LINE_SIZE * 3 \
+                        / 5)
+
+typedef struct producer
+{
+    async_log_t* log;
+    unsigned int id;
+    size_t num_of_drops;
+} producer_t;
+
+static void FormatLine(char* buffer, unsigned int id, unsigned int seq);
+static void* Produce(void* params);
+static int CheckFile(const char* path, unsigned int* next_seqs,
+                        size_t* num_of_lines);
+
+int main(void)
+{
+    size_t i = 0;
+    int result = 0;
+    size_t num_of_lines = 0;
+    size_t num_of_drops = 0;
+    char dir[] = "/tmp/test_async_log_XXXXXX";
+    char path[PATH_SIZE];
+    char backup_path[PATH_SIZE];
+    unsigned int next_seqs[NUM_OF_PRODUCERS] = { 0 };
+    pthread_t threads[NUM_OF_PRODUCERS];
+    producer_t producers[NUM_OF_PRODUCERS];
+    async_log_t* log = NULL;
+
+    if (NULL == mkdtemp(dir))
+    {
+        printf("async log           FAILED\n");
+        return 1;
+    }
+
+    sprintf(path, "%s/test.log", dir);
+    sprintf(backup_path, "%s/test.log.1", dir);
+
+    log = AsyncLogCreate(path, MAX_FILE_SIZE);
+    result |= (NULL == log);
+
+    for (i = 0; (0 == result) && (i < NUM_OF_PRODUCERS); ++i)
+    {
+        producers[i].log = log;
+        producers[i].id = (unsigned int)i;
+        producers[i].num_of_drops = 0;
+
+        if (0 != pthread_create(&threads[i], NULL, Produce, &producers[i]))
+        {
+            result = 1;
+        }
+    }
+
+    while (i-- > 0)
+    {
+        pthread_join(threads[i], NULL);
+        num_of_drops += producers[i].num_of_drops;
+    }
+
+    if (NULL != log)
+    {
+        /* every drop was retried, and counted once */
+        result |= (num_of_drops != AsyncLogDropped(log));
+        AsyncLogDestroy(log);
+    }
+
+    /* the backup holds the older lines */
+    result |= CheckFile(backup_path, next_seqs, &num_of_lines);
+    result |= CheckFile(path, next_seqs, &num_of_lines);
+    result |= (NUM_OF_PRODUCERS * LINES_PER_PRODUCER != num_of_lines);
+
+    for (i = 0; i < NUM_OF_PRODUCERS; ++i)
+    {
+        result |= (LINES_PER_PRODUCER != next_seqs[i]);
+    }
+
+    printf("async log           %s\n", (0 == result) ? "PASSED" : "FAILED");
+
+    unlink(backup_path);
+    unlink(path);
+    rmdir(dir);
+
+    return result;
+}
+
+/* fixed size, so a line cut short or merged with another doesn't match */
+static void FormatLine(char* buffer, unsigned int id, unsigned int seq)
+{
+    sprintf(buffer, "producer %u line %06u ", id, seq);
+    memset(buffer + strlen(buffer), 'a' + id, LINE_SIZE - 1 - strlen(buffer));
+    buffer[LINE_SIZE - 1] = '\n';
+    buffer[LINE_SIZE] = '\0';
+}
+
+/* a full ring drops the line, so wait for the writer and queue it again */
+static void* Produce(void* params)
+{
+    unsigned int seq = 0;
+    char line[LINE_SIZE + 1];
+    producer_t* producer = (producer_t*)params;
+
+    for (seq = 0; seq < LINES_PER_PRODUCER; ++seq)
+    {
+        FormatLine(line, producer->id, seq);
+
+        while (0 != AsyncLogWrite(producer->log, line))
+        {
+            ++producer->num_of_drops;
+            MonoClockSleepUntil(MonoClockNow() + MONO_USEC_PER_MSEC);
+        }
+    }
+
+    return NULL;
+}
+
+/* every line whole, each producer's lines in order and without gaps */
+static int CheckFile(const char* path, unsigned int* next_seqs,
+                        size_t* num_of_lines)
+{
+    int result = 0;
+    unsigned int id = 0;
+    unsigned int seq = 0;
+    char line[ASYNC_LOG_LINE_MAX];
+    char expected[LINE_SIZE + 1];
+    FILE* file = fopen(path, "r");
+
+    if (NULL == file)
+    {
+        return 1;
+    }
+
+    while ((0 == result) && (NULL != fgets(line, sizeof(line), file)))
+    {
+        /* the writer notes drops in the file too */
+        if (0 == strncmp(line, DROP_NOTE, strlen(DROP_NOTE)))
+        {
+            continue;
+        }
+
+        if ((2 != sscanf(line, "producer %u line %u", &id, &seq)) ||
+            (id >= NUM_OF_PRODUCERS))
+        {
+            result = 1;
+            break;
+        }
+
+        FormatLine(expected, id, next_seqs[id]);
+        result |= (0 != strcmp(line, expected));
+        ++next_seqs[id];
+        ++*num_of_lines;
+    }
+
+    fclose(file);
+
+    return result;
+}
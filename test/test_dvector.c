@@ -0,0 +1,245 @@
+/*
+* File name: test_dvector.c
+* Description: Tests for the dvector capacity policy - growing, automatic
+*              shrinking without realloc ping-pong, reserve and shrink to fit -
+*              and for the bulk / in-place element access.
+*/
+
+#include <stdio.h>          /* printf */
+
+#include "dvector.h"
+
+#define INITIAL_CAPACITY (8)
+#define PEAK_SIZE (4096)
+#define NUM_OF_ROUNDS (1000)
+
+static int PushN(dvector_t* vector, size_t count);
+static int PopN(dvector_t* vector, size_t count);
+static int TestValues(void);
+static int TestNoPingPong(void);
+static int TestReserve(void);
+static int TestShrinkToFit(void);
+static int TestBulkAccess(void);
+
+int main(void)
+{
+    int result = 0;
+
+    result |= TestValues();
+    result |= TestNoPingPong();
+    result |= TestReserve();
+    result |= TestShrinkToFit();
+    result |= TestBulkAccess();
+
+    printf("dvector %s\n", (0 == result) ? "PASSED" : "FAILED");
+
+    return result;
+}
+
+static int PushN(dvector_t* vector, size_t count)
+{
+    size_t i = 0;
+    int result = 0;
+
+    for (i = 0; i < count; ++i)
+    {
+        size_t value = DvectorSize(vector);
+
+        result |= DvectorPushBack(vector, &value);
+    }
+
+    return result;
+}
+
+static int PopN(dvector_t* vector, size_t count)
+{
+    size_t i = 0;
+    int result = 0;
+
+    for (i = 0; i < count; ++i)
+    {
+        result |= DvectorPopBack(vector);
+    }
+
+    return result;
+}
+
+static int TestValues(void)
+{
+    size_t i = 0;
+    size_t value = 0;
+    int result = 0;
+    dvector_t* vector = DvectorCreate(INITIAL_CAPACITY, sizeof(size_t));
+
+    result |= PushN(vector, PEAK_SIZE);
+    result |= PopN(vector, PEAK_SIZE - 100);
+
+    /* shrinking must keep the remaining elements */
+    for (i = 0; i < DvectorSize(vector); ++i)
+    {
+        DvectorGetElement(vector, i, &value);
+        result |= (value != i);
+    }
+
+    result |= (100 != DvectorSize(vector));
+    result |= (0 != PopN(vector, 100));
+    result |= (0 == DvectorPopBack(vector));
+
+    DvectorDestroy(vector);
+
+    if (0 != result)
+    {
+        printf("TestValues failed\n");
+    }
+
+    return result;
+}
+
+static int TestNoPingPong(void)
+{
+    size_t i = 0;
+    size_t capacity = 0;
+    int result = 0;
+    dvector_t* vector = DvectorCreate(INITIAL_CAPACITY, sizeof(size_t));
+
+    result |= PushN(vector, PEAK_SIZE);
+    capacity = DvectorCapacity(vector);
+
+    /* pop until the first automatic shrink */
+    while (capacity == DvectorCapacity(vector))
+    {
+        result |= DvectorPopBack(vector);
+    }
+
+    /* a shrunk vector keeps room to grow, and shrinks no more nearby */
+    capacity = DvectorCapacity(vector);
+    result |= (capacity < 2 * DvectorSize(vector));
+
+    for (i = 0; i < NUM_OF_ROUNDS; ++i)
+    {
+        result |= PushN(vector, 1 + i % 3);
+        result |= PopN(vector, 1 + i % 3);
+        result |= PopN(vector, 1);
+        result |= PushN(vector, 1);
+    }
+
+    result |= (capacity != DvectorCapacity(vector));
+
+    /* never below the creation capacity */
+    result |= PopN(vector, DvectorSize(vector));
+    result |= (DvectorCapacity(vector) < INITIAL_CAPACITY);
+
+    DvectorDestroy(vector);
+
+    if (0 != result)
+    {
+        printf("TestNoPingPong failed\n");
+    }
+
+    return result;
+}
+
+static int TestReserve(void)
+{
+    int result = 0;
+    dvector_t* vector = DvectorCreate(INITIAL_CAPACITY, sizeof(size_t));
+
+    result |= DvectorReserve(vector, PEAK_SIZE);
+    result |= (PEAK_SIZE != DvectorCapacity(vector));
+
+    /* filling up to the reserved capacity doesn't realloc */
+    result |= PushN(vector, PEAK_SIZE);
+    result |= (PEAK_SIZE != DvectorCapacity(vector));
+
+    /* and emptying doesn't shrink below it */
+    result |= PopN(vector, PEAK_SIZE);
+    result |= (PEAK_SIZE != DvectorCapacity(vector));
+
+    /* a smaller reserve only lowers the floor */
+    result |= DvectorReserve(vector, INITIAL_CAPACITY);
+    result |= (PEAK_SIZE != DvectorCapacity(vector));
+
+    DvectorDestroy(vector);
+
+    if (0 != result)
+    {
+        printf("TestReserve failed\n");
+    }
+
+    return result;
+}
+
+static int TestShrinkToFit(void)
+{
+    int result = 0;
+    dvector_t* vector = DvectorCreate(PEAK_SIZE, sizeof(size_t));
+
+    result |= PushN(vector, 10);
+    result |= DvectorShrinkToFit(vector);
+    result |= (10 != DvectorCapacity(vector));
+
+    result |= PopN(vector, 10);
+    result |= DvectorShrinkToFit(vector);
+    result |= (0 != DvectorCapacity(vector));
+
+    /* an emptied vector still grows on demand */
+    result |= PushN(vector, 3);
+    result |= (3 != DvectorSize(vector));
+
+    DvectorDestroy(vector);
+
+    if (0 != result)
+    {
+        printf("TestShrinkToFit failed\n");
+    }
+
+    return result;
+}
+
+static int TestBulkAccess(void)
+{
+    size_t i = 0;
+    size_t* data = NULL;
+    size_t* slot = NULL;
+    size_t range[PEAK_SIZE];
+    int result = 0;
+    dvector_t* vector = DvectorCreate(INITIAL_CAPACITY, sizeof(size_t));
+
+    for (i = 0; i < PEAK_SIZE; ++i)
+    {
+        range[i] = i;
+    }
+
+    /* one append much larger than the capacity, then a small one */
+    result |= DvectorAppendRange(vector, range, PEAK_SIZE - 1);
+    result |= DvectorAppendRange(vector, range + PEAK_SIZE - 1, 1);
+    result |= DvectorAppendRange(vector, NULL, 0);
+    result |= (PEAK_SIZE != DvectorSize(vector));
+
+    slot = (size_t*)DvectorEmplaceBack(vector);
+    result |= (NULL == slot);
+    *slot = PEAK_SIZE;
+
+    DvectorSwap(vector, 0, PEAK_SIZE);
+    DvectorSwap(vector, 0, PEAK_SIZE);
+    DvectorSwap(vector, 1, 1);
+
+    data = (size_t*)DvectorData(vector);
+
+    for (i = 0; i <= PEAK_SIZE; ++i)
+    {
+        result |= (data[i] != i);
+    }
+
+    DvectorSwap(vector, 0, PEAK_SIZE);
+    result |= ((PEAK_SIZE != data[0]) || (0 != data[PEAK_SIZE]));
+
+    DvectorDestroy(vector);
+
+    if (0 != result)
+    {
+        printf("TestBulkAccess failed\n");
+    }
+
+    return result;
+}
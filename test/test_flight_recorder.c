@@ -0,0 +1,195 @@
+/*
+* File name: test_flight_recorder.c
+* Description: Tests for the flight recorder. Records more events than the
+*              ring holds, some of them from a signal handler, then reads
+*              the file back directly and through the fr_decode tool: the
+*              ring must hold the newest records, oldest first, each one
+*              with this process's pid and its counter. A recorder opened
+*              again on the same file continues where the last one stopped.
+*              Usage: test_flight_recorder.out [path to fr_decode.out]
+*/
+
+#define _POSIX_C_SOURCE (200809L)
+
+#include <signal.h>         /* sigaction, raise */
+#include <stdio.h>          /* printf, sprintf, fopen, fread, popen */
+#include <stdlib.h>         /* mkdtemp, strtoul */
+#include <string.h>         /* memset, strstr, strrchr */
+#include <unistd.h>         /* getpid, unlink, rmdir */
+
+#include "flight_recorder.h"
+
+#define CAPACITY (8)
+#define NUM_OF_RECORDS (21)     /* wraps the ring more than twice */
+#define NUM_OF_REOPENED (3)
+#define SIGNAL_EVERY (4)        /* every 4th record comes from the handler */
+#define TEST_EVENT (3)
+#define DECODER ("./fr_decode.out")
+#define PATH_SIZE (64)
+#define COMMAND_SIZE (192)
+#define LINE_SIZE (256)
+
+static void RecordFromHandler(int signo);
+static int RecordAll(const char* path, unsigned int first,
+                        unsigned int count);
+static int CheckFile(const char* path, uint64_t num_of_records);
+static int CheckDecoded(const char* decoder, const char* path,
+                        uint64_t num_of_records);
+
+static flight_recorder_t* g_recorder = NULL;
+static volatile sig_atomic_t g_counter = 0;
+
+int main(int argc, char* argv[])
+{
+    int result = 0;
+    const char* decoder = (argc > 1) ? argv[1] : DECODER;
+    char dir[] = "/tmp/test_flight_recorder_XXXXXX";
+    char path[PATH_SIZE];
+    struct sigaction act;
+
+    if (NULL == mkdtemp(dir))
+    {
+        printf("flight recorder     FAILED\n");
+        return 1;
+    }
+
+    sprintf(path, "%s/flight.bin", dir);
+
+    memset(&act, 0, sizeof(act));
+    act.sa_handler = RecordFromHandler;
+    sigemptyset(&act.sa_mask);
+    result |= (0 != sigaction(SIGUSR1, &act, NULL));
+
+    result |= RecordAll(path, 0, NUM_OF_RECORDS);
+    result |= CheckFile(path, NUM_OF_RECORDS);
+    result |= CheckDecoded(decoder, path, NUM_OF_RECORDS);
+
+    /* a restarted process appends to the same history */
+    result |= RecordAll(path, NUM_OF_RECORDS, NUM_OF_REOPENED);
+    result |= CheckFile(path, NUM_OF_RECORDS + NUM_OF_REOPENED);
+    result |= CheckDecoded(decoder, path, NUM_OF_RECORDS + NUM_OF_REOPENED);
+
+    printf("flight recorder     %s\n", (0 == result) ? "PASSED" : "FAILED");
+
+    unlink(path);
+    rmdir(dir);
+
+    return result;
+}
+
+static void RecordFromHandler(int signo)
+{
+    (void)signo;
+
+    FlightRecorderRecord(g_recorder, TEST_EVENT, (unsigned int)g_counter);
+}
+
+/* the counter of every record is its index in the file's history */
+static int RecordAll(const char* path, unsigned int first,
+                        unsigned int count)
+{
+    unsigned int i = 0;
+
+    g_recorder = FlightRecorderCreate(path, CAPACITY);
+
+    if (NULL == g_recorder)
+    {
+        return 1;
+    }
+
+    for (i = first; i < first + count; ++i)
+    {
+        if (0 == i % SIGNAL_EVERY)
+        {
+            g_counter = (sig_atomic_t)i;
+            raise(SIGUSR1);
+        }
+        else
+        {
+            FlightRecorderRecord(g_recorder, TEST_EVENT, i);
+        }
+    }
+
+    FlightRecorderDestroy(g_recorder);
+    g_recorder = NULL;
+
+    return 0;
+}
+
+static int CheckFile(const char* path, uint64_t num_of_records)
+{
+    int result = 0;
+    uint64_t i = 0;
+    fr_file_header_t header;
+    fr_record_t records[CAPACITY];
+    FILE* file = fopen(path, "rb");
+
+    if (NULL == file)
+    {
+        return 1;
+    }
+
+    result |= (1 != fread(&header, sizeof(header), 1, file));
+    result |= (CAPACITY != fread(records, sizeof(fr_record_t), CAPACITY,
+                                    file));
+    fclose(file);
+
+    result |= ((FR_MAGIC != header.magic) || (CAPACITY != header.capacity));
+    result |= (num_of_records != header.next);
+
+    for (i = num_of_records - CAPACITY; (0 == result) &&
+            (i < num_of_records); ++i)
+    {
+        const fr_record_t* record = &records[i % CAPACITY];
+
+        result |= (0 == record->time_us);
+        result |= ((uint32_t)getpid() != FR_RECORD_PID(record));
+        result |= (TEST_EVENT != FR_RECORD_EVENT(record));
+        result |= (i != FR_RECORD_COUNTER(record));
+    }
+
+    return result;
+}
+
+/* one line per record, the index first, the counter last */
+static int CheckDecoded(const char* decoder, const char* path,
+                        uint64_t num_of_records)
+{
+    int result = 0;
+    uint64_t next_index = num_of_records - CAPACITY;
+    char command[COMMAND_SIZE];
+    char line[LINE_SIZE];
+    FILE* output = NULL;
+
+    sprintf(command, "%s %s", decoder, path);
+    output = popen(command, "r");
+
+    if (NULL == output)
+    {
+        return 1;
+    }
+
+    /* the summary line */
+    if (NULL == fgets(line, sizeof(line), output))
+    {
+        result = 1;
+    }
+
+    while ((0 == result) && (NULL != fgets(line, sizeof(line), output)))
+    {
+        const char* pid = strstr(line, "pid ");
+        const char* counter = strrchr(line, ' ');
+
+        result |= (next_index != strtoul(line, NULL, 10));
+        result |= ((NULL == pid) || ((unsigned long)getpid() !=
+                                        strtoul(pid + 4, NULL, 10)));
+        result |= ((NULL == counter) ||
+                    (next_index != strtoul(counter, NULL, 10)));
+        ++next_index;
+    }
+
+    result |= (0 != pclose(output));
+    result |= (num_of_records != next_index);
+
+    return result;
+}
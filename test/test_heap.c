@@ -0,0 +1,297 @@
+/*
+* File name: test_heap.c
+* Description: Randomized property test for the heap. Runs a long sequence of
+*              mixed push / bulk push / pop / remove / update operations and
+*              validates the heap order and the reported element positions
+*              along the way, for binary, 4-ary and 8-ary heaps.
+*              Usage: test_heap.out [num_of_ops] [seed]
+*/
+
+#include <stdio.h>          /* printf */
+#include <stdlib.h>         /* rand, srand, strtoul */
+#include <string.h>         /* memset */
+#include <time.h>           /* time */
+
+#include "heap.h"
+
+#define NUM_OF_OPS (2000000)
+#define POOL_SIZE (1024)
+#define KEY_RANGE (512)
+#define FULL_CHECK_EVERY (16)
+#define NUM_OF_ARITIES (3)
+#define MAX_BUILD (64)
+
+typedef struct element
+{
+    int key;
+    int in_heap;
+    size_t index;
+} element_t;
+
+typedef enum op
+{
+    OP_PUSH = 0,
+    OP_POP,
+    OP_REMOVE_AT,
+    OP_REMOVE_MATCH,
+    OP_UPDATE,
+    OP_BUILD,
+    NUM_OF_OP_TYPES
+} op_t;
+
+static element_t g_pool[POOL_SIZE];
+static element_t* g_slots[POOL_SIZE];   /* mirror of the heap array */
+static size_t g_arity = HEAP_BINARY;
+
+static int Compare(const void* data, const void* param);
+static int IsMatch(const void* data, const void* param);
+static void SetIndex(void* data, size_t index);
+static element_t* PickElement(int in_heap);
+static int CheckHeap(const heap_t* heap, size_t expected_size);
+static int RunOp(heap_t* heap, op_t op, size_t* size);
+static int TestArity(size_t arity, size_t num_of_ops, unsigned int seed);
+
+int main(int argc, char* argv[])
+{
+    size_t i = 0;
+    size_t num_of_ops = NUM_OF_OPS;
+    unsigned int seed = (unsigned int)time(NULL);
+    const size_t arities[NUM_OF_ARITIES] = { HEAP_BINARY, HEAP_4_ARY,
+                                            HEAP_8_ARY };
+    int result = 0;
+
+    if (argc > 1)
+    {
+        num_of_ops = strtoul(argv[1], NULL, 10);
+    }
+
+    if (argc > 2)
+    {
+        seed = (unsigned int)strtoul(argv[2], NULL, 10);
+    }
+
+    for (i = 0; i < NUM_OF_ARITIES; ++i)
+    {
+        result |= TestArity(arities[i], num_of_ops, seed);
+    }
+
+    return result;
+}
+
+static int TestArity(size_t arity, size_t num_of_ops, unsigned int seed)
+{
+    size_t i = 0;
+    size_t size = 0;
+    heap_t* heap = NULL;
+
+    srand(seed);
+    memset(g_pool, 0, sizeof(g_pool));
+    g_arity = arity;
+
+    heap = HeapCreate(Compare, SetIndex, arity);
+
+    if (NULL == heap)
+    {
+        printf("HeapCreate failed\n");
+        return 1;
+    }
+
+    for (i = 0; i < num_of_ops; ++i)
+    {
+        if ((0 != RunOp(heap, (op_t)(rand() % NUM_OF_OP_TYPES), &size)) ||
+            ((0 == i % FULL_CHECK_EVERY) && (0 != CheckHeap(heap, size))))
+        {
+            printf("arity %lu: FAILED at op %lu (seed %u)\n", arity, i, seed);
+            HeapDestroy(heap);
+            return 1;
+        }
+    }
+
+    if (0 != CheckHeap(heap, size))
+    {
+        printf("arity %lu: FAILED at the end (seed %u)\n", arity, seed);
+        HeapDestroy(heap);
+        return 1;
+    }
+
+    printf("arity %lu: PASSED %lu ops (seed %u)\n", arity, num_of_ops, seed);
+
+    HeapDestroy(heap);
+
+    return 0;
+}
+
+static int Compare(const void* data, const void* param)
+{
+    return (((const element_t*)data)->key - ((const element_t*)param)->key);
+}
+
+static int IsMatch(const void* data, const void* param)
+{
+    return (data == param);
+}
+
+static void SetIndex(void* data, size_t index)
+{
+    ((element_t*)data)->index = index;
+    g_slots[index] = (element_t*)data;
+}
+
+static element_t* PickElement(int in_heap)
+{
+    size_t start = (size_t)rand() % POOL_SIZE;
+    size_t i = 0;
+
+    for (i = 0; i < POOL_SIZE; ++i)
+    {
+        element_t* element = &g_pool[(start + i) % POOL_SIZE];
+
+        if (in_heap == element->in_heap)
+        {
+            return element;
+        }
+    }
+
+    return NULL;
+}
+
+static int CheckHeap(const heap_t* heap, size_t expected_size)
+{
+    size_t i = 0;
+
+    if (HeapSize(heap) != expected_size)
+    {
+        printf("size %lu, expected %lu\n", HeapSize(heap), expected_size);
+        return 1;
+    }
+
+    for (i = 0; i < expected_size; ++i)
+    {
+        if ((!g_slots[i]->in_heap) || (g_slots[i]->index != i))
+        {
+            printf("slot %lu holds a stale element\n", i);
+            return 1;
+        }
+
+        if ((0 != i) && (g_slots[i]->key < g_slots[(i - 1) / g_arity]->key))
+        {
+            printf("heap order broken at slot %lu\n", i);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static int RunOp(heap_t* heap, op_t op, size_t* size)
+{
+    element_t* element = NULL;
+    void* batch[MAX_BUILD];
+    size_t count = 0;
+    size_t i = 0;
+
+    switch (op)
+    {
+        case OP_PUSH:
+            element = PickElement(0);
+
+            if (NULL == element)
+            {
+                return 0;
+            }
+
+            element->key = rand() % KEY_RANGE;
+            element->in_heap = 1;
+            ++(*size);
+
+            return HeapPush(heap, element);
+
+        case OP_POP:
+            if (0 == *size)
+            {
+                return 0;
+            }
+
+            element = (element_t*)HeapPeek(heap);
+
+            /* the peeked element must be a minimum */
+            for (i = 0; i < POOL_SIZE; ++i)
+            {
+                if (g_pool[i].in_heap && (g_pool[i].key < element->key))
+                {
+                    printf("peek returned %d, %d is smaller\n", element->key,
+                            g_pool[i].key);
+                    return 1;
+                }
+            }
+
+            element->in_heap = 0;
+            --(*size);
+
+            return HeapPop(heap);
+
+        case OP_REMOVE_AT:
+            element = PickElement(1);
+
+            if (NULL == element)
+            {
+                return 0;
+            }
+
+            element->in_heap = 0;
+            --(*size);
+
+            return (element != HeapRemoveAt(heap, element->index));
+
+        case OP_REMOVE_MATCH:
+            element = PickElement(1);
+
+            if (NULL == element)
+            {
+                return 0;
+            }
+
+            element->in_heap = 0;
+            --(*size);
+
+            return (element != HeapRemove(heap, element, IsMatch));
+
+        case OP_UPDATE:
+            element = PickElement(1);
+
+            if (NULL == element)
+            {
+                return 0;
+            }
+
+            element->key = rand() % KEY_RANGE;
+            HeapUpdate(heap, element->index);
+
+            return 0;
+
+        case OP_BUILD:
+            /* small batches sift up, a batch larger than the heap rebuilds */
+            count = (size_t)rand() % MAX_BUILD;
+
+            for (i = 0; i < count; ++i)
+            {
+                element = PickElement(0);
+
+                if (NULL == element)
+                {
+                    break;
+                }
+
+                element->key = rand() % KEY_RANGE;
+                element->in_heap = 1;
+                batch[i] = element;
+            }
+
+            *size += i;
+
+            return HeapBuild(heap, batch, i);
+
+        default:
+            return 1;
+    }
+}
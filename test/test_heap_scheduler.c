@@ -0,0 +1,851 @@
+/*
+* File name: test_heap_scheduler.c
+* Description: Conformance tests for the scheduler. Every test runs against
+*              each queue backend, so all of them have to honor the same
+*              heap_scheduler.h contract.
+*/
+
+#define _POSIX_C_SOURCE (200809L)
+
+#include <pthread.h>        /* pthread_create, pthread_join */
+#include <stdio.h>          /* printf */
+#include <sys/epoll.h>      /* EPOLLIN */
+#include <unistd.h>         /* pipe, read, write, close */
+
+#include "heap_scheduler.h"
+#include "mono_clock.h"
+
+#define MS (MONO_USEC_PER_MSEC)
+#define MAX_RECORDS (16)
+#define NUM_OF_BACKENDS (2)
+/* wheel deadlines are rounded up to its tick, allow for that and for noise */
+#define TOLERANCE_US (20 * MS)
+
+typedef struct record
+{
+    heap_scheduler_t* sched;
+    size_t count;
+    size_t limit;
+    int order[MAX_RECORDS];
+    mono_time_t ran_at[MAX_RECORDS];
+    uid_t self;
+    int self_remove_result;
+} record_t;
+
+/* an action another thread performs while the scheduler waits */
+typedef struct remote_call
+{
+    heap_scheduler_t* sched;
+    mono_time_t delay_us;
+    int is_add;             /* add an earlier task, or stop the scheduler */
+} remote_call_t;
+
+typedef struct test_case
+{
+    const char* name;
+    int (*test)(sched_backend_t backend);
+} test_case_t;
+
+static record_t g_record;
+static int g_pipe[2];
+
+static void ResetRecord(heap_scheduler_t* sched, size_t limit);
+static int RecordOnce(void* params);
+static int CountAndStop(void* params);
+static int TimeAndStop(void* params);
+static int RemoveSelf(void* params);
+static int DestroyScheduler(void* params);
+static int ClearOthers(void* params);
+static void* RemoteCall(void* params);
+static void* RemoteRemove(void* params);
+static int SleepOnce(void* params);
+static int StallFirstRun(void* params);
+static int SleepAndCount(void* params);
+static void* WriteToPipe(void* params);
+static void ReadAndStop(int fd, unsigned int events, void* params);
+
+static int TestOrder(sched_backend_t backend);
+static int TestRemove(sched_backend_t backend);
+static int TestReschedule(sched_backend_t backend);
+static int TestStop(sched_backend_t backend);
+static int TestPeriodicTiming(sched_backend_t backend);
+static int TestRemoveRunning(sched_backend_t backend);
+static int TestRemoveRemoteRunning(sched_backend_t backend);
+static int TestClearFromTask(sched_backend_t backend);
+static int TestDestroyFromTask(sched_backend_t backend);
+static int TestAddBatch(sched_backend_t backend);
+static int TestSlack(sched_backend_t backend);
+static int TestRemoteAdd(sched_backend_t backend);
+static int TestRemoteStop(sched_backend_t backend);
+static int TestWorkers(sched_backend_t backend);
+static int TestAddWithUID(sched_backend_t backend);
+static int TestMissPolicy(sched_backend_t backend);
+static int TestWatchFd(sched_backend_t backend);
+
+int main(void)
+{
+    size_t i = 0;
+    size_t j = 0;
+    int result = 0;
+    const char* backend_names[NUM_OF_BACKENDS] = { "heap", "timing wheel" };
+    const sched_backend_t backends[NUM_OF_BACKENDS] =
+                        { SCHED_BACKEND_HEAP, SCHED_BACKEND_TIMING_WHEEL };
+    const test_case_t tests[] =
+    {
+        { "order", TestOrder },
+        { "remove", TestRemove },
+        { "reschedule", TestReschedule },
+        { "stop", TestStop },
+        { "periodic timing", TestPeriodicTiming },
+        { "remove running", TestRemoveRunning },
+        { "remove from thread", TestRemoveRemoteRunning },
+        { "clear from task", TestClearFromTask },
+        { "destroy from task", TestDestroyFromTask },
+        { "add batch", TestAddBatch },
+        { "slack", TestSlack },
+        { "remote add", TestRemoteAdd },
+        { "remote stop", TestRemoteStop },
+        { "workers", TestWorkers },
+        { "add with uid", TestAddWithUID },
+        { "miss policy", TestMissPolicy },
+        { "watch fd", TestWatchFd }
+    };
+
+    for (i = 0; i < NUM_OF_BACKENDS; ++i)
+    {
+        for (j = 0; j < sizeof(tests) / sizeof(tests[0]); ++j)
+        {
+            int test_result = tests[j].test(backends[i]);
+
+            printf("%-14s %-20s %s\n", backend_names[i], tests[j].name,
+                    (0 == test_result) ? "PASSED" : "FAILED");
+            result |= test_result;
+        }
+    }
+
+    return result;
+}
+
+/*--------------------------------task actions--------------------------------*/
+static void ResetRecord(heap_scheduler_t* sched, size_t limit)
+{
+    g_record.sched = sched;
+    g_record.count = 0;
+    g_record.limit = limit;
+    g_record.self = bad_uid;
+    g_record.self_remove_result = 0;
+}
+
+static int RecordOnce(void* params)
+{
+    if (g_record.count < MAX_RECORDS)
+    {
+        g_record.order[g_record.count] = (int)(size_t)params;
+        g_record.ran_at[g_record.count] = MonoClockNow();
+    }
+
+    ++g_record.count;
+
+    return 1;
+}
+
+static int CountAndStop(void* params)
+{
+    (void)params;
+
+    if (++g_record.count == g_record.limit)
+    {
+        HeapSchedulerStop(g_record.sched);
+    }
+
+    return 0;
+}
+
+/* records when each run started, stops at @g_record.limit */
+static int TimeAndStop(void* params)
+{
+    if (g_record.count < MAX_RECORDS)
+    {
+        g_record.ran_at[g_record.count] = MonoClockNow();
+    }
+
+    return CountAndStop(params);
+}
+
+static int RemoveSelf(void* params)
+{
+    (void)params;
+
+    g_record.self_remove_result = HeapSchedulerRemove(g_record.sched,
+                                                        g_record.self);
+
+    return 1;
+}
+
+static int DestroyScheduler(void* params)
+{
+    (void)params;
+
+    HeapSchedulerDestroy(g_record.sched);
+
+    return 0;
+}
+
+static int ClearOthers(void* params)
+{
+    (void)params;
+
+    HeapSchedulerClear(g_record.sched);
+    g_record.count = HeapSchedulerSize(g_record.sched);
+
+    return 1;
+}
+
+static void* RemoteCall(void* params)
+{
+    remote_call_t* call = (remote_call_t*)params;
+
+    MonoClockSleepUntil(MonoClockNow() + call->delay_us);
+
+    if (call->is_add)
+    {
+        HeapSchedulerAdd(call->sched, CountAndStop, NULL, 5 * MS);
+    }
+    else
+    {
+        HeapSchedulerStop(call->sched);
+    }
+
+    return NULL;
+}
+
+/* removes the task @g_record.self after the delay, from this thread */
+static void* RemoteRemove(void* params)
+{
+    remote_call_t* call = (remote_call_t*)params;
+
+    MonoClockSleepUntil(MonoClockNow() + call->delay_us);
+    g_record.self_remove_result = HeapSchedulerRemove(call->sched,
+                                                        g_record.self);
+
+    return NULL;
+}
+
+static int SleepOnce(void* params)
+{
+    MonoClockSleepUntil(MonoClockNow() + (mono_time_t)(size_t)params);
+
+    return 1;
+}
+
+/* records like @CountAndStop, but the first run overruns by @params us */
+static int StallFirstRun(void* params)
+{
+    if (0 == g_record.count)
+    {
+        MonoClockSleepUntil(MonoClockNow() + (mono_time_t)(size_t)params);
+    }
+
+    if (g_record.count < MAX_RECORDS)
+    {
+        g_record.ran_at[g_record.count] = MonoClockNow();
+    }
+
+    return CountAndStop(NULL);
+}
+
+/* a periodic task whose runs take @params us, stops at @g_record.limit */
+static int SleepAndCount(void* params)
+{
+    MonoClockSleepUntil(MonoClockNow() + (mono_time_t)(size_t)params);
+
+    return CountAndStop(NULL);
+}
+
+static void* WriteToPipe(void* params)
+{
+    MonoClockSleepUntil(MonoClockNow() + (mono_time_t)(size_t)params);
+
+    if (1 != write(g_pipe[1], "x", 1))
+    {
+        HeapSchedulerStop(g_record.sched);
+    }
+
+    return NULL;
+}
+
+/* records as task number @params, then unwatches @fd and stops */
+static void ReadAndStop(int fd, unsigned int events, void* params)
+{
+    char byte = 0;
+
+    if ((0 != (events & EPOLLIN)) && (1 == read(fd, &byte, 1)))
+    {
+        RecordOnce(params);
+    }
+
+    HeapSchedulerUnwatchFd(g_record.sched, fd);
+    HeapSchedulerStop(g_record.sched);
+}
+
+/*------------------------------------tests-----------------------------------*/
+static int TestOrder(sched_backend_t backend)
+{
+    int result = 0;
+    heap_scheduler_t* sched = HeapSchedulerCreateEx(backend, 0);
+
+    ResetRecord(sched, 0);
+
+    HeapSchedulerAdd(sched, RecordOnce, (void*)3, 30 * MS);
+    HeapSchedulerAdd(sched, RecordOnce, (void*)1, 5 * MS);
+    HeapSchedulerAdd(sched, RecordOnce, (void*)2, 15 * MS);
+
+    result |= (3 != HeapSchedulerSize(sched));
+    result |= (SUCCESS != HeapSchedulerRun(sched));
+    result |= (3 != g_record.count);
+    result |= ((1 != g_record.order[0]) || (2 != g_record.order[1]) ||
+                (3 != g_record.order[2]));
+    result |= !HeapSchedulerIsEmpty(sched);
+
+    HeapSchedulerDestroy(sched);
+
+    return result;
+}
+
+static int TestRemove(sched_backend_t backend)
+{
+    int result = 0;
+    uid_t to_remove;
+    heap_scheduler_t* sched = HeapSchedulerCreateEx(backend, 0);
+
+    ResetRecord(sched, 0);
+
+    to_remove = HeapSchedulerAdd(sched, RecordOnce, (void*)1, 5 * MS);
+    HeapSchedulerAdd(sched, RecordOnce, (void*)2, 10 * MS);
+
+    result |= (0 != HeapSchedulerRemove(sched, to_remove));
+    result |= (0 == HeapSchedulerRemove(sched, to_remove));
+    result |= (0 == HeapSchedulerRemove(sched, bad_uid));
+    result |= (1 != HeapSchedulerSize(sched));
+    result |= (SUCCESS != HeapSchedulerRun(sched));
+    result |= ((1 != g_record.count) || (2 != g_record.order[0]));
+
+    HeapSchedulerDestroy(sched);
+
+    return result;
+}
+
+static int TestReschedule(sched_backend_t backend)
+{
+    int result = 0;
+    uid_t late;
+    heap_scheduler_t* sched = HeapSchedulerCreateEx(backend, 0);
+
+    ResetRecord(sched, 0);
+
+    late = HeapSchedulerAdd(sched, RecordOnce, (void*)1, 200 * MS);
+    HeapSchedulerAdd(sched, RecordOnce, (void*)2, 20 * MS);
+
+    result |= (0 != HeapSchedulerReschedule(sched, late,
+                                            MonoClockNow() + 5 * MS));
+    result |= (0 == HeapSchedulerReschedule(sched, bad_uid, 0));
+    result |= (SUCCESS != HeapSchedulerRun(sched));
+    result |= ((2 != g_record.count) || (1 != g_record.order[0]) ||
+                (2 != g_record.order[1]));
+
+    HeapSchedulerDestroy(sched);
+
+    return result;
+}
+
+static int TestStop(sched_backend_t backend)
+{
+    int result = 0;
+    heap_scheduler_t* sched = HeapSchedulerCreateEx(backend, 0);
+
+    ResetRecord(sched, 3);
+
+    HeapSchedulerAdd(sched, CountAndStop, NULL, 2 * MS);
+
+    result |= (STOPPED != HeapSchedulerRun(sched));
+    result |= (3 != g_record.count);
+    result |= (1 != HeapSchedulerSize(sched));
+
+    /* a stopped scheduler can be run again */
+    ResetRecord(sched, 2);
+    result |= (STOPPED != HeapSchedulerRun(sched));
+    result |= (2 != g_record.count);
+
+    /* a stop sent before the run isn't lost, and is consumed by it */
+    ResetRecord(sched, 2);
+    HeapSchedulerStop(sched);
+    result |= (STOPPED != HeapSchedulerRun(sched));
+    result |= (0 != g_record.count);
+    result |= (STOPPED != HeapSchedulerRun(sched));
+    result |= (2 != g_record.count);
+
+    HeapSchedulerDestroy(sched);
+
+    return result;
+}
+
+/*
+* how late each run is depends on the host, so only check what the schedule
+* fixes: no run is early, and the last deadline is still on the grid set by
+* the add, whatever the lateness of the runs before it
+*/
+static int TestPeriodicTiming(sched_backend_t backend)
+{
+    size_t i = 0;
+    int result = 0;
+    mono_time_t before_add = 0;
+    mono_time_t after_add = 0;
+    mono_time_t last_deadline = 0;
+    uid_t uid = bad_uid;
+    sched_task_stats_t stats;
+    heap_scheduler_t* sched = HeapSchedulerCreateEx(backend, 0);
+
+    ResetRecord(sched, 10);
+
+    before_add = MonoClockNow();
+    uid = HeapSchedulerAdd(sched, TimeAndStop, NULL, 10 * MS);
+    after_add = MonoClockNow();
+
+    result |= (STOPPED != HeapSchedulerRun(sched));
+    result |= (10 != g_record.count);
+
+    for (i = 0; (0 == result) && (i < g_record.count); ++i)
+    {
+        result |= (g_record.ran_at[i] < before_add + (i + 1) * 10 * MS);
+    }
+
+    /* no drift: lateness doesn't carry over to the next deadline */
+    result |= (0 != HeapSchedulerGetTaskStats(sched, uid, &stats));
+    last_deadline = g_record.ran_at[9] - stats.last_lateness_us;
+    result |= (last_deadline < before_add + 100 * MS);
+    /* a wheel tick of round up, and the time to call the action */
+    result |= (last_deadline > after_add + 100 * MS + 2 * MS);
+
+    HeapSchedulerDestroy(sched);
+
+    return result;
+}
+
+static int TestRemoveRunning(sched_backend_t backend)
+{
+    size_t num_of_workers = 0;
+    int result = 0;
+    heap_scheduler_t* sched = HeapSchedulerCreateEx(backend, 0);
+
+    /* on the loop's thread and on a worker alike */
+    for (num_of_workers = 0; num_of_workers <= 2; num_of_workers += 2)
+    {
+        result |= (0 != HeapSchedulerSetWorkers(sched, num_of_workers));
+        ResetRecord(sched, 0);
+
+        g_record.self = HeapSchedulerAdd(sched, RemoveSelf, NULL, MS);
+
+        result |= (SUCCESS != HeapSchedulerRun(sched));
+        result |= (0 == g_record.self_remove_result);
+        result |= !HeapSchedulerIsEmpty(sched);
+    }
+
+    HeapSchedulerDestroy(sched);
+
+    return result;
+}
+
+/* removed by another thread while its action runs, inline or on a worker,
+it must not run again */
+static int TestRemoveRemoteRunning(sched_backend_t backend)
+{
+    size_t num_of_workers = 0;
+    int result = 0;
+    pthread_t thread;
+    remote_call_t call;
+    heap_scheduler_t* sched = HeapSchedulerCreateEx(backend, 0);
+
+    call.sched = sched;
+    call.delay_us = 20 * MS;
+    call.is_add = 0;
+
+    for (num_of_workers = 0; num_of_workers <= 2; num_of_workers += 2)
+    {
+        result |= (0 != HeapSchedulerSetWorkers(sched, num_of_workers));
+        ResetRecord(sched, 5);
+        g_record.self = HeapSchedulerAdd(sched, SleepAndCount,
+                                            (void*)(size_t)(40 * MS), MS);
+
+        if (0 != pthread_create(&thread, NULL, RemoteRemove, &call))
+        {
+            HeapSchedulerDestroy(sched);
+            return 1;
+        }
+
+        result |= (SUCCESS != HeapSchedulerRun(sched));
+        pthread_join(thread, NULL);
+
+        result |= (0 != g_record.self_remove_result);
+        result |= (1 != g_record.count);
+        result |= !HeapSchedulerIsEmpty(sched);
+        /* gone, so a second remove doesn't find it */
+        result |= (0 == HeapSchedulerRemove(sched, g_record.self));
+    }
+
+    HeapSchedulerDestroy(sched);
+
+    return result;
+}
+
+static int TestClearFromTask(sched_backend_t backend)
+{
+    int result = 0;
+    heap_scheduler_t* sched = HeapSchedulerCreateEx(backend, 0);
+
+    ResetRecord(sched, 0);
+
+    HeapSchedulerAdd(sched, ClearOthers, NULL, MS);
+    HeapSchedulerAdd(sched, RecordOnce, (void*)1, 50 * MS);
+    HeapSchedulerAdd(sched, RecordOnce, (void*)2, 60 * MS);
+
+    result |= (SUCCESS != HeapSchedulerRun(sched));
+    result |= (0 != g_record.count);
+    result |= !HeapSchedulerIsEmpty(sched);
+
+    HeapSchedulerDestroy(sched);
+
+    return result;
+}
+
+static int TestDestroyFromTask(sched_backend_t backend)
+{
+    heap_scheduler_t* sched = HeapSchedulerCreateEx(backend, 0);
+
+    ResetRecord(sched, 0);
+
+    HeapSchedulerAdd(sched, DestroyScheduler, NULL, MS);
+    HeapSchedulerAdd(sched, RecordOnce, (void*)1, 50 * MS);
+
+    return (DESTROYED != HeapSchedulerRun(sched));
+}
+
+static int TestAddBatch(sched_backend_t backend)
+{
+    int result = 0;
+    uid_t uids[4];
+    sched_task_t batch[4] =
+    {
+        { RecordOnce, (void*)4, 40 * MS },
+        { RecordOnce, (void*)2, 20 * MS },
+        { RecordOnce, (void*)3, 30 * MS },
+        { RecordOnce, (void*)1, 10 * MS }
+    };
+    heap_scheduler_t* sched = HeapSchedulerCreateEx(backend, 0);
+
+    ResetRecord(sched, 0);
+
+    /* one task already queued, so the batch merges with it. The slack lets
+    all of them run in one batch, which still has to go by deadline */
+    HeapSchedulerSetSlack(sched, 50 * MS);
+    HeapSchedulerAdd(sched, RecordOnce, (void*)5, 50 * MS);
+
+    result |= (0 != HeapSchedulerAddBatch(sched, batch, 4, uids));
+    result |= (0 != HeapSchedulerAddBatch(sched, NULL, 0, NULL));
+    result |= (5 != HeapSchedulerSize(sched));
+
+    /* the returned uids follow the order of the batch */
+    result |= (0 != HeapSchedulerRemove(sched, uids[2]));
+    result |= (SUCCESS != HeapSchedulerRun(sched));
+    result |= ((4 != g_record.count) || (1 != g_record.order[0]) ||
+                (2 != g_record.order[1]) || (4 != g_record.order[2]) ||
+                (5 != g_record.order[3]));
+
+    HeapSchedulerDestroy(sched);
+
+    return result;
+}
+
+static int TestSlack(sched_backend_t backend)
+{
+    size_t i = 0;
+    int result = 0;
+    mono_time_t start = MonoClockNow();
+    heap_scheduler_t* sched = HeapSchedulerCreateEx(backend, 0);
+
+    ResetRecord(sched, 0);
+
+    /* with 30 ms of slack the three tasks share the first one's wakeup */
+    HeapSchedulerSetSlack(sched, 30 * MS);
+    HeapSchedulerAdd(sched, RecordOnce, (void*)1, 10 * MS);
+    HeapSchedulerAdd(sched, RecordOnce, (void*)2, 15 * MS);
+    HeapSchedulerAdd(sched, RecordOnce, (void*)3, 20 * MS);
+
+    result |= (SUCCESS != HeapSchedulerRun(sched));
+    result |= (3 != g_record.count);
+
+    for (i = 0; (0 == result) && (i < 3); ++i)
+    {
+        /* one batch, still run in deadline order */
+        result |= ((int)i + 1 != g_record.order[i]);
+        /* never early, never later than the slack allows */
+        result |= (g_record.ran_at[i] < start + (10 + 5 * i) * MS);
+        result |= (g_record.ran_at[i] > start + (40 + 5 * i) * MS +
+                    TOLERANCE_US);
+    }
+
+    result |= ((0 == result) &&
+                (g_record.ran_at[2] - g_record.ran_at[0] > 2 * MS));
+
+    HeapSchedulerDestroy(sched);
+
+    return result;
+}
+
+/* a task added from another thread runs on time, not at the next deadline */
+static int TestRemoteAdd(sched_backend_t backend)
+{
+    int result = 0;
+    mono_time_t start = MonoClockNow();
+    pthread_t thread;
+    remote_call_t call;
+    heap_scheduler_t* sched = HeapSchedulerCreateEx(backend, 0);
+
+    ResetRecord(sched, 1);
+    HeapSchedulerAdd(sched, RecordOnce, NULL, 1000 * MS);
+
+    call.sched = sched;
+    call.delay_us = 10 * MS;
+    call.is_add = 1;
+
+    if (0 != pthread_create(&thread, NULL, RemoteCall, &call))
+    {
+        HeapSchedulerDestroy(sched);
+        return 1;
+    }
+
+    result |= (STOPPED != HeapSchedulerRun(sched));
+    result |= (MonoClockNow() - start > 15 * MS + TOLERANCE_US);
+    result |= (2 != HeapSchedulerSize(sched));
+
+    pthread_join(thread, NULL);
+    HeapSchedulerDestroy(sched);
+
+    return result;
+}
+
+/* a stop from another thread ends a run that waits for a far deadline */
+static int TestRemoteStop(sched_backend_t backend)
+{
+    int result = 0;
+    mono_time_t start = MonoClockNow();
+    pthread_t thread;
+    remote_call_t call;
+    heap_scheduler_t* sched = HeapSchedulerCreateEx(backend, 0);
+
+    ResetRecord(sched, 0);
+    HeapSchedulerAdd(sched, RecordOnce, NULL, 1000 * MS);
+
+    call.sched = sched;
+    call.delay_us = 10 * MS;
+    call.is_add = 0;
+
+    if (0 != pthread_create(&thread, NULL, RemoteCall, &call))
+    {
+        HeapSchedulerDestroy(sched);
+        return 1;
+    }
+
+    result |= (STOPPED != HeapSchedulerRun(sched));
+    result |= (MonoClockNow() - start > 10 * MS + TOLERANCE_US);
+    result |= (0 != g_record.count);
+
+    pthread_join(thread, NULL);
+    HeapSchedulerDestroy(sched);
+
+    return result;
+}
+
+/* a slow action delays the next task inline, but not on a worker pool */
+static int TestWorkers(sched_backend_t backend)
+{
+    size_t num_of_workers = 0;
+    int result = 0;
+    uid_t uid = bad_uid;
+    sched_task_stats_t stats;
+    heap_scheduler_t* sched = HeapSchedulerCreateEx(backend, 0);
+
+    for (num_of_workers = 0; num_of_workers <= 2; num_of_workers += 2)
+    {
+        result |= (0 != HeapSchedulerSetWorkers(sched, num_of_workers));
+        ResetRecord(sched, 1);
+
+        HeapSchedulerAdd(sched, SleepOnce, (void*)(size_t)(40 * MS), 5 * MS);
+        uid = HeapSchedulerAdd(sched, CountAndStop, NULL, 10 * MS);
+
+        result |= (STOPPED != HeapSchedulerRun(sched));
+        result |= (0 != HeapSchedulerGetTaskStats(sched, uid, &stats));
+        result |= (1 != stats.num_of_runs);
+
+        if (0 == num_of_workers)
+        {
+            result |= (stats.last_lateness_us < 30 * MS);
+        }
+        else
+        {
+            result |= (stats.last_lateness_us > TOLERANCE_US);
+        }
+
+        HeapSchedulerRemove(sched, uid);
+    }
+
+    HeapSchedulerDestroy(sched);
+
+    return result;
+}
+
+static int TestAddWithUID(sched_backend_t backend)
+{
+    int result = 0;
+    uid_t uid = UIDCreate();
+    heap_scheduler_t* sched = HeapSchedulerCreateEx(backend, 0);
+
+    ResetRecord(sched, 0);
+
+    result |= !UIDIsSame(uid, HeapSchedulerAddWithUID(sched, uid, RecordOnce,
+                                                        (void*)1, MS));
+    /* a uid can't be used twice */
+    result |= !UIDIsSame(bad_uid, HeapSchedulerAddWithUID(sched, uid,
+                                                    RecordOnce, (void*)2, MS));
+    result |= !UIDIsSame(bad_uid, HeapSchedulerAddWithUID(sched, bad_uid,
+                                                    RecordOnce, (void*)2, MS));
+    result |= (1 != HeapSchedulerSize(sched));
+
+    result |= (SUCCESS != HeapSchedulerRun(sched));
+    result |= ((1 != g_record.count) || (1 != g_record.order[0]));
+
+    HeapSchedulerDestroy(sched);
+
+    return result;
+}
+
+/*
+* a 40 ms task whose first run, due at 40 ms, takes 140 ms. The second run
+* serves the 80 ms deadline late, and the deadlines that passed before it
+* started, 120 and 160 ms at least, are the missed ones. Catching up runs the
+* third at once for 120 ms, skipping at the next deadline of the 40 ms grid,
+* realigning one interval after the second run. How late the runs start
+* depends on the host, so the third deadline is checked, not the gaps
+*/
+static int TestMissPolicy(sched_backend_t backend)
+{
+    int result = 0;
+    size_t i = 0;
+    uid_t uid = bad_uid;
+    mono_time_t before_add = 0;
+    mono_time_t after_add = 0;
+    mono_time_t deadline = 0;
+    mono_time_t grid_offset = 0;
+    sched_task_stats_t stats;
+    const sched_miss_policy_t policies[3] = { SCHED_MISS_CATCH_UP,
+                                        SCHED_MISS_SKIP, SCHED_MISS_REALIGN };
+    heap_scheduler_t* sched = HeapSchedulerCreateEx(backend, 0);
+
+    for (i = 0; i < 3; ++i)
+    {
+        ResetRecord(sched, 3);
+
+        before_add = MonoClockNow();
+        uid = HeapSchedulerAdd(sched, StallFirstRun,
+                                (void*)(size_t)(140 * MS), 40 * MS);
+        after_add = MonoClockNow();
+        result |= (0 != HeapSchedulerSetMissPolicy(sched, uid, policies[i]));
+
+        result |= (STOPPED != HeapSchedulerRun(sched));
+        result |= (0 != HeapSchedulerGetTaskStats(sched, uid, &stats));
+
+        /* the third run's deadline, a wheel tick of round up allowed */
+        deadline = g_record.ran_at[2] - stats.last_lateness_us;
+
+        switch (policies[i])
+        {
+            case SCHED_MISS_CATCH_UP:
+                result |= (0 != stats.num_of_missed);
+                result |= (deadline < before_add + 120 * MS);
+                result |= (deadline > after_add + 120 * MS + 2 * MS);
+                break;
+
+            case SCHED_MISS_SKIP:
+                result |= (stats.num_of_missed < 2);
+                /* on the grid, and the first deadline after the overrun */
+                grid_offset = (deadline - before_add) % (40 * MS);
+                result |= (grid_offset > after_add - before_add + 2 * MS);
+                result |= (deadline < before_add +
+                                        (3 + stats.num_of_missed) * 40 * MS);
+                result |= (deadline < g_record.ran_at[0]);
+                result |= (deadline > g_record.ran_at[1] + 40 * MS + 2 * MS);
+                break;
+
+            default:
+                result |= (stats.num_of_missed < 2);
+                result |= (deadline < g_record.ran_at[0] + 40 * MS);
+                result |= (deadline > g_record.ran_at[1] + 40 * MS + 2 * MS);
+                break;
+        }
+
+        HeapSchedulerRemove(sched, uid);
+    }
+
+    HeapSchedulerDestroy(sched);
+
+    return result;
+}
+
+/*
+* with a descriptor watched, timers still fire on time and a write from
+* another thread is served at once although a far deadline is pending
+*/
+static int TestWatchFd(sched_backend_t backend)
+{
+    int result = 0;
+    mono_time_t start = MonoClockNow();
+    pthread_t thread;
+    heap_scheduler_t* sched = HeapSchedulerCreateEx(backend, 0);
+
+    if (0 != pipe(g_pipe))
+    {
+        HeapSchedulerDestroy(sched);
+        return 1;
+    }
+
+    ResetRecord(sched, 0);
+    HeapSchedulerAdd(sched, RecordOnce, (void*)1, 10 * MS);
+    HeapSchedulerAdd(sched, RecordOnce, (void*)3, 1000 * MS);
+    result |= HeapSchedulerWatchFd(sched, g_pipe[0], EPOLLIN, ReadAndStop,
+                                    (void*)2);
+    result |= (0 == HeapSchedulerWatchFd(sched, g_pipe[0], EPOLLIN,
+                                        ReadAndStop, (void*)2));
+
+    if (0 != pthread_create(&thread, NULL, WriteToPipe, (void*)(30 * MS)))
+    {
+        HeapSchedulerDestroy(sched);
+        close(g_pipe[0]);
+        close(g_pipe[1]);
+        return 1;
+    }
+
+    result |= (STOPPED != HeapSchedulerRun(sched));
+    result |= (MonoClockNow() - start > 30 * MS + TOLERANCE_US);
+    result |= (2 != g_record.count);
+    result |= (1 != g_record.order[0]) || (2 != g_record.order[1]);
+    result |= (g_record.ran_at[0] - start > 10 * MS + TOLERANCE_US);
+    /* the callback already unwatched it */
+    result |= (0 == HeapSchedulerUnwatchFd(sched, g_pipe[0]));
+    result |= (1 != HeapSchedulerSize(sched));
+
+    pthread_join(thread, NULL);
+    HeapSchedulerDestroy(sched);
+    close(g_pipe[0]);
+    close(g_pipe[1]);
+
+    return result;
+}
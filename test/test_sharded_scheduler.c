@@ -0,0 +1,249 @@
+/*
+* File name: test_sharded_scheduler.c
+* Description: Tests for the sharded scheduler: creating it, routing adds
+*              and removes to the owning shard, running and stopping the
+*              shards, and stopping shards whose run hasn't started yet.
+*/
+
+#define _POSIX_C_SOURCE (200809L)
+
+#include <stdatomic.h>      /* atomic_size_t */
+#include <stdio.h>          /* printf */
+
+#include "sharded_scheduler.h"
+#include "mono_clock.h"
+
+#define MS (MONO_USEC_PER_MSEC)
+#define NUM_OF_SHARDS (4)
+#define NUM_OF_TASKS (64)
+#define NUM_OF_RESTARTS (200)
+#define NUM_OF_BACKENDS (2)
+#define WAIT_US (2000 * MS)
+
+typedef struct test_case
+{
+    const char* name;
+    int (*test)(sched_backend_t backend);
+} test_case_t;
+
+static atomic_size_t g_num_of_runs;
+
+static int CountRun(void* params);
+static int WaitForRuns(size_t num_of_runs);
+
+static int TestCreate(sched_backend_t backend);
+static int TestRouting(sched_backend_t backend);
+static int TestRunAndStop(sched_backend_t backend);
+static int TestStopBeforeRun(sched_backend_t backend);
+
+int main(void)
+{
+    size_t i = 0;
+    size_t j = 0;
+    int result = 0;
+    const char* backend_names[NUM_OF_BACKENDS] = { "heap", "timing wheel" };
+    const sched_backend_t backends[NUM_OF_BACKENDS] =
+                        { SCHED_BACKEND_HEAP, SCHED_BACKEND_TIMING_WHEEL };
+    const test_case_t tests[] =
+    {
+        { "create", TestCreate },
+        { "routing", TestRouting },
+        { "run and stop", TestRunAndStop },
+        { "stop before run", TestStopBeforeRun }
+    };
+
+    for (i = 0; i < NUM_OF_BACKENDS; ++i)
+    {
+        for (j = 0; j < sizeof(tests) / sizeof(tests[0]); ++j)
+        {
+            int test_result = tests[j].test(backends[i]);
+
+            printf("%-14s %-20s %s\n", backend_names[i], tests[j].name,
+                    (0 == test_result) ? "PASSED" : "FAILED");
+            result |= test_result;
+        }
+    }
+
+    return result;
+}
+
+/*--------------------------------task actions--------------------------------*/
+static int CountRun(void* params)
+{
+    (void)params;
+
+    atomic_fetch_add(&g_num_of_runs, 1);
+
+    return 0;
+}
+
+/* polls, the shards run on their own threads */
+static int WaitForRuns(size_t num_of_runs)
+{
+    mono_time_t deadline = MonoClockNow() + WAIT_US;
+
+    while (atomic_load(&g_num_of_runs) < num_of_runs)
+    {
+        if (MonoClockNow() > deadline)
+        {
+            return 1;
+        }
+
+        MonoClockSleepUntil(MonoClockNow() + MS);
+    }
+
+    return 0;
+}
+
+/*------------------------------------tests-----------------------------------*/
+static int TestCreate(sched_backend_t backend)
+{
+    int result = 0;
+    size_t num_of_shards = 0;
+
+    for (num_of_shards = 1; num_of_shards <= NUM_OF_SHARDS; ++num_of_shards)
+    {
+        sharded_scheduler_t* sharded = ShardedSchedulerCreate(num_of_shards,
+                                                                backend);
+
+        if (NULL == sharded)
+        {
+            return 1;
+        }
+
+        result |= (0 != ShardedSchedulerSize(sharded));
+        /* stopping a scheduler that was never started does nothing */
+        result |= (0 != ShardedSchedulerStop(sharded));
+
+        ShardedSchedulerDestroy(sharded);
+    }
+
+    return result;
+}
+
+static int TestRouting(sched_backend_t backend)
+{
+    size_t i = 0;
+    size_t j = 0;
+    int result = 0;
+    int is_spread = 0;
+    uid_t uids[NUM_OF_TASKS];
+    sched_task_stats_t stats;
+    sharded_scheduler_t* sharded = ShardedSchedulerCreate(NUM_OF_SHARDS,
+                                                            backend);
+
+    if (NULL == sharded)
+    {
+        return 1;
+    }
+
+    for (i = 0; i < NUM_OF_TASKS; ++i)
+    {
+        uids[i] = ShardedSchedulerAdd(sharded, CountRun, NULL, 1000 * MS);
+        result |= UIDIsSame(bad_uid, uids[i]);
+    }
+
+    result |= (NUM_OF_TASKS != ShardedSchedulerSize(sharded));
+
+    for (i = 0; (0 == result) && (i < NUM_OF_TASKS); ++i)
+    {
+        heap_scheduler_t* owner = ShardedSchedulerShardOf(sharded, uids[i]);
+
+        /* the same shard every time, and the task is in it */
+        result |= (owner != ShardedSchedulerShardOf(sharded, uids[i]));
+        result |= (0 != HeapSchedulerGetTaskStats(owner, uids[i], &stats));
+        is_spread |= (owner != ShardedSchedulerShardOf(sharded, uids[0]));
+    }
+
+    result |= !is_spread;
+
+    /* removes reach the owning shard, a second remove finds nothing */
+    for (i = 0, j = NUM_OF_TASKS; (0 == result) && (i < NUM_OF_TASKS); ++i)
+    {
+        result |= (0 != ShardedSchedulerRemove(sharded, uids[i]));
+        result |= (0 == ShardedSchedulerRemove(sharded, uids[i]));
+        result |= (--j != ShardedSchedulerSize(sharded));
+    }
+
+    ShardedSchedulerDestroy(sharded);
+
+    return result;
+}
+
+static int TestRunAndStop(sched_backend_t backend)
+{
+    size_t i = 0;
+    int result = 0;
+    sharded_scheduler_t* sharded = ShardedSchedulerCreate(NUM_OF_SHARDS,
+                                                            backend);
+
+    if (NULL == sharded)
+    {
+        return 1;
+    }
+
+    atomic_store(&g_num_of_runs, 0);
+
+    /* some added before the start, some after */
+    for (i = 0; i < NUM_OF_TASKS / 2; ++i)
+    {
+        ShardedSchedulerAdd(sharded, CountRun, NULL, 5 * MS);
+    }
+
+    result |= (0 != ShardedSchedulerStart(sharded));
+
+    for (i = 0; i < NUM_OF_TASKS / 2; ++i)
+    {
+        ShardedSchedulerAdd(sharded, CountRun, NULL, 5 * MS);
+    }
+
+    result |= WaitForRuns(NUM_OF_TASKS);
+    result |= (0 != ShardedSchedulerStop(sharded));
+    /* the tasks stay for the next start */
+    result |= (NUM_OF_TASKS != ShardedSchedulerSize(sharded));
+
+    atomic_store(&g_num_of_runs, 0);
+    result |= (0 != ShardedSchedulerStart(sharded));
+    result |= WaitForRuns(NUM_OF_TASKS);
+
+    /* destroying a started scheduler stops it first */
+    ShardedSchedulerDestroy(sharded);
+
+    return result;
+}
+
+/*
+* the stop comes right after the start, mostly before the shards' threads
+* enter their run. The stop must not be lost, or the join blocks forever
+*/
+static int TestStopBeforeRun(sched_backend_t backend)
+{
+    size_t i = 0;
+    int result = 0;
+    sharded_scheduler_t* sharded = ShardedSchedulerCreate(NUM_OF_SHARDS,
+                                                            backend);
+
+    if (NULL == sharded)
+    {
+        return 1;
+    }
+
+    ShardedSchedulerAdd(sharded, CountRun, NULL, 1000 * MS);
+
+    for (i = 0; (0 == result) && (i < NUM_OF_RESTARTS); ++i)
+    {
+        result |= (0 != ShardedSchedulerStart(sharded));
+        result |= (0 != ShardedSchedulerStop(sharded));
+    }
+
+    /* no stop is left pending for a later start */
+    atomic_store(&g_num_of_runs, 0);
+    ShardedSchedulerAdd(sharded, CountRun, NULL, MS);
+    result |= (0 != ShardedSchedulerStart(sharded));
+    result |= WaitForRuns(1);
+    result |= (2 != ShardedSchedulerSize(sharded));
+
+    ShardedSchedulerDestroy(sharded);
+
+    return result;
+}
@@ -0,0 +1,201 @@
+/*
+* File name: test_shm_heartbeat.c
+* Description: Two sided test for the shared memory heartbeat. This process
+*              sets up the channel through WD_SHM_FD as the user process
+*              does, then runs itself twice as the peer: the peer inherits
+*              the descriptor over exec, must reuse it rather than open a new
+*              channel, and beats a fixed number of times before it exits.
+*              Each side beats once per tick and counts the ticks the other
+*              missed, as the watchdog does. The peer's death is found once
+*              the count passes the threshold, and only after all its beats
+*              arrived; the second peer continues the count of the first.
+*/
+
+#define _POSIX_C_SOURCE (200809L)
+
+#include <stdio.h>          /* printf, sprintf */
+#include <stdlib.h>         /* getenv, setenv, unsetenv, atoi, strtoul */
+#include <string.h>         /* strcmp, strncpy */
+#include <unistd.h>         /* fork, execl, pipe, close */
+#include <sys/wait.h>       /* waitpid */
+
+#include "shm_heartbeat.h"
+#include "watch_dog.h"      /* InitHeartbeatChannel, WD_SHM_FD_ENV_VAR_NAME */
+#include "mono_clock.h"
+
+#define TICK_US (MONO_USEC_PER_MSEC)
+#define NUM_OF_BEATS (100)
+#define NUM_OF_PEERS (2)
+#define THRESHOLD (1000)        /* ticks, leaves room for the peer's exec */
+#define PEER_ARG ("peer")
+#define FD_STR_SIZE (16)
+#define BEATS_STR_SIZE (16)
+
+static void Tick(mono_time_t* next_tick);
+static int TestChannelSetup(void);
+static int RunPeer(const char* self, shm_heartbeat_t* heartbeat,
+                    uint64_t num_of_beats);
+static int Peer(uint64_t num_of_beats);
+
+int main(int argc, char* argv[])
+{
+    size_t i = 0;
+    int result = 0;
+    shm_heartbeat_t* heartbeat = NULL;
+
+    if ((argc > 2) && (0 == strcmp(argv[1], PEER_ARG)))
+    {
+        return Peer(strtoul(argv[2], NULL, 10));
+    }
+
+    result |= TestChannelSetup();
+
+    heartbeat = ShmHeartbeatCreate(atoi(getenv(WD_SHM_FD_ENV_VAR_NAME)),
+                                    SHM_HEARTBEAT_SIDE_A);
+    result |= (NULL == heartbeat);
+
+    for (i = 0; (0 == result) && (i < NUM_OF_PEERS); ++i)
+    {
+        result |= RunPeer(argv[0], heartbeat, NUM_OF_BEATS);
+    }
+
+    ShmHeartbeatDestroy(heartbeat);
+
+    printf("shm heartbeat       %s\n", (0 == result) ? "PASSED" : "FAILED");
+
+    return result;
+}
+
+static void Tick(mono_time_t* next_tick)
+{
+    *next_tick += TICK_US;
+    MonoClockSleepUntil(*next_tick);
+}
+
+/* WD_SHM_FD naming anything but a channel gets replaced, a channel kept */
+static int TestChannelSetup(void)
+{
+    int result = 0;
+    int fds[2];
+    char fd_str[FD_STR_SIZE];
+
+    if (0 != pipe(fds))
+    {
+        return 1;
+    }
+
+    sprintf(fd_str, "%d", fds[0]);
+    setenv(WD_SHM_FD_ENV_VAR_NAME, fd_str, 1);
+
+    result |= (0 != InitHeartbeatChannel());
+    result |= (0 == strcmp(fd_str, getenv(WD_SHM_FD_ENV_VAR_NAME)));
+    close(fds[0]);
+    close(fds[1]);
+
+    strncpy(fd_str, getenv(WD_SHM_FD_ENV_VAR_NAME), FD_STR_SIZE - 1);
+    fd_str[FD_STR_SIZE - 1] = '\0';
+
+    result |= (0 != InitHeartbeatChannel());
+    result |= (0 != strcmp(fd_str, getenv(WD_SHM_FD_ENV_VAR_NAME)));
+
+    return result;
+}
+
+/* the user's side: beats, and counts the ticks without a beat from the peer */
+static int RunPeer(const char* self, shm_heartbeat_t* heartbeat,
+                    uint64_t num_of_beats)
+{
+    int result = 0;
+    int status = 0;
+    size_t num_of_missed = 0;
+    uint64_t last_peer_beats = ShmHeartbeatPeer(heartbeat);
+    uint64_t expected = last_peer_beats + num_of_beats;
+    mono_time_t next_tick = MonoClockNow();
+    char beats_str[BEATS_STR_SIZE];
+    pid_t pid = 0;
+
+    sprintf(beats_str, "%lu", (unsigned long)num_of_beats);
+    pid = fork();
+
+    if (-1 == pid)
+    {
+        return 1;
+    }
+
+    if (0 == pid)
+    {
+        execl(self, self, PEER_ARG, beats_str, (char*)NULL);
+        _exit(1);
+    }
+
+    while (num_of_missed <= THRESHOLD)
+    {
+        uint64_t peer_beats = ShmHeartbeatPeer(heartbeat);
+
+        ShmHeartbeatBeat(heartbeat);
+
+        if (peer_beats != last_peer_beats)
+        {
+            last_peer_beats = peer_beats;
+            num_of_missed = 0;
+        }
+        else
+        {
+            ++num_of_missed;
+        }
+
+        Tick(&next_tick);
+    }
+
+    result |= (pid != waitpid(pid, &status, 0));
+    result |= (!WIFEXITED(status) || (0 != WEXITSTATUS(status)));
+    /* found dead only once every beat of it arrived */
+    result |= (expected != last_peer_beats);
+
+    return result;
+}
+
+/* the watchdog's side, in a process that inherited WD_SHM_FD */
+static int Peer(uint64_t num_of_beats)
+{
+    uint64_t i = 0;
+    int result = 0;
+    uint64_t first_user_beats = 0;
+    mono_time_t next_tick = MonoClockNow();
+    char fd_str[FD_STR_SIZE];
+    shm_heartbeat_t* heartbeat = NULL;
+
+    if (NULL == getenv(WD_SHM_FD_ENV_VAR_NAME))
+    {
+        return 1;
+    }
+
+    strncpy(fd_str, getenv(WD_SHM_FD_ENV_VAR_NAME), FD_STR_SIZE - 1);
+    fd_str[FD_STR_SIZE - 1] = '\0';
+
+    /* the inherited channel is reused, not replaced */
+    result |= (0 != InitHeartbeatChannel());
+    result |= (0 != strcmp(fd_str, getenv(WD_SHM_FD_ENV_VAR_NAME)));
+
+    heartbeat = ShmHeartbeatCreate(atoi(fd_str), SHM_HEARTBEAT_SIDE_B);
+
+    if ((0 != result) || (NULL == heartbeat))
+    {
+        return 1;
+    }
+
+    first_user_beats = ShmHeartbeatPeer(heartbeat);
+
+    for (i = 0; i < num_of_beats; ++i)
+    {
+        ShmHeartbeatBeat(heartbeat);
+        Tick(&next_tick);
+    }
+
+    /* the user kept beating meanwhile */
+    result |= (ShmHeartbeatPeer(heartbeat) == first_user_beats);
+
+    ShmHeartbeatDestroy(heartbeat);
+
+    return result;
+}
@@ -0,0 +1,227 @@
+/*
+* File name: test_spawn.c
+* Description: Tests for starting the watchdog with posix_spawn. This
+*              process opens descriptors without O_CLOEXEC, ignores SIGUSR1
+*              and blocks SIGUSR2, then spawns itself in place of the
+*              watchdog executable, once in each signal mode. The child
+*              checks that it got stdio and the heartbeat page descriptor
+*              only, SIGUSR1 and SIGUSR2 at their default dispositions, and
+*              those two blocked in signalfd mode with nothing blocked
+*              otherwise. It exits with one bit set per failed check.
+*/
+
+#define _GNU_SOURCE
+
+#include <dirent.h>         /* opendir, readdir, dirfd */
+#include <fcntl.h>          /* open */
+#include <limits.h>         /* PATH_MAX */
+#include <signal.h>         /* sigaction, sigprocmask */
+#include <stdio.h>          /* printf */
+#include <stdlib.h>         /* mkdtemp, realpath, setenv, unsetenv, atoi */
+#include <string.h>         /* strcmp */
+#include <unistd.h>         /* chdir, symlink, pipe, close, unlink, rmdir */
+#include <sys/wait.h>       /* waitpid */
+
+#include "watch_dog.h"      /* SpawnWatchDog, WD_SHM_FD_ENV_VAR_NAME */
+#include "wd.h"             /* WD_FLAG_SIGNALFD */
+#include "shm_heartbeat.h"
+
+#define PROBE_ARG ("probe")
+#define PROBE_ARG_INDEX (4)     /* after the path, interval, threshold, name */
+#define EXEC_NAME ("wd_exec.out")
+#define FD_DIR_PATH ("/proc/self/fd")
+#define NUM_OF_INHERITED (4)    /* stdio and the heartbeat page */
+#define INTERVAL (1)
+#define THRESHOLD (5)
+
+enum probe_failures
+{
+    PROBE_EXTRA_FD = 1 << 0,
+    PROBE_MISSING_FD = 1 << 1,
+    PROBE_SHM_FD = 1 << 2,
+    PROBE_DISPOSITION = 1 << 3,
+    PROBE_MASK = 1 << 4
+};
+
+static int Probe(void);
+static int ProbeFds(void);
+static int ProbeSignals(void);
+static int SpawnAndWait(const char* flags);
+
+int main(int argc, char* argv[])
+{
+    int result = 0;
+    int fds[2] = { -1, -1 };
+    int null_fd = -1;
+    char dir[] = "/tmp/test_spawn_XXXXXX";
+    char self[PATH_MAX];
+    char* probe_argv[] = { "test_spawn", PROBE_ARG, NULL };
+    sigset_t set;
+
+    if ((argc > PROBE_ARG_INDEX) &&
+        (0 == strcmp(argv[PROBE_ARG_INDEX], PROBE_ARG)))
+    {
+        return Probe();
+    }
+
+    /* the watchdog is started from the working directory */
+    if ((NULL == realpath("/proc/self/exe", self)) || (NULL == mkdtemp(dir)) ||
+        (0 != chdir(dir)) || (0 != symlink(self, EXEC_NAME)))
+    {
+        printf("spawn               FAILED\n");
+        return 1;
+    }
+
+    unsetenv(WD_SHM_FD_ENV_VAR_NAME);
+    result |= (0 != InitHeartbeatChannel());
+
+    /* left to the child unless the spawn closes them */
+    result |= (0 != pipe(fds));
+    null_fd = open("/dev/null", O_RDONLY);
+    result |= (-1 == null_fd);
+
+    /* an ignored signal stays ignored over exec, a blocked one blocked */
+    signal(SIGUSR1, SIG_IGN);
+    sigemptyset(&set);
+    sigaddset(&set, SIGUSR2);
+    sigprocmask(SIG_BLOCK, &set, NULL);
+
+    result |= (0 != InitParams(THRESHOLD, INTERVAL, 2, probe_argv));
+    result |= SpawnAndWait(NULL);
+    result |= SpawnAndWait("1");
+
+    printf("spawn               %s\n", (0 == result) ? "PASSED" : "FAILED");
+
+    close(fds[0]);
+    close(fds[1]);
+    close(null_fd);
+    unlink(EXEC_NAME);
+    chdir("/");
+    rmdir(dir);
+
+    return result;
+}
+
+/* @flags: the WD_FLAGS value the child runs with, NULL for none */
+static int SpawnAndWait(const char* flags)
+{
+    int status = 0;
+    pid_t pid = -1;
+
+    if (NULL == flags)
+    {
+        unsetenv(WD_FLAGS_ENV_VAR_NAME);
+    }
+    else
+    {
+        setenv(WD_FLAGS_ENV_VAR_NAME, flags, 1);
+    }
+
+    pid = SpawnWatchDog();
+
+    if ((-1 == pid) || (pid != waitpid(pid, &status, 0)))
+    {
+        return 1;
+    }
+
+    if (!WIFEXITED(status) || (0 != WEXITSTATUS(status)))
+    {
+        printf("spawn probe with WD_FLAGS=%s failed: %d\n",
+                (NULL == flags) ? "" : flags, WEXITSTATUS(status));
+        return 1;
+    }
+
+    return 0;
+}
+
+/*--------------------------------the child-----------------------------------*/
+static int Probe(void)
+{
+    return ProbeFds() | ProbeSignals();
+}
+
+static int ProbeFds(void)
+{
+    int fd = -1;
+    int result = 0;
+    size_t num_of_fds = 0;
+    const char* fd_as_str = getenv(WD_SHM_FD_ENV_VAR_NAME);
+    shm_heartbeat_t* heartbeat = NULL;
+    struct dirent* entry = NULL;
+    DIR* dir = opendir(FD_DIR_PATH);
+
+    if (NULL == dir)
+    {
+        return PROBE_MISSING_FD;
+    }
+
+    while (NULL != (entry = readdir(dir)))
+    {
+        if ('.' == entry->d_name[0])
+        {
+            continue;
+        }
+
+        fd = atoi(entry->d_name);
+
+        if (fd == dirfd(dir))
+        {
+            continue;
+        }
+
+        if (fd >= NUM_OF_INHERITED)
+        {
+            result |= PROBE_EXTRA_FD;
+        }
+
+        ++num_of_fds;
+    }
+
+    closedir(dir);
+
+    if (NUM_OF_INHERITED != num_of_fds)
+    {
+        result |= PROBE_MISSING_FD;
+    }
+
+    /* the page is at a fixed descriptor, whatever its number in the parent */
+    if ((NULL == fd_as_str) || (0 != strcmp("3", fd_as_str)))
+    {
+        return result | PROBE_SHM_FD;
+    }
+
+    heartbeat = ShmHeartbeatCreate(atoi(fd_as_str), SHM_HEARTBEAT_SIDE_B);
+
+    if (NULL == heartbeat)
+    {
+        return result | PROBE_SHM_FD;
+    }
+
+    ShmHeartbeatDestroy(heartbeat);
+
+    return result;
+}
+
+static int ProbeSignals(void)
+{
+    int result = 0;
+    int is_blocked = (0 != (GetFlags() & WD_FLAG_SIGNALFD));
+    struct sigaction act;
+    sigset_t mask;
+
+    sigaction(SIGUSR1, NULL, &act);
+    result |= (SIG_DFL != act.sa_handler);
+    sigaction(SIGUSR2, NULL, &act);
+    result |= (SIG_DFL != act.sa_handler);
+    result = result ? PROBE_DISPOSITION : 0;
+
+    sigprocmask(SIG_SETMASK, NULL, &mask);
+
+    if ((is_blocked != sigismember(&mask, SIGUSR1)) ||
+        (is_blocked != sigismember(&mask, SIGUSR2)))
+    {
+        result |= PROBE_MASK;
+    }
+
+    return result;
+}
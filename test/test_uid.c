@@ -0,0 +1,261 @@
+/*
+* File name: test_uid.c
+* Description: Tests for the uid encodings and hash. The string and byte
+*              forms have to round trip and reject malformed input, and the
+*              hash has to spread sequential uids evenly over the low bits
+*              (uid_map slots) and over the high bits (scheduler shards).
+*/
+
+#include <stdio.h>          /* printf */
+#include <stdlib.h>         /* malloc, free, qsort */
+#include <string.h>         /* strcmp, strlen, memcmp, memset */
+
+#include "uid.h"
+
+#define NUM_OF_HASHED (1 << 16)
+#define NUM_OF_SLOTS (1024)
+#define MAX_SHARDS (16)
+/* the statistic sits within a few deviations of its mean for an even spread */
+#define MAX_DEVIATIONS (6)
+
+static int TestKnownValue(void);
+static int TestStringRoundTrip(void);
+static int TestMalformedString(void);
+static int TestBytesRoundTrip(void);
+static int TestHashSpread(void);
+
+static uid_t MakeUID(uint64_t hi, uint64_t lo);
+static int IsSpread(const size_t* counts, size_t num_of_buckets,
+                    size_t num_of_items);
+static int CompareHashes(const void* a, const void* b);
+
+int main(void)
+{
+    int result = 0;
+
+    result |= TestKnownValue();
+    result |= TestStringRoundTrip();
+    result |= TestMalformedString();
+    result |= TestBytesRoundTrip();
+    result |= TestHashSpread();
+
+    printf("uid %s\n", (0 == result) ? "PASSED" : "FAILED");
+
+    return result;
+}
+
+static uid_t MakeUID(uint64_t hi, uint64_t lo)
+{
+    uid_t uid;
+
+    uid.hi = hi;
+    uid.lo = lo;
+
+    return uid;
+}
+
+/* both forms are big endian, @hi first */
+static int TestKnownValue(void)
+{
+    int result = 0;
+    char str[UID_STR_SIZE];
+    unsigned char bytes[UID_BIN_SIZE];
+    const unsigned char expected[UID_BIN_SIZE] =
+    {
+        0x01, 0x23, 0x45, 0x67, 0x89, 0xAB, 0xCD, 0xEF,
+        0xFE, 0xDC, 0xBA, 0x98, 0x76, 0x54, 0x32, 0x10
+    };
+    uid_t uid = MakeUID(UINT64_C(0x0123456789ABCDEF),
+                        UINT64_C(0xFEDCBA9876543210));
+
+    UIDToString(uid, str);
+    result |= (0 != strcmp(str, "0123456789abcdeffedcba9876543210"));
+
+    UIDToBytes(uid, bytes);
+    result |= (0 != memcmp(bytes, expected, UID_BIN_SIZE));
+
+    return result;
+}
+
+static int TestStringRoundTrip(void)
+{
+    size_t i = 0;
+    size_t j = 0;
+    int result = 0;
+    char str[UID_STR_SIZE];
+    uid_t decoded;
+    const uid_t uids[4] =
+    {
+        { 0, 0 },
+        { UINT64_MAX, UINT64_MAX },
+        { UINT64_C(0x00000000FFFFFFFF), UINT64_C(0xFFFFFFFF00000000) },
+        { UINT64_C(0xA5A5A5A55A5A5A5A), 1 }
+    };
+
+    for (i = 0; i < 5; ++i)
+    {
+        uid_t uid = (i < 4) ? uids[i] : UIDCreate();
+
+        UIDToString(uid, str);
+        result |= (UID_STR_SIZE - 1 != strlen(str));
+        result |= (0 != UIDFromString(str, &decoded));
+        result |= !UIDIsSame(uid, decoded);
+
+        /* the encoding is lowercase, decoding takes either case */
+        for (j = 0; j < UID_STR_SIZE - 1; ++j)
+        {
+            result |= ((str[j] >= 'A') && (str[j] <= 'F'));
+
+            if ((str[j] >= 'a') && (str[j] <= 'f'))
+            {
+                str[j] = (char)(str[j] - 'a' + 'A');
+            }
+        }
+
+        decoded = bad_uid;
+        result |= (0 != UIDFromString(str, &decoded));
+        result |= !UIDIsSame(uid, decoded);
+    }
+
+    return result;
+}
+
+static int TestMalformedString(void)
+{
+    size_t i = 0;
+    int result = 0;
+    char str[UID_STR_SIZE + 1];
+    const char* valid = "0123456789abcdeffedcba9876543210";
+    const size_t bad_at[4] = { 0, 15, 16, 31 };
+    const char bad_chars[4] = { 'g', 'G', ' ', '-' };
+    const uid_t untouched = MakeUID(7, 7);
+    uid_t decoded = untouched;
+
+    /* a bad digit in either half, at either end of it */
+    for (i = 0; i < 4; ++i)
+    {
+        memcpy(str, valid, UID_STR_SIZE);
+        str[bad_at[i]] = bad_chars[i];
+        result |= (0 == UIDFromString(str, &decoded));
+    }
+
+    /* too short in the first half, in the second half, and too long */
+    result |= (0 == UIDFromString("", &decoded));
+    result |= (0 == UIDFromString("0123456789abcde", &decoded));
+    result |= (0 == UIDFromString("0123456789abcdeffedcba987654321",
+                                    &decoded));
+    memcpy(str, valid, UID_STR_SIZE);
+    str[UID_STR_SIZE - 1] = '0';
+    str[UID_STR_SIZE] = '\0';
+    result |= (0 == UIDFromString(str, &decoded));
+
+    /* a failed decode leaves the output alone */
+    result |= !UIDIsSame(untouched, decoded);
+
+    return result;
+}
+
+static int TestBytesRoundTrip(void)
+{
+    size_t i = 0;
+    int result = 0;
+    unsigned char bytes[UID_BIN_SIZE + 1];
+    uid_t uid = bad_uid;
+
+    for (i = 0; i < 4; ++i)
+    {
+        uid = (0 == i) ? UIDCreate() : MakeUID(UINT64_MAX / i, i);
+
+        /* a byte past the encoding is not part of it */
+        bytes[UID_BIN_SIZE] = (unsigned char)(0xA0 + i);
+        UIDToBytes(uid, bytes);
+
+        result |= (bytes[UID_BIN_SIZE] != (unsigned char)(0xA0 + i));
+        result |= !UIDIsSame(uid, UIDFromBytes(bytes));
+    }
+
+    return result;
+}
+
+/* chi square of @counts against an even spread of @num_of_items */
+static int IsSpread(const size_t* counts, size_t num_of_buckets,
+                    size_t num_of_items)
+{
+    size_t i = 0;
+    double chi_square = 0;
+    double expected = (double)num_of_items / (double)num_of_buckets;
+    double degrees = (double)(num_of_buckets - 1);
+
+    for (i = 0; i < num_of_buckets; ++i)
+    {
+        double diff = (double)counts[i] - expected;
+
+        chi_square += diff * diff / expected;
+    }
+
+    /* deviation of chi square is sqrt(2 * degrees), compared squared */
+    return ((chi_square <= degrees) ||
+            ((chi_square - degrees) * (chi_square - degrees) <=
+            MAX_DEVIATIONS * MAX_DEVIATIONS * 2 * degrees));
+}
+
+static int CompareHashes(const void* a, const void* b)
+{
+    uint64_t lhs = *(const uint64_t*)a;
+    uint64_t rhs = *(const uint64_t*)b;
+
+    return (lhs > rhs) - (lhs < rhs);
+}
+
+/*
+* uids of one process in one second differ only in the counter, which is the
+* worst case: the low bits pick a uid_map slot, the high 32 bits a shard
+*/
+static int TestHashSpread(void)
+{
+    size_t i = 0;
+    size_t num_of_shards = 0;
+    int result = 0;
+    size_t slots[NUM_OF_SLOTS] = { 0 };
+    size_t shards[MAX_SHARDS] = { 0 };
+    uint64_t* hashes = (uint64_t*)malloc(NUM_OF_HASHED * sizeof(uint64_t));
+    uid_t uid = MakeUID(UINT64_C(0x5EED000000001234),
+                        UINT64_C(0x6700000000000000));
+
+    if (NULL == hashes)
+    {
+        return 1;
+    }
+
+    for (i = 0; i < NUM_OF_HASHED; ++i)
+    {
+        hashes[i] = UIDHash(MakeUID(uid.hi, uid.lo + i));
+        ++slots[hashes[i] & (NUM_OF_SLOTS - 1)];
+    }
+
+    result |= !IsSpread(slots, NUM_OF_SLOTS, NUM_OF_HASHED);
+
+    for (num_of_shards = 2; num_of_shards <= MAX_SHARDS; ++num_of_shards)
+    {
+        memset(shards, 0, sizeof(shards));
+
+        for (i = 0; i < NUM_OF_HASHED; ++i)
+        {
+            ++shards[(hashes[i] >> 32) % num_of_shards];
+        }
+
+        result |= !IsSpread(shards, num_of_shards, NUM_OF_HASHED);
+    }
+
+    /* and no two of them collide in the full 64 bits */
+    qsort(hashes, NUM_OF_HASHED, sizeof(uint64_t), CompareHashes);
+
+    for (i = 1; i < NUM_OF_HASHED; ++i)
+    {
+        result |= (hashes[i - 1] == hashes[i]);
+    }
+
+    free(hashes);
+
+    return result;
+}
@@ -0,0 +1,136 @@
+/*
+* File name: fr_decode.c
+* Description: Prints the records of a watchdog flight recorder file, oldest
+*              first, with their wall clock time, their offset from the
+*              newest record, the recording pid, the event and its counter.
+*              Usage: fr_decode.out [file] [count]
+*/
+
+#define _POSIX_C_SOURCE (200809L)
+
+#include <stdio.h>          /* printf, fopen, fread */
+#include <stdlib.h>         /* malloc, free, strtoul */
+#include <time.h>           /* localtime_r, strftime */
+
+#include "flight_recorder.h"
+#include "watch_dog.h"      /* wd_event_t */
+
+#define DEFAULT_PATH ("./wd_flight.bin")
+#define TIME_STR_SIZE (32)
+#define USEC_PER_SEC (1000000)
+#define USEC_PER_MSEC (1000)
+
+static const char* EventName(unsigned int event);
+static void PrintRecord(const fr_record_t* record, uint64_t index,
+                        int64_t mono_to_real_us, uint64_t newest_us);
+
+int main(int argc, char* argv[])
+{
+    const char* path = (argc > 1) ? argv[1] : DEFAULT_PATH;
+    uint64_t count = 0;
+    uint64_t first = 0;
+    uint64_t i = 0;
+    fr_file_header_t header;
+    fr_record_t* records = NULL;
+    FILE* fp = fopen(path, "rb");
+
+    if (NULL == fp)
+    {
+        printf("cannot open %s\n", path);
+        return 1;
+    }
+
+    if ((1 != fread(&header, sizeof(header), 1, fp)) ||
+        (FR_MAGIC != header.magic) || (FR_VERSION != header.version) ||
+        (sizeof(fr_record_t) != header.record_size) || (0 == header.capacity))
+    {
+        printf("%s is not a flight recorder file of version %d\n", path,
+                FR_VERSION);
+        fclose(fp);
+        return 1;
+    }
+
+    records = (fr_record_t*)malloc(header.capacity * sizeof(fr_record_t));
+
+    if ((NULL == records) ||
+        (header.capacity != fread(records, sizeof(fr_record_t),
+                                    header.capacity, fp)))
+    {
+        printf("%s is truncated\n", path);
+        free(records);
+        fclose(fp);
+        return 1;
+    }
+
+    fclose(fp);
+
+    /* the ring holds the last capacity records claimed */
+    count = (header.next < header.capacity) ? header.next : header.capacity;
+
+    if ((argc > 2) && (strtoul(argv[2], NULL, 10) < count))
+    {
+        count = strtoul(argv[2], NULL, 10);
+    }
+
+    first = header.next - count;
+
+    printf("%lu records, showing the last %lu\n",
+            (unsigned long)header.next, (unsigned long)count);
+
+    for (i = first; i < header.next; ++i)
+    {
+        PrintRecord(&records[i % header.capacity], i, header.mono_to_real_us,
+                    records[(header.next - 1) % header.capacity].time_us);
+    }
+
+    free(records);
+
+    return 0;
+}
+
+static const char* EventName(unsigned int event)
+{
+    static const char* names[WD_NUM_OF_EVENTS] =
+    {
+        "?",
+        "start",
+        "beat sent",
+        "beat received",
+        "threshold",
+        "restart watchdog",
+        "restart user",
+        "stop requested",
+        "stop",
+        "peer exited"
+    };
+
+    return (event < WD_NUM_OF_EVENTS) ? names[event] : "?";
+}
+
+static void PrintRecord(const fr_record_t* record, uint64_t index,
+                        int64_t mono_to_real_us, uint64_t newest_us)
+{
+    char time_str[TIME_STR_SIZE] = "-";
+    int64_t real_us = (int64_t)record->time_us + mono_to_real_us;
+    time_t seconds = (time_t)(real_us / USEC_PER_SEC);
+    struct tm local;
+
+    /* claimed, but the process died before storing it */
+    if (0 == record->time_us)
+    {
+        printf("%8lu  (empty)\n", (unsigned long)index);
+        return;
+    }
+
+    if (NULL != localtime_r(&seconds, &local))
+    {
+        strftime(time_str, sizeof(time_str), "%Y-%m-%d %H:%M:%S", &local);
+    }
+
+    printf("%8lu  %s.%06ld  %+12.3f ms  pid %-7u  %-16s  %u\n",
+            (unsigned long)index, time_str, (long)(real_us % USEC_PER_SEC),
+            (double)((int64_t)record->time_us - (int64_t)newest_us) /
+            USEC_PER_MSEC,
+            FR_RECORD_PID(record), EventName(FR_RECORD_EVENT(record)),
+            FR_RECORD_COUNTER(record));
+}